@@ -1,6 +1,8 @@
+import { FloatArray, IntArray } from './arrays';
 import type { NavMesh } from './nav-mesh';
 import { NavMeshQuery, QueryFilter } from './nav-mesh-query';
 import { Raw, type RawModule } from './raw';
+import { createNavMeshExport, readNavMeshExport } from './serdes/navmesh-export';
 import { type Vector3, vec3 } from './utils';
 
 export type CrowdAgentParams = {
@@ -247,6 +249,8 @@ export class CrowdAgent implements CrowdAgentParams {
       this.crowd.navMeshQuery.defaultFilter.raw,
     );
 
+    this.crowd.resetInterpolation(this.agentIndex);
+
     vec3.copy(position, this.interpolatedPosition);
   }
 
@@ -424,6 +428,226 @@ export class CrowdAgent implements CrowdAgentParams {
   }
 }
 
+/**
+ * The number of floats per agent in `CrowdAgentStates.states`:
+ * `[x, y, z, vx, vy, vz, dvx, dvy, dvz, state, targetState, cornerX, cornerY, cornerZ]`
+ */
+export const crowdAgentStateStride = 14;
+
+export type CrowdAgentStates = {
+  /**
+   * The number of active agents
+   */
+  count: number;
+
+  /**
+   * The agent index of each active agent
+   */
+  indices: Int32Array;
+
+  /**
+   * Position, velocity, desired velocity, state, target state and next corner of each active agent, see `crowdAgentStateStride`.
+   * The next corner is the agent position if the agent has no corners.
+   */
+  states: Float32Array;
+};
+
+/**
+ * Flags for `CrowdAgentParams.updateFlags`
+ */
+export const CrowdUpdateFlags = {
+  ANTICIPATE_TURNS: 1,
+  OBSTACLE_AVOIDANCE: 2,
+  SEPARATION: 4,
+  OPTIMIZE_VIS: 8,
+  OPTIMIZE_TOPO: 16,
+} as const;
+
+/**
+ * The maximum number of crowd level of detail tiers
+ */
+export const crowdMaxLodTiers = 4;
+
+export type CrowdLodTier = {
+  /**
+   * Agents in the tier get a full update every `updateInterval` crowd updates, staggered by agent index.
+   * In between they steer straight at their next corner, skipping neighbours, separation, avoidance and path optimization.
+   * [Limit: >= 1]
+   */
+  updateInterval: number;
+
+  /**
+   * `CrowdUpdateFlags` disabled for agents in the tier, e.g. `ANTICIPATE_TURNS` for straight line steering.
+   */
+  disabledUpdateFlags: number;
+
+  /**
+   * Whether agents in the tier resolve collisions with their neighbours.
+   */
+  collision: boolean;
+};
+
+/**
+ * Phases of a large crowd engine update, see `Crowd.getUpdateProfile`
+ */
+export const CrowdUpdatePhase = {
+  /**
+   * Counts replans requested for agents with invalid corridors
+   */
+  PATH_VALIDITY: 0,
+
+  /**
+   * Counts A* iterations run by the path queue
+   */
+  PATH_QUEUE: 1,
+
+  /**
+   * Counts corridors optimized
+   */
+  TOPOLOGY: 2,
+
+  /**
+   * Counts neighbour pairs, includes building the neighbour grid and boundary queries
+   */
+  NEIGHBOURS: 3,
+
+  /**
+   * Counts active agents
+   */
+  CORNERS: 4,
+
+  /**
+   * Counts active agents, includes triggering off-mesh connections
+   */
+  STEERING: 5,
+
+  /**
+   * Counts obstacle avoidance velocity samples
+   */
+  AVOIDANCE: 6,
+
+  /**
+   * Counts active agents
+   */
+  INTEGRATE: 7,
+
+  /**
+   * Counts collision resolution passes
+   */
+  COLLISION: 8,
+
+  /**
+   * Counts active agents, includes off-mesh connection animations
+   */
+  MOVE: 9,
+
+  /**
+   * Counts updates
+   */
+  TOTAL: 10,
+} as const;
+
+export const crowdUpdatePhaseCount = 11;
+
+/**
+ * The number of floats per phase in `Crowd.getUpdateProfile`: `[time, count]`
+ */
+export const crowdUpdateProfileStride = 2;
+
+export type CrowdUpdatePhaseProfile = {
+  /**
+   * Wall time in milliseconds
+   */
+  time: number;
+
+  /**
+   * The work done in the phase, see `CrowdUpdatePhase`
+   */
+  count: number;
+};
+
+export type CrowdPathQueueParams = {
+  /**
+   * The number of path requests in flight, and the most requests started per update.
+   * [Limit: >= 1]
+   * @default 8
+   */
+  capacity: number;
+
+  /**
+   * The A* iterations per update, shared by the requests in flight.
+   * [Limit: >= 1]
+   * @default 100
+   */
+  maxIterations: number;
+
+  /**
+   * The search nodes of the path queue's query, limiting the area a request can explore.
+   * [Limit: 1 <= value <= 65535]
+   * @default 4096
+   */
+  maxSearchNodes: number;
+
+  /**
+   * The polygons in a path result. Values above the 256 polygons of an agent corridor are capped.
+   * [Limit: >= 1]
+   * @default 256
+   */
+  maxPathResult: number;
+
+  /**
+   * Seconds an agent with a valid target waits before replanning a corridor that ends short of the target.
+   * @default 1
+   */
+  replanDelay: number;
+
+  /**
+   * Seconds between corridor topology optimizations of an agent.
+   * @default 0.5
+   */
+  topologyOptimizationDelay: number;
+};
+
+/**
+ * Path queue counters of the last large crowd engine update, see `Crowd.getPathQueueStats`
+ */
+export type CrowdPathQueueStats = {
+  /**
+   * Agents waiting for a slot in the queue or for their path, after the update
+   */
+  queueDepth: number;
+
+  /**
+   * Queue slots in use after the update
+   */
+  activeRequests: number;
+
+  /**
+   * Requests added to the queue
+   */
+  startedRequests: number;
+
+  /**
+   * Requests whose result was read, successful or failed
+   */
+  completedRequests: number;
+
+  /**
+   * A* iterations run
+   */
+  iterations: number;
+
+  /**
+   * The longest time an agent still waiting has waited, in seconds
+   */
+  maxWaitTime: number;
+
+  /**
+   * The mean time from queueing to result of the completed requests, in seconds
+   */
+  averageWaitTime: number;
+};
+
 export type CrowdParams = {
   /**
    * The maximum number of agents that can be managed by the crowd.
@@ -436,6 +660,32 @@ export type CrowdParams = {
    * [Limit: > 0]
    */
   maxAgentRadius: number;
+
+  /**
+   * The number of threads to update the crowd with, including the calling thread. 0 uses every available core.
+   *
+   * If `threads`, `gridCellSize` or `pathQueue` is set, the crowd is updated by a native large crowd engine in place of `dtCrowd::update`.
+   * The engine reads hot agent state from contiguous arrays, and splits per agent work across a worker pool.
+   * Results do not depend on the number of threads.
+   * Only the `@recast-navigation/wasm/wasm-threads` build starts worker threads, other builds update on the calling thread.
+   * Crowds and generators share the build's 8 prewarmed worker threads, so fewer threads are used while others hold them.
+   * @default undefined, or 1 if only `gridCellSize` or `pathQueue` is set
+   */
+  threads?: number;
+
+  /**
+   * The cell size of the large crowd engine's neighbour grid, see `threads`.
+   * Cells around the collision query range of agents keep the number of agents tested per neighbour query low.
+   * [Limit: >= maxAgentRadius, smaller sizes are clamped]
+   * @default maxAgentRadius * 3
+   */
+  gridCellSize?: number;
+
+  /**
+   * The path queue budget and replan intervals of the large crowd engine, see `threads`.
+   * Defaults match `dtCrowd`, whose path queue is fixed.
+   */
+  pathQueue?: Partial<CrowdPathQueueParams>;
 };
 
 export class Crowd {
@@ -457,9 +707,26 @@ export class Crowd {
   navMeshQuery: NavMeshQuery;
 
   /**
-   * Accumulator for fixed updates with interpolation
+   * Fixed stepper with interpolation, created on the first interpolated update
+   */
+  private stepper?: RawModule.CrowdStepper;
+
+  /**
+   * Large crowd engine, created if the crowd has a thread count or grid cell size
    */
-  private accumulator = 0;
+  private updater?: RawModule.CrowdUpdater;
+
+  private agentStates?: FloatArray;
+
+  private agentIndices?: IntArray;
+
+  private commandIndices?: IntArray;
+
+  private commandVectors?: FloatArray;
+
+  private lodDistances?: FloatArray;
+
+  private updateProfile?: FloatArray;
 
   /**
    *
@@ -474,7 +741,16 @@ export class Crowd {
    * });
    * ```
    */
-  constructor(navMesh: NavMesh, { maxAgents, maxAgentRadius }: CrowdParams) {
+  constructor(
+    navMesh: NavMesh,
+    {
+      maxAgents,
+      maxAgentRadius,
+      threads,
+      gridCellSize,
+      pathQueue,
+    }: CrowdParams,
+  ) {
     this.navMesh = navMesh;
     this.raw = Raw.Detour.allocCrowd();
     this.raw.init(maxAgents, maxAgentRadius, navMesh.raw.getNavMesh());
@@ -482,6 +758,37 @@ export class Crowd {
     this.navMeshQuery = new NavMeshQuery(
       new Raw.Module.NavMeshQuery(this.raw.getNavMeshQuery()),
     );
+
+    if (
+      threads !== undefined ||
+      gridCellSize !== undefined ||
+      pathQueue !== undefined
+    ) {
+      this.updater = new Raw.Module.CrowdUpdater();
+
+      if (!this.updater.init(navMesh.raw, this.raw, threads ?? 1)) {
+        Raw.destroy(this.updater);
+        this.updater = undefined;
+        this.destroy();
+        throw new Error('Failed to initialize CrowdUpdater');
+      }
+
+      if (gridCellSize !== undefined) {
+        this.updater.setGridCellSize(gridCellSize);
+      }
+
+      if (pathQueue !== undefined && !this.setPathQueueParams(pathQueue)) {
+        this.destroy();
+        throw new Error('Invalid crowd path queue params');
+      }
+    }
+  }
+
+  /**
+   * The number of threads the crowd is updated with, 1 if the crowd does not use the large crowd engine.
+   */
+  get threadCount(): number {
+    return this.updater?.getThreadCount() ?? 1;
   }
 
   /**
@@ -516,32 +823,53 @@ export class Crowd {
   update(dt: number, timeSinceLastCalled?: number, maxSubSteps: number = 10) {
     if (timeSinceLastCalled === undefined) {
       // fixed step
-      this.raw.update(dt, undefined!);
-    } else {
-      this.accumulator += timeSinceLastCalled;
-
-      // Do fixed steps to catch up
-      let substeps = 0;
-      while (this.accumulator >= dt && substeps < maxSubSteps) {
+      if (this.updater) {
+        this.updater.update(dt);
+      } else {
         this.raw.update(dt, undefined!);
-        this.accumulator -= dt;
-        substeps++;
+      }
+    } else {
+      // fixed steps with interpolation, the accumulator and position buffers are native
+      if (!this.stepper) {
+        this.stepper = new Raw.Module.CrowdStepper();
+        this.stepper.init(this.raw, dt, maxSubSteps);
+
+        if (this.updater) {
+          this.stepper.setUpdater(this.updater);
+        }
+      } else {
+        this.stepper.setFixedStep(dt);
+        this.stepper.setMaxSubSteps(maxSubSteps);
       }
 
-      // Interpolate the agent positions
-      const t = (this.accumulator % dt) / dt;
-      const agents = this.getAgents();
-      for (const agent of agents) {
-        vec3.lerp(
-          agent.interpolatedPosition,
-          agent.position(),
-          t,
-          agent.interpolatedPosition,
-        );
+      this.stepper.step(timeSinceLastCalled);
+
+      const positions = this.getInterpolatedPositions()!;
+      for (const agent of this.getAgents()) {
+        const offset = agent.agentIndex * 3;
+        agent.interpolatedPosition.x = positions[offset];
+        agent.interpolatedPosition.y = positions[offset + 1];
+        agent.interpolatedPosition.z = positions[offset + 2];
       }
     }
   }
 
+  /**
+   * Returns the interpolated positions of all agents, `[x, y, z, ...]` indexed by agent index.
+   *
+   * Positions are interpolated between the last two fixed steps when stepping with interpolation, see `update`.
+   * Returns undefined if the crowd has not been stepped with interpolation.
+   *
+   * The returned array is a view into the wasm heap, valid until the wasm heap grows.
+   */
+  getInterpolatedPositions(): Float32Array | undefined {
+    if (!this.stepper) return undefined;
+
+    return FloatArray.fromRaw(
+      this.stepper.getInterpolatedPositions(),
+    ).getHeapView();
+  }
+
   /**
    * Adds a new agent to the crowd.
    */
@@ -572,6 +900,11 @@ export class Crowd {
       dtCrowdAgentParams,
     );
 
+    this.resetInterpolation(agentIndex);
+
+    // the slot may have been freed since the last update, before the updater reset its tier
+    this.updater?.setAgentLodTier(agentIndex, 0);
+
     const agent = new CrowdAgent(this, agentIndex);
     this.agents[agentIndex] = agent;
 
@@ -618,6 +951,430 @@ export class Crowd {
     return Raw.CrowdUtils.getActiveAgentCount(this.raw);
   }
 
+  /**
+   * Reads the state of every active agent in one call.
+   *
+   * The returned arrays are views into the wasm heap, valid until the next call to `getActiveAgentStates` or until the wasm heap grows.
+   * Copy them with `.slice()` if they need to be kept.
+   *
+   * @example
+   * ```ts
+   * const { count, indices, states } = crowd.getActiveAgentStates();
+   *
+   * for (let i = 0; i < count; i++) {
+   *   const offset = i * crowdAgentStateStride;
+   *   const x = states[offset];
+   *   const y = states[offset + 1];
+   *   const z = states[offset + 2];
+   *
+   *   renderer.setPosition(indices[i], x, y, z);
+   * }
+   * ```
+   */
+  getActiveAgentStates(): CrowdAgentStates {
+    this.agentStates ??= new FloatArray();
+    this.agentIndices ??= new IntArray();
+
+    const count = Raw.CrowdUtils.getActiveAgentStates(
+      this.raw,
+      this.agentStates.raw,
+      this.agentIndices.raw,
+    );
+
+    return {
+      count,
+      indices: this.agentIndices.getHeapView().subarray(0, count),
+      states: this.agentStates
+        .getHeapView()
+        .subarray(0, count * crowdAgentStateStride),
+    };
+  }
+
+  /**
+   * Requests move targets for many agents in one call.
+   * Targets are snapped to the nearest polygon natively using the shared half extents and filter.
+   * @param agentIndices the agent indices
+   * @param targets the target for each agent, `[x, y, z, ...]`
+   * @returns the number of agents a move target was set for
+   */
+  requestMoveTargets(
+    agentIndices: ArrayLike<number>,
+    targets: ArrayLike<number>,
+    options?: {
+      /**
+       * The search distance along each axis used to snap targets. [(x, y, z)]
+       * @default this.navMeshQuery.defaultQueryHalfExtents
+       */
+      halfExtents?: Vector3;
+
+      /**
+       * The polygon filter used to snap targets.
+       * @default this.navMeshQuery.defaultFilter
+       */
+      filter?: QueryFilter;
+    },
+  ): number {
+    const { indices, vectors } = this.copyCommand(agentIndices, targets);
+
+    return Raw.CrowdUtils.requestMoveTargets(
+      this.raw,
+      indices.raw,
+      vectors.raw,
+      vec3.toArray(
+        options?.halfExtents ?? this.navMeshQuery.defaultQueryHalfExtents,
+      ),
+      (options?.filter ?? this.navMeshQuery.defaultFilter).raw,
+    );
+  }
+
+  /**
+   * Requests move velocities for many agents in one call.
+   * @param agentIndices the agent indices
+   * @param velocities the velocity for each agent, `[x, y, z, ...]`
+   * @returns the number of agents a move velocity was set for
+   */
+  requestMoveVelocities(
+    agentIndices: ArrayLike<number>,
+    velocities: ArrayLike<number>,
+  ): number {
+    const { indices, vectors } = this.copyCommand(agentIndices, velocities);
+
+    return Raw.CrowdUtils.requestMoveVelocities(
+      this.raw,
+      indices.raw,
+      vectors.raw,
+    );
+  }
+
+  /**
+   * Resets the move targets of many agents in one call.
+   * @returns the number of agents that were reset
+   */
+  resetMoveTargets(agentIndices: ArrayLike<number>): number {
+    const { indices } = this.copyCommand(agentIndices);
+
+    return Raw.CrowdUtils.resetMoveTargets(this.raw, indices.raw);
+  }
+
+  /**
+   * Teleports many agents in one call.
+   * @param agentIndices the agent indices
+   * @param positions the destination for each agent, `[x, y, z, ...]`
+   * @returns the number of agents that were teleported
+   */
+  teleportAgents(
+    agentIndices: ArrayLike<number>,
+    positions: ArrayLike<number>,
+  ): number {
+    const { indices, vectors } = this.copyCommand(agentIndices, positions);
+
+    const teleported = Raw.CrowdUtils.agentTeleports(
+      this.raw,
+      indices.raw,
+      vectors.raw,
+      vec3.toArray(this.navMeshQuery.defaultQueryHalfExtents),
+      this.navMeshQuery.defaultFilter.raw,
+    );
+
+    this.stepper?.resetAgents(indices.raw);
+
+    for (let i = 0; i < agentIndices.length; i++) {
+      const agent = this.agents[agentIndices[i]];
+      if (!agent) continue;
+
+      agent.interpolatedPosition.x = positions[i * 3];
+      agent.interpolatedPosition.y = positions[i * 3 + 1];
+      agent.interpolatedPosition.z = positions[i * 3 + 2];
+    }
+
+    return teleported;
+  }
+
+  /**
+   * Snaps the interpolated position of an agent to its current position, e.g. after a teleport.
+   */
+  resetInterpolation(agentIndex: number): void {
+    this.stepper?.resetAgent(agentIndex);
+  }
+
+  /**
+   * Exports a binary snapshot of the crowd, for rollback or fast save and load.
+   *
+   * The snapshot holds the query filters, obstacle avoidance params and every active agent, including its parameters,
+   * velocities, corridor, target, corners and local boundary. With the large crowd engine it also holds off-mesh connection
+   * animations and level of detail tiers. Agent `userData` is not part of snapshots.
+   */
+  exportSnapshot(): Uint8Array {
+    const crowdExport = Raw.NavMeshExporter.exportCrowd(
+      this.raw,
+      this.updater,
+    );
+
+    return readNavMeshExport(crowdExport);
+  }
+
+  /**
+   * Restores a snapshot from `exportSnapshot` into this crowd, which must have the same `maxAgents` and navmesh.
+   *
+   * Agents keep their indices and corridors, so no paths are recomputed. Agents waiting for a path are queued again,
+   * and agents that are not in the snapshot are removed.
+   * Without the large crowd engine, agents on an off-mesh connection are moved to its end.
+   * @returns whether the snapshot was restored, the crowd is unchanged if not
+   */
+  importSnapshot(data: Uint8Array): boolean {
+    const { navMeshExport, dataHeap } = createNavMeshExport(data);
+
+    const success = Raw.NavMeshImporter.importCrowd(
+      navMeshExport,
+      this.raw,
+      this.updater,
+    );
+
+    Raw.Module._free(dataHeap.byteOffset);
+    Raw.destroy(navMeshExport);
+
+    if (!success) return false;
+
+    const agents: { [idx: string]: CrowdAgent } = {};
+    const agentIndices: number[] = [];
+
+    for (let i = 0; i < this.getAgentCount(); i++) {
+      if (!this.raw.getAgent(i).active) continue;
+
+      const agent = this.agents[i] ?? new CrowdAgent(this, i);
+      agent.interpolatedPosition = agent.position();
+
+      agents[i] = agent;
+      agentIndices.push(i);
+    }
+
+    this.agents = agents;
+
+    if (this.stepper) {
+      const { indices } = this.copyCommand(agentIndices);
+      this.stepper.resetAgents(indices.raw);
+    }
+
+    return true;
+  }
+
+  /**
+   * Configures a level of detail tier of the large crowd engine, see `CrowdParams.threads`.
+   *
+   * Tier 0 is a full update by default. Tiers 1, 2 and 3 update every 2nd, 4th and 8th step.
+   * Tier 1 disables obstacle avoidance, turn anticipation and topology optimization,
+   * tiers 2 and 3 also disable separation, visibility optimization and collisions.
+   * @returns whether the tier was set
+   */
+  setLodTier(tier: number, lodTier: Partial<CrowdLodTier>): boolean {
+    const updater = this.getUpdater();
+    const current = updater.getLodTier(tier);
+
+    return updater.setLodTier(
+      tier,
+      lodTier.updateInterval ?? current.get_updateInterval(),
+      lodTier.disabledUpdateFlags ?? current.get_disabledUpdateFlags(),
+      lodTier.collision ?? current.get_collision(),
+    );
+  }
+
+  getLodTier(tier: number): CrowdLodTier {
+    const lodTier = this.getUpdater().getLodTier(tier);
+
+    return {
+      updateInterval: lodTier.get_updateInterval(),
+      disabledUpdateFlags: lodTier.get_disabledUpdateFlags(),
+      collision: lodTier.get_collision(),
+    };
+  }
+
+  /**
+   * Sets the level of detail tier of an agent. Agents start in tier 0, and return to it when removed.
+   * @returns whether the tier was set
+   */
+  setAgentLodTier(agentIndex: number, tier: number): boolean {
+    return this.getUpdater().setAgentLodTier(agentIndex, tier);
+  }
+
+  getAgentLodTier(agentIndex: number): number {
+    return this.updater?.getAgentLodTier(agentIndex) ?? 0;
+  }
+
+  /**
+   * Sets the level of detail tier of every agent from its 2D distance to the nearest focus point, e.g. cameras or players.
+   *
+   * Agents closer than `tierDistances[i]` get tier `i`, agents beyond every distance get the tier after the last distance.
+   * Without focus points, every agent gets tier 0.
+   * @param focusPoints the focus points
+   * @param tierDistances increasing distances, at most `crowdMaxLodTiers - 1`
+   * @returns the number of agents given a tier other than 0
+   *
+   * @example
+   * ```ts
+   * // full updates within 20 units of the camera, tier 1 within 50, tier 2 beyond
+   * crowd.setLodTiersFromFocusPoints([camera.position], [20, 50]);
+   * ```
+   */
+  setLodTiersFromFocusPoints(
+    focusPoints: Vector3[],
+    tierDistances: number[],
+  ): number {
+    const updater = this.getUpdater();
+
+    this.commandVectors ??= new FloatArray();
+    this.commandVectors.copy(focusPoints.flatMap(vec3.toArray));
+
+    this.lodDistances ??= new FloatArray();
+    this.lodDistances.copy(tierDistances);
+
+    return updater.setLodTiersFromFocusPoints(
+      this.commandVectors.raw,
+      this.lodDistances.raw,
+    );
+  }
+
+  /**
+   * Enables recording wall time and work counts per update phase of the large crowd engine, see `CrowdParams.threads`.
+   * Profiling is off by default, and costs a clock read per phase while enabled.
+   */
+  setProfilingEnabled(enabled: boolean): void {
+    this.getUpdater('Crowd profiling').setProfilingEnabled(enabled);
+  }
+
+  get profilingEnabled(): boolean {
+    return this.updater?.isProfilingEnabled() ?? false;
+  }
+
+  /**
+   * Returns the recorded profile of every update phase, summed over updates since the last `resetUpdateProfile`.
+   * Each phase is `[time, count]`, see `crowdUpdateProfileStride` and `CrowdUpdatePhase`.
+   * Values are rounded to 32 bit floats, `getUpdatePhaseProfile` returns exact totals of long profiles.
+   *
+   * @example
+   * ```ts
+   * crowd.setProfilingEnabled(true);
+   *
+   * // ... update the crowd
+   *
+   * const profile = crowd.getUpdateProfile();
+   * const updates = profile[CrowdUpdatePhase.TOTAL * crowdUpdateProfileStride + 1];
+   * const avoidanceTime = profile[CrowdUpdatePhase.AVOIDANCE * crowdUpdateProfileStride];
+   *
+   * crowd.resetUpdateProfile();
+   * ```
+   */
+  getUpdateProfile(): Float32Array {
+    const updater = this.getUpdater('Crowd profiling');
+
+    this.updateProfile ??= new FloatArray();
+    const phases = updater.getProfile(this.updateProfile.raw);
+
+    return this.updateProfile
+      .getHeapView()
+      .slice(0, phases * crowdUpdateProfileStride);
+  }
+
+  getUpdatePhaseProfile(phase: number): CrowdUpdatePhaseProfile {
+    const profile = this.getUpdater('Crowd profiling').getPhaseProfile(phase);
+
+    return { time: profile.get_time(), count: profile.get_count() };
+  }
+
+  resetUpdateProfile(): void {
+    this.updater?.resetProfile();
+  }
+
+  /**
+   * Configures the path queue budget and replan intervals of the large crowd engine, see `CrowdParams.pathQueue`.
+   * Unset params keep their current value. Path requests in flight are queued again.
+   * @returns false if a param is out of range
+   */
+  setPathQueueParams(params: Partial<CrowdPathQueueParams>): boolean {
+    const updater = this.getUpdater('Crowd path queue params');
+    const current = updater.getPathQueueParams();
+
+    const raw = new Raw.Module.CrowdPathQueueParams();
+    raw.set_capacity(params.capacity ?? current.get_capacity());
+    raw.set_maxIterations(params.maxIterations ?? current.get_maxIterations());
+    raw.set_maxSearchNodes(
+      params.maxSearchNodes ?? current.get_maxSearchNodes(),
+    );
+    raw.set_maxPathResult(params.maxPathResult ?? current.get_maxPathResult());
+    raw.set_replanDelay(params.replanDelay ?? current.get_replanDelay());
+    raw.set_topologyOptimizationDelay(
+      params.topologyOptimizationDelay ??
+        current.get_topologyOptimizationDelay(),
+    );
+
+    const success = updater.setPathQueueParams(raw);
+
+    Raw.destroy(raw);
+
+    return success;
+  }
+
+  getPathQueueParams(): CrowdPathQueueParams {
+    const params = this.getUpdater(
+      'Crowd path queue params',
+    ).getPathQueueParams();
+
+    return {
+      capacity: params.get_capacity(),
+      maxIterations: params.get_maxIterations(),
+      maxSearchNodes: params.get_maxSearchNodes(),
+      maxPathResult: params.get_maxPathResult(),
+      replanDelay: params.get_replanDelay(),
+      topologyOptimizationDelay: params.get_topologyOptimizationDelay(),
+    };
+  }
+
+  /**
+   * Returns the path queue counters of the last update, e.g. to tune `CrowdParams.pathQueue`.
+   * A queue depth that grows over updates means requests arrive faster than the iteration budget completes them.
+   */
+  getPathQueueStats(): CrowdPathQueueStats {
+    const stats = this.getUpdater(
+      'Crowd path queue stats',
+    ).getPathQueueStats();
+
+    return {
+      queueDepth: stats.get_queueDepth(),
+      activeRequests: stats.get_activeRequests(),
+      startedRequests: stats.get_startedRequests(),
+      completedRequests: stats.get_completedRequests(),
+      iterations: stats.get_iterations(),
+      maxWaitTime: stats.get_maxWaitTime(),
+      averageWaitTime: stats.get_averageWaitTime(),
+    };
+  }
+
+  private getUpdater(
+    feature = 'Crowd level of detail',
+  ): RawModule.CrowdUpdater {
+    if (!this.updater) {
+      throw new Error(
+        `${feature} requires the large crowd engine, set \`threads\`, \`gridCellSize\` or \`pathQueue\``,
+      );
+    }
+
+    return this.updater;
+  }
+
+  private copyCommand(
+    agentIndices: ArrayLike<number>,
+    vectors?: ArrayLike<number>,
+  ) {
+    this.commandIndices ??= new IntArray();
+    this.commandIndices.copy(agentIndices as number[]);
+
+    this.commandVectors ??= new FloatArray();
+    if (vectors) {
+      this.commandVectors.copy(vectors as number[]);
+    }
+
+    return { indices: this.commandIndices, vectors: this.commandVectors };
+  }
+
   /**
    * Returns all the agents managed by the crowd.
    */
@@ -638,6 +1395,24 @@ export class Crowd {
    * Destroys the crowd.
    */
   destroy(): void {
+    // join the updater's workers before the agents they update are freed
+    if (this.updater) {
+      this.updater.destroy();
+      Raw.destroy(this.updater);
+    }
+
     Raw.Detour.freeCrowd(this.raw);
+
+    if (this.stepper) {
+      this.stepper.destroy();
+      Raw.destroy(this.stepper);
+    }
+
+    this.agentStates?.destroy();
+    this.agentIndices?.destroy();
+    this.commandIndices?.destroy();
+    this.commandVectors?.destroy();
+    this.lodDistances?.destroy();
+    this.updateProfile?.destroy();
   }
 }
@@ -0,0 +1,239 @@
+import { FloatArray, IntArray, UnsignedIntArray } from './arrays';
+import type { Crowd, CrowdAgent } from './crowd';
+import { statusSucceed } from './detour';
+import type { NavMesh } from './nav-mesh';
+import { NavMeshQuery, type QueryFilter } from './nav-mesh-query';
+import { Raw, type RawModule } from './raw';
+import { type Vector3, vec3 } from './utils';
+
+export type FlowFieldComputeOptions = {
+  /**
+   * The query filter to expand the field with.
+   * @default flowField.navMeshQuery.defaultFilter
+   */
+  filter?: QueryFilter;
+
+  /**
+   * The search distance along each axis when finding the goal polygon.
+   * @default flowField.navMeshQuery.defaultQueryHalfExtents
+   */
+  halfExtents?: Vector3;
+
+  /**
+   * The maximum cost from a polygon to the goal, bounding the field to a region around the goal. 0 is unbounded.
+   * @default 0
+   */
+  maxCost?: number;
+
+  /**
+   * The maximum number of polygons in the field.
+   * [Limit: <= 65534]
+   * @default 4096
+   */
+  maxPolys?: number;
+};
+
+export type FlowFieldComputeResult = {
+  success: boolean;
+  status: number;
+
+  /**
+   * The polygon the field is rooted at
+   */
+  goalRef: number;
+
+  /**
+   * The number of polygons reached from the goal
+   */
+  polyCount: number;
+};
+
+/**
+ * A goal rooted flow field, for many agents sharing a destination.
+ *
+ * `compute` runs one Dijkstra expansion outwards from the goal, storing the cost to the goal and the parent polygon of every reached polygon.
+ * The parent of a polygon is the next polygon on the cheapest path to the goal, so the path of an agent is found by following parent links instead of running a search per agent.
+ *
+ * Costs come from the query filter in the direction of travel, and one way off-mesh connections are respected.
+ * The field should be recomputed after the navmesh changes.
+ *
+ * @example
+ * ```ts
+ * const flowField = new FlowField(navMesh);
+ * flowField.compute(rallyPoint);
+ *
+ * // give every agent a corridor to the rally point without a path request per agent
+ * flowField.setCrowdAgentCorridors(crowd, crowd.getAgents());
+ * ```
+ */
+export class FlowField {
+  raw: RawModule.FlowField;
+
+  /**
+   * The NavMeshQuery used to find the goal polygon
+   */
+  navMeshQuery: NavMeshQuery;
+
+  private path?: UnsignedIntArray;
+
+  private refs?: UnsignedIntArray;
+
+  private parents?: UnsignedIntArray;
+
+  private costs?: FloatArray;
+
+  private agentIndices?: IntArray;
+
+  constructor(public navMesh: NavMesh) {
+    this.raw = new Raw.Module.FlowField();
+    this.navMeshQuery = new NavMeshQuery(navMesh);
+  }
+
+  /**
+   * Computes the field from the polygon nearest to the goal.
+   */
+  compute(
+    goal: Vector3,
+    options?: FlowFieldComputeOptions,
+  ): FlowFieldComputeResult {
+    const filter = options?.filter ?? this.navMeshQuery.defaultFilter;
+
+    const { success, status, nearestRef, nearestPoint } =
+      this.navMeshQuery.findNearestPoly(goal, {
+        filter,
+        halfExtents: options?.halfExtents,
+      });
+
+    if (!success || nearestRef === 0) {
+      return { success: false, status, goalRef: 0, polyCount: 0 };
+    }
+
+    const computeStatus = this.raw.compute(
+      this.navMesh.raw,
+      nearestRef,
+      vec3.toArray(nearestPoint),
+      filter.raw,
+      options?.maxCost ?? 0,
+      options?.maxPolys ?? 4096,
+    );
+
+    return {
+      success: statusSucceed(computeStatus),
+      status: computeStatus,
+      goalRef: nearestRef,
+      polyCount: this.raw.getPolyCount(),
+    };
+  }
+
+  /**
+   * The number of polygons reached by the last `compute`.
+   */
+  get polyCount(): number {
+    return this.raw.getPolyCount();
+  }
+
+  /**
+   * Whether the polygon was reached by the last `compute`.
+   */
+  isReached(polyRef: number): boolean {
+    return this.raw.isReached(polyRef);
+  }
+
+  /**
+   * The cost from the polygon to the goal, or -1 if the polygon was not reached.
+   */
+  getCost(polyRef: number): number {
+    return this.raw.getCost(polyRef);
+  }
+
+  /**
+   * The next polygon towards the goal, or 0 for the goal polygon and polygons that were not reached.
+   */
+  getParent(polyRef: number): number {
+    return this.raw.getParent(polyRef);
+  }
+
+  /**
+   * The point the path from the polygon to the goal leaves the polygon, or the goal for the goal polygon.
+   * Steering towards the exit point of the current polygon follows the field.
+   * @returns the exit point, or null if the polygon was not reached
+   */
+  getExitPoint(polyRef: number): Vector3 | null {
+    const pointRaw = new Raw.Vec3();
+
+    const reached = this.raw.getExitPoint(polyRef, pointRaw);
+    const point = vec3.fromRaw(pointRaw);
+
+    Raw.destroy(pointRaw);
+
+    return reached ? point : null;
+  }
+
+  /**
+   * Returns the polygon path from the start polygon to the goal, empty if the start polygon was not reached.
+   * @param startRef the start polygon
+   * @param maxPath the maximum number of polygons in the path
+   */
+  getPath(startRef: number, maxPath = 256): number[] {
+    this.path ??= new UnsignedIntArray();
+
+    const count = this.raw.getPath(startRef, this.path.raw, maxPath);
+
+    return Array.from(this.path.getHeapView().subarray(0, count));
+  }
+
+  /**
+   * Returns every reached polygon with its parent polygon and cost to the goal, e.g. to visualize the field.
+   */
+  getPolys(): { refs: Uint32Array; parents: Uint32Array; costs: Float32Array } {
+    this.refs ??= new UnsignedIntArray();
+    this.parents ??= new UnsignedIntArray();
+    this.costs ??= new FloatArray();
+
+    const count = this.raw.getPolys(
+      this.refs.raw,
+      this.parents.raw,
+      this.costs.raw,
+    );
+
+    return {
+      refs: this.refs.getHeapView().slice(0, count),
+      parents: this.parents.getHeapView().slice(0, count),
+      costs: this.costs.getHeapView().slice(0, count),
+    };
+  }
+
+  /**
+   * Sets the corridors of crowd agents to their paths through the field, in place of `requestMoveTarget`.
+   *
+   * Agents whose polygon was not reached are left unchanged.
+   * Paths longer than a crowd agent corridor (256 polygons) target the exit point of their last polygon, and are partial.
+   * @returns the number of agents given a corridor
+   */
+  setCrowdAgentCorridors(
+    crowd: Crowd,
+    agents: ArrayLike<number> | CrowdAgent[],
+  ): number {
+    const indices = Array.from(agents as ArrayLike<number | CrowdAgent>, (agent) =>
+      typeof agent === 'number' ? agent : agent.agentIndex,
+    );
+
+    this.agentIndices ??= new IntArray();
+    this.agentIndices.copy(indices);
+
+    return this.raw.setCrowdAgentCorridors(crowd.raw, this.agentIndices.raw);
+  }
+
+  destroy(): void {
+    this.raw.destroy();
+    Raw.destroy(this.raw);
+
+    this.navMeshQuery.destroy();
+
+    this.path?.destroy();
+    this.refs?.destroy();
+    this.parents?.destroy();
+    this.costs?.destroy();
+    this.agentIndices?.destroy();
+  }
+}
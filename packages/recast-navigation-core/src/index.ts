@@ -2,8 +2,12 @@ export * from './arrays';
 export * from './crowd';
 export * from './debug-drawer-utils';
 export * from './detour';
+export * from './flow-field';
 export * from './nav-mesh';
 export * from './nav-mesh-query';
+export * from './nav-mesh-path-cache';
+export * from './nav-mesh-path-request-manager';
+export * from './nav-mesh-tile-streamer';
 export * from './random';
 export * from './raw';
 export * from './recast';
@@ -0,0 +1,94 @@
+import type { NavMesh } from './nav-mesh';
+import { Raw, type RawModule } from './raw';
+
+export type NavMeshPathCacheParams = {
+  /**
+   * The maximum number of cached paths, the least recently used path is evicted when the cache is full.
+   * @default 1024
+   */
+  maxEntries?: number;
+};
+
+export type NavMeshPathCacheStats = {
+  hits: number;
+  misses: number;
+  /**
+   * The number of entries removed because a tile on their corridor changed
+   */
+  invalidations: number;
+  evictions: number;
+  entries: number;
+  /**
+   * The approximate memory used by cached entries in bytes
+   */
+  memoryBytes: number;
+};
+
+/**
+ * Caches polygon paths keyed on the start polygon, end polygon and query filter.
+ *
+ * Set it on a NavMeshQuery with `navMeshQuery.setPathCache(cache)`, then `findPath`, `findPathBatch` and `computePath` return stored paths for repeated queries.
+ * Filters are keyed by their include and exclude flags and area costs, so changing a filter misses paths found before the change.
+ *
+ * A cached path is invalidated when any tile on it is added, removed, or rebuilt, e.g. by `TileCache.update`, or has polygon flags or areas set.
+ *
+ * @example
+ * ```ts
+ * const pathCache = new NavMeshPathCache(navMesh, { maxEntries: 512 });
+ * navMeshQuery.setPathCache(pathCache);
+ *
+ * const { hits, misses, memoryBytes } = pathCache.stats;
+ * ```
+ */
+export class NavMeshPathCache {
+  raw: RawModule.NavMeshPathCache;
+
+  constructor(
+    public navMesh: NavMesh,
+    params?: NavMeshPathCacheParams,
+  ) {
+    this.raw = new Raw.Module.NavMeshPathCache();
+
+    if (!this.raw.init(navMesh.raw, params?.maxEntries ?? 1024)) {
+      Raw.destroy(this.raw);
+      throw new Error('Failed to initialize NavMeshPathCache');
+    }
+  }
+
+  get stats(): NavMeshPathCacheStats {
+    const stats = this.raw.getStats();
+
+    return {
+      hits: stats.hits,
+      misses: stats.misses,
+      invalidations: stats.invalidations,
+      evictions: stats.evictions,
+      entries: stats.entries,
+      memoryBytes: stats.memoryBytes,
+    };
+  }
+
+  resetStats(): void {
+    this.raw.resetStats();
+  }
+
+  /**
+   * Removes all entries that are no longer valid. Invalid entries are otherwise removed when they are next looked up.
+   * @returns the number of removed entries
+   */
+  prune(): number {
+    return this.raw.prune();
+  }
+
+  clear(): void {
+    this.raw.clear();
+  }
+
+  /**
+   * Destroys the cache. It must be removed from any NavMeshQuery it is set on first.
+   */
+  destroy(): void {
+    this.raw.destroy();
+    Raw.destroy(this.raw);
+  }
+}
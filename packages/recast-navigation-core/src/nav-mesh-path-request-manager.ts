@@ -0,0 +1,221 @@
+import { UnsignedIntArray } from './arrays';
+import { statusDetail, statusSucceed } from './detour';
+import type { NavMesh } from './nav-mesh';
+import { QueryFilter } from './nav-mesh-query';
+import { Detour, Raw, type RawModule } from './raw';
+import { type Vector3, vec3 } from './utils';
+
+export const PathRequestState = {
+  INVALID: 0,
+  QUEUED: 1,
+  IN_PROGRESS: 2,
+  DONE: 3,
+  FAILED: 4,
+} as const;
+
+export type PathRequestState =
+  (typeof PathRequestState)[keyof typeof PathRequestState];
+
+export type NavMeshPathRequestManagerParams = {
+  /**
+   * The maximum number of search nodes of the manager's query.
+   * @default 2048
+   */
+  maxNodes?: number;
+
+  /**
+   * The maximum number of requests that can be held at once, including done requests that have not been released.
+   * @default 256
+   */
+  maxRequests?: number;
+
+  /**
+   * The maximum number of polygons in a request's path.
+   * @default 256
+   */
+  maxPathPolys?: number;
+
+  /**
+   * The number of search iterations per sliced update, which is the granularity of the time budget.
+   * @default 32
+   */
+  iterationsPerSlice?: number;
+};
+
+export type NavMeshPathRequestManagerUpdateOptions = {
+  /**
+   * The budget of search iterations for the update, 0 for unlimited.
+   * @default 0
+   */
+  maxIterations?: number;
+
+  /**
+   * The time budget for the update in microseconds, 0 for unlimited.
+   * @default 0
+   */
+  maxTimeUs?: number;
+};
+
+export type NavMeshPathRequestManagerUpdateResult = {
+  iterations: number;
+  completed: number;
+  pending: number;
+};
+
+export type NavMeshPathRequestResult = {
+  success: boolean;
+  status: number;
+  /**
+   * Whether the path ends at the polygon nearest to the end because the end could not be reached
+   */
+  partial: boolean;
+  polys: number[];
+};
+
+/**
+ * Runs many path requests with sliced pathfinding, advancing them under a per-update iteration or time budget.
+ *
+ * Requests are started highest priority first, ties in the order they were made.
+ * The manager owns its own query, so it does not interfere with other NavMeshQuery instances.
+ *
+ * @example
+ * ```ts
+ * const manager = new NavMeshPathRequestManager(navMesh);
+ *
+ * const handle = manager.request(startRef, endRef, start, end, { priority: 1 });
+ *
+ * // every frame
+ * manager.update({ maxTimeUs: 500 });
+ *
+ * if (manager.getState(handle) === PathRequestState.DONE) {
+ *   const { polys } = manager.getPath(handle);
+ *   manager.release(handle);
+ * }
+ * ```
+ */
+export class NavMeshPathRequestManager {
+  raw: RawModule.NavMeshPathRequestManager;
+
+  defaultFilter: QueryFilter;
+
+  private pathArray?: UnsignedIntArray;
+
+  constructor(
+    public navMesh: NavMesh,
+    params?: NavMeshPathRequestManagerParams,
+  ) {
+    this.raw = new Raw.Module.NavMeshPathRequestManager();
+
+    const initialized = this.raw.init(
+      navMesh.raw,
+      params?.maxNodes ?? 2048,
+      params?.maxRequests ?? 256,
+      params?.maxPathPolys ?? 256,
+    );
+
+    if (!initialized) {
+      Raw.destroy(this.raw);
+      throw new Error('Failed to initialize NavMeshPathRequestManager');
+    }
+
+    if (params?.iterationsPerSlice !== undefined) {
+      this.raw.setIterationsPerSlice(params.iterationsPerSlice);
+    }
+
+    this.defaultFilter = new QueryFilter();
+  }
+
+  /**
+   * Queues a path request.
+   * @returns a handle to poll the request with, or 0 if the manager is full
+   */
+  request(
+    startRef: number,
+    endRef: number,
+    startPosition: Vector3,
+    endPosition: Vector3,
+    options?: {
+      /**
+       * The polygon filter to apply to the query. It must not be destroyed while the request is pending.
+       * @default this.defaultFilter
+       */
+      filter?: QueryFilter;
+
+      /**
+       * Higher priority requests are started first.
+       * @default 0
+       */
+      priority?: number;
+    },
+  ): number {
+    return this.raw.request(
+      startRef,
+      endRef,
+      vec3.toArray(startPosition),
+      vec3.toArray(endPosition),
+      (options?.filter ?? this.defaultFilter).raw,
+      options?.priority ?? 0,
+    );
+  }
+
+  /**
+   * Advances pending requests until either budget is used.
+   */
+  update(
+    options?: NavMeshPathRequestManagerUpdateOptions,
+  ): NavMeshPathRequestManagerUpdateResult {
+    const result = this.raw.update(
+      options?.maxIterations ?? 0,
+      options?.maxTimeUs ?? 0,
+    );
+
+    return {
+      iterations: result.iterations,
+      completed: result.completed,
+      pending: result.pending,
+    };
+  }
+
+  getState(handle: number): PathRequestState {
+    return this.raw.getRequestState(handle) as PathRequestState;
+  }
+
+  /**
+   * Returns the path of a done request.
+   * The request keeps its path until it is released.
+   */
+  getPath(handle: number): NavMeshPathRequestResult {
+    this.pathArray ??= new UnsignedIntArray();
+
+    const status = this.raw.getRequestPath(handle, this.pathArray.raw);
+
+    const polys = statusSucceed(status)
+      ? Array.from(this.pathArray.getHeapView())
+      : [];
+
+    return {
+      success: statusSucceed(status),
+      status,
+      partial: statusDetail(status, Detour.DT_PARTIAL_RESULT),
+      polys,
+    };
+  }
+
+  /**
+   * Cancels the request if it is still pending, and frees its handle.
+   */
+  release(handle: number): void {
+    this.raw.release(handle);
+  }
+
+  get pendingCount(): number {
+    return this.raw.getPendingCount();
+  }
+
+  destroy(): void {
+    this.raw.destroy();
+    Raw.destroy(this.raw);
+    this.defaultFilter.destroy();
+    this.pathArray?.destroy();
+  }
+}
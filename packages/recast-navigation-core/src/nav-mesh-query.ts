@@ -1,6 +1,7 @@
 import { FloatArray, UnsignedCharArray, UnsignedIntArray } from './arrays';
-import { statusSucceed } from './detour';
+import { statusInProgress, statusSucceed } from './detour';
 import type { NavMesh } from './nav-mesh';
+import type { NavMeshPathCache } from './nav-mesh-path-cache';
 import { Raw, type RawModule } from './raw';
 import { type Vector3, array, vec3 } from './utils';
 
@@ -45,6 +46,13 @@ export class QueryFilter {
   setAreaCost(i: number, cost: number): void {
     this.raw.setAreaCost(i, cost);
   }
+
+  /**
+   * Destroys a filter created with `new QueryFilter()`. Filters wrapping raw filters owned elsewhere, e.g. by a crowd, must not be destroyed.
+   */
+  destroy(): void {
+    Raw.destroy(this.raw);
+  }
 }
 
 export type NavMeshQueryParams = {
@@ -67,6 +75,86 @@ export type NavMeshQueryParams = {
   defaultQueryFilter?: QueryFilter;
 };
 
+/**
+ * Error codes returned by the native computePath, in the order of the query steps.
+ */
+const ComputePathError = {
+  NONE: 0,
+  START_NEAREST_POLY_FAILED: 1,
+  END_NEAREST_POLY_FAILED: 2,
+  FIND_PATH_FAILED: 3,
+  NO_POLYGON_PATH_FOUND: 4,
+  NO_CLOSEST_POINT_ON_LAST_POLYGON_FOUND: 5,
+  FIND_STRAIGHT_PATH_FAILED: 6,
+} as const;
+
+const computePathErrorNames: Record<number, string> = {
+  [ComputePathError.START_NEAREST_POLY_FAILED]:
+    'findNearestPoly for start position failed',
+  [ComputePathError.END_NEAREST_POLY_FAILED]:
+    'findNearestPoly for end position failed',
+  [ComputePathError.FIND_PATH_FAILED]: 'findPath unsuccessful',
+  [ComputePathError.NO_POLYGON_PATH_FOUND]: 'no polygon path found',
+  [ComputePathError.NO_CLOSEST_POINT_ON_LAST_POLYGON_FOUND]:
+    'no closest point on last polygon found',
+  [ComputePathError.FIND_STRAIGHT_PATH_FAILED]: 'findStraightPath unsuccessful',
+};
+
+export type FindPathBatchResult = {
+  /**
+   * Whether the batch was run. Check `statuses` for the result of each query.
+   */
+  success: boolean;
+
+  status: number;
+
+  /**
+   * The number of start/end pairs in the batch.
+   */
+  count: number;
+
+  /**
+   * Offsets into `polys` for each query, query `i` spans `polys[offsets[i]]` to `polys[offsets[i + 1]]`. Length: `count + 1`
+   */
+  offsets: Uint32Array;
+
+  /**
+   * dtStatus for each query. Length: `count`
+   */
+  statuses: Uint32Array;
+
+  /**
+   * The polygon refs of all paths.
+   */
+  polys: Uint32Array;
+};
+
+export type FindNearestPolyBatchResult = {
+  success: boolean;
+
+  status: number;
+
+  /**
+   * The number of points in the batch.
+   */
+  count: number;
+
+  /**
+   * The nearest polygon ref for each point, 0 if no polygon was found. Length: `count`
+   */
+  nearestRefs: Uint32Array;
+
+  /**
+   * The nearest point on the nearest polygon for each point, `[x, y, z, ...]`. Length: `count * 3`
+   */
+  nearestPoints: Float32Array;
+
+  /**
+   * Whether each point is over its nearest polygon, 1 or 0. Length: `count`
+   */
+  isOverPoly: Uint8Array;
+};
+
 export class NavMeshQuery {
   raw: RawModule.NavMeshQuery;
 
@@ -80,6 +168,18 @@ export class NavMeshQuery {
    */
   defaultQueryHalfExtents = { x: 1, y: 1, z: 1 };
 
+  private batchPositions?: FloatArray;
+
+  private batchResult?: UnsignedIntArray;
+
+  private batchNearestRefs?: UnsignedIntArray;
+
+  private batchNearestPoints?: FloatArray;
+
+  private batchIsOverPoly?: UnsignedCharArray;
+
+  private computePathResult?: UnsignedIntArray;
+
   /**
    * Constructs a new navigation mesh query object.
    * @param navMesh the navigation mesh to use for the query
@@ -173,6 +273,84 @@ export class NavMeshQuery {
     };
   }
 
+  /**
+   * Finds the nearest polygon and the nearest point on it for many points in one call.
+   *
+   * Consecutive points that land on the same polygon reuse the previous lookup, so spatially coherent input is faster.
+   *
+   * The returned arrays are views into the wasm heap, valid until the next call to `findNearestPolyBatch` or until the wasm heap grows.
+   * Copy them with `.slice()` if they need to be kept.
+   *
+   * @param points the points to snap, `[x, y, z, ...]`
+   * @param options additional options
+   */
+  findNearestPolyBatch(
+    points: FloatArray | ArrayLike<number>,
+    options?: {
+      /**
+       * The polygon filter to apply to the query.
+       * @default this.defaultFilter
+       */
+      filter?: QueryFilter;
+
+      /**
+       * The search distance along each axis. [(x, y, z)]
+       * @default this.defaultQueryHalfExtents
+       */
+      halfExtents?: Vector3;
+    },
+  ): FindNearestPolyBatchResult {
+    const filter = options?.filter ?? this.defaultFilter;
+    const halfExtents = options?.halfExtents ?? this.defaultQueryHalfExtents;
+
+    let pointsArray: FloatArray;
+
+    if (points instanceof FloatArray) {
+      pointsArray = points;
+    } else {
+      this.batchPositions ??= new FloatArray();
+      this.batchPositions.copy(points as number[]);
+      pointsArray = this.batchPositions;
+    }
+
+    this.batchNearestRefs ??= new UnsignedIntArray();
+    this.batchNearestPoints ??= new FloatArray();
+    this.batchIsOverPoly ??= new UnsignedCharArray();
+
+    const status = this.raw.findNearestPolyBatch(
+      pointsArray.raw,
+      vec3.toArray(halfExtents),
+      filter.raw,
+      this.batchNearestRefs.raw,
+      this.batchNearestPoints.raw,
+      this.batchIsOverPoly.raw,
+    );
+
+    if (!statusSucceed(status)) {
+      return {
+        success: false,
+        status,
+        count: 0,
+        nearestRefs: new Uint32Array(0),
+        nearestPoints: new Float32Array(0),
+        isOverPoly: new Uint8Array(0),
+      };
+    }
+
+    const count = pointsArray.size / 3;
+
+    return {
+      success: true,
+      status,
+      count,
+      nearestRefs: this.batchNearestRefs.getHeapView().subarray(0, count),
+      nearestPoints: this.batchNearestPoints
+        .getHeapView()
+        .subarray(0, count * 3),
+      isOverPoly: this.batchIsOverPoly.getHeapView().subarray(0, count),
+    };
+  }
+
   /**
    * Finds the polygons along the navigation graph that touch the specified circle.
    * @param startRef Reference of polygon to start search from
@@ -596,6 +774,9 @@ export class NavMeshQuery {
   /**
    * Finds a straight path from the start position to the end position.
    *
+   * The nearest polygon, polygon path and straight path queries run natively in a single call.
+   * If the polygon path is partial, the end position is clamped to the last polygon of the path.
+   *
    * @param start the start position
    * @param end the end position
    * @param options additional options
@@ -658,138 +839,73 @@ export class NavMeshQuery {
   } {
     const filter = options?.filter ?? this.defaultFilter;
     const halfExtents = options?.halfExtents ?? this.defaultQueryHalfExtents;
-
-    // find nearest polygons for start and end positions
-    const startNearestPolyResult = this.findNearestPoly(start, {
-      filter,
-      halfExtents,
-    });
-
-    if (!startNearestPolyResult.success) {
-      return {
-        success: false,
-        error: {
-          name: 'findNearestPoly for start position failed',
-          status: startNearestPolyResult.status,
-        },
-        path: [],
-      };
-    }
-
-    const endNearestPolyResult = this.findNearestPoly(end, {
-      filter,
-      halfExtents,
-    });
-
-    if (!endNearestPolyResult.success) {
-      return {
-        success: false,
-        error: {
-          name: 'findNearestPoly for end position failed',
-          status: endNearestPolyResult.status,
-        },
-        path: [],
-      };
-    }
-
-    const startRef = startNearestPolyResult.nearestRef;
-    const endRef = endNearestPolyResult.nearestRef;
-
-    // find polygon path
     const maxPathPolys = options?.maxPathPolys ?? 256;
+    const maxStraightPathPoints = options?.maxStraightPathPoints ?? 256;
 
-    const findPathResult = this.findPath(startRef, endRef, start, end, {
-      filter,
+    this.computePathResult ??= new UnsignedIntArray();
+
+    const result = this.raw.computePath(
+      vec3.toArray(start),
+      vec3.toArray(end),
+      vec3.toArray(halfExtents),
+      filter.raw,
       maxPathPolys,
-    });
+      maxStraightPathPoints,
+      this.computePathResult.raw,
+    );
 
-    if (!findPathResult.success) {
-      return {
-        success: false,
-        error: {
-          name: 'findPath unsuccessful',
-          status: findPathResult.status,
-        },
-        path: [],
-      };
-    }
+    const { status, error, straightPathCount } = result;
 
-    if (findPathResult.polys.size <= 0) {
+    if (error !== ComputePathError.NONE) {
       return {
         success: false,
         error: {
-          name: 'no polygon path found',
+          name: computePathErrorNames[error],
+          status:
+            error === ComputePathError.NO_POLYGON_PATH_FOUND
+              ? undefined
+              : status,
         },
         path: [],
       };
     }
 
-    const lastPoly = findPathResult.polys.get(findPathResult.polys.size - 1);
-
-    let closestEnd = { x: end.x, y: end.y, z: end.z };
-
-    if (lastPoly !== endRef) {
-      const lastPolyClosestPointResult = this.closestPointOnPoly(lastPoly, end);
-
-      if (!lastPolyClosestPointResult.success) {
-        return {
-          success: false,
-          error: {
-            name: 'no closest point on last polygon found',
-            status: lastPolyClosestPointResult.status,
-          },
-          path: [],
-        };
-      }
-
-      closestEnd = lastPolyClosestPointResult.closestPoint;
-    }
-
-    // find straight path
-    const maxStraightPathPoints = options?.maxStraightPathPoints;
-
-    const findStraightPathResult = this.findStraightPath(
-      start,
-      closestEnd,
-      findPathResult.polys,
-      { maxStraightPathPoints },
+    // format output, corners are packed as [x, y, z, flags, ref]
+    const view = this.computePathResult.getHeapView();
+    const floats = new Float32Array(
+      view.buffer,
+      view.byteOffset,
+      straightPathCount * 5,
     );
 
-    if (!findStraightPathResult.success) {
-      return {
-        success: false,
-        error: {
-          name: 'findStraightPath unsuccessful',
-          status: findStraightPathResult.status,
-        },
-        path: [],
-      };
-    }
-
-    const { straightPath, straightPathCount } = findStraightPathResult;
-
-    // format output
     const points: Vector3[] = [];
 
     for (let i = 0; i < straightPathCount; i++) {
       points.push({
-        x: straightPath.get(i * 3),
-        y: straightPath.get(i * 3 + 1),
-        z: straightPath.get(i * 3 + 2),
+        x: floats[i * 5],
+        y: floats[i * 5 + 1],
+        z: floats[i * 5 + 2],
       });
     }
 
-    findPathResult.polys.destroy();
-    findStraightPathResult.straightPath.destroy();
-    findStraightPathResult.straightPathFlags.destroy();
-    findStraightPathResult.straightPathRefs.destroy();
-
     return {
       success: true,
       path: points,
     };
   }
 
+  /**
+   * Sets a path cache that `findPath`, `findPathBatch` and `computePath` look up and store paths in.
+   * @param pathCache the path cache, or undefined to stop using a cache
+   */
+  setPathCache(pathCache: NavMeshPathCache | undefined): void {
+    if (pathCache) {
+      this.raw.setPathCache(pathCache.raw);
+    } else {
+      this.raw.clearPathCache();
+    }
+  }
+
   /**
    * Finds a path from the start polygon to the end polygon.
    * @param startRef the reference id of the start polygon.
@@ -847,6 +963,218 @@ export class NavMeshQuery {
     };
   }
 
+  /**
+   * Initializes a sliced path query, which can be advanced over several frames with `updateSlicedFindPath`.
+   *
+   * Only one sliced query can be in progress per NavMeshQuery. See `NavMeshPathRequestManager` for running many requests under a budget.
+   *
+   * @param startRef the reference id of the start polygon.
+   * @param endRef the reference id of the end polygon.
+   * @param startPosition position within the start polygon.
+   * @param endPosition position within the end polygon.
+   * @param options additional options
+   */
+  initSlicedFindPath(
+    startRef: number,
+    endRef: number,
+    startPosition: Vector3,
+    endPosition: Vector3,
+    options?: {
+      /**
+       * The polygon filter to apply to the query. It must not be destroyed while the query is in progress.
+       * @default this.defaultFilter
+       */
+      filter?: QueryFilter;
+
+      /**
+       * Query options, e.g. `Detour.DT_FINDPATH_ANY_ANGLE`
+       * @default 0
+       */
+      options?: number;
+    },
+  ) {
+    const filter = options?.filter ?? this.defaultFilter;
+
+    const status = this.raw.initSlicedFindPath(
+      startRef,
+      endRef,
+      vec3.toArray(startPosition),
+      vec3.toArray(endPosition),
+      filter.raw,
+      options?.options ?? 0,
+    );
+
+    return {
+      success: statusSucceed(status),
+      status,
+    };
+  }
+
+  /**
+   * Advances the sliced path query by up to the given number of iterations.
+   * @param maxIter the maximum number of iterations to perform
+   * @returns `inProgress` is true while the query needs more updates
+   */
+  updateSlicedFindPath(maxIter: number) {
+    const doneItersRef = new Raw.IntRef();
+
+    const status = this.raw.updateSlicedFindPath(maxIter, doneItersRef);
+
+    const doneIters = doneItersRef.value;
+    Raw.destroy(doneItersRef);
+
+    return {
+      success: statusSucceed(status),
+      inProgress: statusInProgress(status),
+      status,
+      doneIters,
+    };
+  }
+
+  /**
+   * Finalizes the sliced path query and returns the polygon path.
+   * If the end was not reached, the path leads to the polygon nearest to the end.
+   *
+   * The `polys` array returned must be freed after use.
+   */
+  finalizeSlicedFindPath(maxPathPolys = 256) {
+    const polysArray = new UnsignedIntArray();
+
+    const status = this.raw.finalizeSlicedFindPath(
+      polysArray.raw,
+      maxPathPolys,
+    );
+
+    return {
+      success: statusSucceed(status),
+      status,
+      polys: polysArray,
+    };
+  }
+
+  /**
+   * Finalizes the sliced path query, returning a path to the furthest polygon of an existing path that was visited.
+   *
+   * The `polys` array returned must be freed after use.
+   */
+  finalizeSlicedFindPathPartial(
+    existing: UnsignedIntArray,
+    maxPathPolys = 256,
+  ) {
+    const polysArray = new UnsignedIntArray();
+
+    const status = this.raw.finalizeSlicedFindPathPartial(
+      existing.raw,
+      polysArray.raw,
+      maxPathPolys,
+    );
+
+    return {
+      success: statusSucceed(status),
+      status,
+      polys: polysArray,
+    };
+  }
+
+  /**
+   * Finds polygon paths for many start/end pairs in one call.
+   *
+   * The nearest polygons for each start and end position are found natively, then each search runs with a reused scratch buffer.
+   *
+   * The returned arrays are views into the wasm heap, valid until the next call to `findPathBatch` or until the wasm heap grows.
+   * Copy them with `.slice()` if they need to be kept.
+   *
+   * @param positions start and end positions for each query, `[startX, startY, startZ, endX, endY, endZ, ...]`
+   * @param options additional options
+   *
+   * @example
+   * ```ts
+   * const { count, offsets, statuses, polys } = navMeshQuery.findPathBatch(positions);
+   *
+   * for (let i = 0; i < count; i++) {
+   *   if (!statusSucceed(statuses[i])) continue;
+   *
+   *   const path = polys.subarray(offsets[i], offsets[i + 1]);
+   * }
+   * ```
+   */
+  findPathBatch(
+    positions: FloatArray | ArrayLike<number>,
+    options?: {
+      /**
+       * The polygon filter to apply to the query.
+       * @default this.defaultFilter
+       */
+      filter?: QueryFilter;
+
+      /**
+       * The search distance along each axis used to find the nearest polygons. [(x, y, z)]
+       * @default this.defaultQueryHalfExtents
+       */
+      halfExtents?: Vector3;
+
+      /**
+       * The maximum number of polygons each path can hold. [Limit: >= 1]
+       * @default 256
+       */
+      maxPathPolys?: number;
+    },
+  ): FindPathBatchResult {
+    const filter = options?.filter ?? this.defaultFilter;
+    const halfExtents = options?.halfExtents ?? this.defaultQueryHalfExtents;
+    const maxPathPolys = options?.maxPathPolys ?? 256;
+
+    let positionsArray: FloatArray;
+
+    if (positions instanceof FloatArray) {
+      positionsArray = positions;
+    } else {
+      this.batchPositions ??= new FloatArray();
+      this.batchPositions.copy(positions as number[]);
+      positionsArray = this.batchPositions;
+    }
+
+    this.batchResult ??= new UnsignedIntArray();
+
+    const status = this.raw.findPathBatch(
+      positionsArray.raw,
+      vec3.toArray(halfExtents),
+      filter.raw,
+      maxPathPolys,
+      this.batchResult.raw,
+    );
+
+    const count = positionsArray.size / 6;
+
+    if (!statusSucceed(status)) {
+      return {
+        success: false,
+        status,
+        count: 0,
+        offsets: new Uint32Array(0),
+        statuses: new Uint32Array(0),
+        polys: new Uint32Array(0),
+      };
+    }
+
+    const view = this.batchResult.getHeapView();
+    const offsets = view.subarray(0, count + 1);
+    const statuses = view.subarray(count + 1, count * 2 + 1);
+    const polys = view.subarray(
+      count * 2 + 1,
+      count * 2 + 1 + offsets[count],
+    );
+
+    return {
+      success: true,
+      status,
+      count,
+      offsets,
+      statuses,
+      polys,
+    };
+  }
+
   /**
    * Finds the straight path from the start to the end position within the polygon corridor.
    *
@@ -1128,5 +1456,12 @@ export class NavMeshQuery {
    */
   destroy(): void {
     this.raw.destroy();
+
+    this.batchPositions?.destroy();
+    this.batchResult?.destroy();
+    this.batchNearestRefs?.destroy();
+    this.batchNearestPoints?.destroy();
+    this.batchIsOverPoly?.destroy();
+    this.computePathResult?.destroy();
   }
 }
@@ -0,0 +1,215 @@
+import { UnsignedCharArray } from './arrays';
+import type { NavMesh } from './nav-mesh';
+import { Raw, type RawModule } from './raw';
+import type { NavMeshIndex, NavMeshIndexTile } from './serdes';
+import { type Vector3, vec3 } from './utils';
+
+/**
+ * Returns the payload for a tile directory entry, or undefined if it is not available yet.
+ * Tiles that are not available are retried on the next update, so payloads can be fetched asynchronously.
+ */
+export type NavMeshTileLoaderFn = (
+  tile: NavMeshIndexTile,
+  tileIndex: number,
+) => Uint8Array | undefined;
+
+export type NavMeshTileStreamerFocus = {
+  position: Vector3;
+  radius: number;
+};
+
+export type NavMeshTileStreamerUpdateOptions = {
+  /**
+   * The time budget for the update in milliseconds, 0 for unlimited.
+   * @default 0
+   */
+  maxTimeMs?: number;
+
+  /**
+   * The budget of tile bytes to load in the update, 0 for unlimited.
+   * @default 0
+   */
+  maxBytes?: number;
+};
+
+export type NavMeshTileStreamerUpdateResult = {
+  loaded: number;
+  evicted: number;
+  bytesLoaded: number;
+  /**
+   * The number of tiles within a focus radius that are still not resident
+   */
+  pending: number;
+  /**
+   * The number of tiles that failed to load in the update, e.g. on a checksum mismatch.
+   * Failed tiles are not retried until they are reset with `resetFailedTiles`.
+   */
+  failed: number;
+  residentTiles: number;
+  residentBytes: number;
+};
+
+export type NavMeshTileStreamerParams = {
+  /**
+   * Loads tile payloads, e.g. from ranged requests into an indexed export.
+   * If not provided, payloads are read from the data the index was created with.
+   */
+  loader?: NavMeshTileLoaderFn;
+
+  /**
+   * Resident tiles are only evicted once they are this far outside of every focus radius.
+   * @default 0
+   */
+  evictionMargin?: number;
+};
+
+/**
+ * Manages which tiles of an indexed export are resident in a NavMesh, based on a set of focus points.
+ *
+ * Each update evicts tiles outside of the focus radii, then loads missing tiles nearest first within a time and byte budget.
+ * Tiles are added with the tile refs stored in the export, so refs stay stable as tiles are streamed in and out.
+ *
+ * @example
+ * ```ts
+ * const index = new NavMeshIndex(data);
+ * const navMesh = index.createNavMesh();
+ *
+ * const streamer = new NavMeshTileStreamer(navMesh, index);
+ *
+ * // every frame
+ * streamer.setFocus([{ position: player.position, radius: 100 }]);
+ * streamer.update({ maxTimeMs: 2 });
+ * ```
+ */
+export class NavMeshTileStreamer {
+  raw: RawModule.NavMeshTileStreamer;
+
+  private loader?: RawModule.NavMeshTileLoader;
+
+  constructor(
+    public navMesh: NavMesh,
+    public index: NavMeshIndex,
+    params?: NavMeshTileStreamerParams,
+  ) {
+    this.raw = new Raw.Module.NavMeshTileStreamer();
+
+    if (!this.raw.init(navMesh.raw, index.raw)) {
+      Raw.destroy(this.raw);
+      throw new Error('Failed to initialize NavMeshTileStreamer');
+    }
+
+    if (params?.loader) {
+      const loaderFn = params.loader;
+
+      this.loader = new Raw.Module.NavMeshTileLoader();
+
+      this.loader.load = (
+        tileIndex: number,
+        _offset: number,
+        _dataSize: number,
+        dataPtr: number,
+      ) => {
+        const payload = loaderFn(this.index.getTile(tileIndex), tileIndex);
+
+        if (!payload) return false;
+
+        const data = UnsignedCharArray.fromRaw(
+          Raw.Module.wrapPointer(dataPtr, Raw.Module.UnsignedCharArray),
+        );
+        data.copy(payload);
+
+        return true;
+      };
+
+      this.raw.setLoader(this.loader as never);
+    }
+
+    if (params?.evictionMargin !== undefined) {
+      this.raw.setEvictionMargin(params.evictionMargin);
+    }
+  }
+
+  /**
+   * Replaces the focus points that determine which tiles should be resident.
+   */
+  setFocus(focus: NavMeshTileStreamerFocus[]): void {
+    this.raw.clearFocus();
+
+    for (const { position, radius } of focus) {
+      this.raw.addFocus(vec3.toArray(position), radius);
+    }
+  }
+
+  /**
+   * Evicts distant tiles and loads missing tiles within the given budget.
+   * At least one missing tile is loaded per update regardless of the budget.
+   */
+  update(
+    options?: NavMeshTileStreamerUpdateOptions,
+  ): NavMeshTileStreamerUpdateResult {
+    const result = this.raw.update(
+      options?.maxTimeMs ?? 0,
+      options?.maxBytes ?? 0,
+    );
+
+    return {
+      loaded: result.loaded,
+      evicted: result.evicted,
+      bytesLoaded: result.bytesLoaded,
+      pending: result.pending,
+      failed: result.failed,
+      residentTiles: result.residentTiles,
+      residentBytes: result.residentBytes,
+    };
+  }
+
+  isTileResident(tileIndex: number): boolean {
+    return this.raw.isTileResident(tileIndex);
+  }
+
+  get residentTileCount(): number {
+    return this.raw.getResidentTileCount();
+  }
+
+  get residentBytes(): number {
+    return this.raw.getResidentBytes();
+  }
+
+  /**
+   * Whether the tile failed to load, and is not retried until reset
+   */
+  isTileFailed(tileIndex: number): boolean {
+    return this.raw.isTileFailed(tileIndex);
+  }
+
+  get failedTileCount(): number {
+    return this.raw.getFailedTileCount();
+  }
+
+  /**
+   * Lets failed tiles be loaded again, e.g. after the export data is fixed.
+   * @param tileIndex the tile to reset, or every failed tile if not provided
+   */
+  resetFailedTiles(tileIndex?: number): void {
+    this.raw.resetFailedTiles(tileIndex ?? -1);
+  }
+
+  /**
+   * Removes all tiles added by the streamer from the NavMesh.
+   */
+  unloadAll(): void {
+    this.raw.unloadAll();
+  }
+
+  /**
+   * Destroys the streamer. Resident tiles are left in the NavMesh, call `unloadAll` first to remove them.
+   */
+  destroy(): void {
+    this.raw.destroy();
+    Raw.destroy(this.raw);
+
+    if (this.loader) {
+      Raw.destroy(this.loader);
+    }
+  }
+}
@@ -456,6 +456,22 @@ export class NavMesh {
     return this.raw.setPolyArea(ref, area);
   }
 
+  /**
+   * Marks a tile as changed, invalidating cached paths that cross it.
+   * Changes made through NavMesh methods are tracked automatically, this is only needed after modifying the raw dtNavMesh directly.
+   * @param ref a tile reference, or a polygon reference within the tile.
+   */
+  markTileChanged(ref: number): void {
+    this.raw.markTileChanged(ref);
+  }
+
+  /**
+   * Returns the change counter of the tile at the given index, see `markTileChanged`.
+   */
+  getTileVersion(tileIndex: number): number {
+    return this.raw.getTileVersion(tileIndex);
+  }
+
   /**
    * Gets the user defined area for the specified polygon.
    * @param ref The polygon reference.
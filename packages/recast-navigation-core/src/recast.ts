@@ -907,6 +907,35 @@ export const rasterizeTriangles = (
   );
 };
 
+/**
+ * Marks walkable triangles by slope and rasterizes every chunk of the chunky tri mesh that overlaps the given xz bounds, in one call.
+ *
+ * Chunk ids and triangle areas are kept in native buffers that grow as needed, so there is no cap on overlapping chunks and no allocation per chunk.
+ *
+ * @returns the number of chunks rasterized, or -1 if rasterization failed
+ */
+export const rasterizeTileFromChunkyTriMesh = (
+  buildContext: RecastBuildContext,
+  verts: FloatArray,
+  chunkyTriMesh: RecastChunkyTriMesh,
+  boundsMin: Vector2Tuple,
+  boundsMax: Vector2Tuple,
+  walkableSlopeAngle: number,
+  walkableClimb: number,
+  heightfield: RecastHeightfield,
+): number => {
+  return Raw.ChunkyTriMeshUtils.rasterizeTileFromChunkyTriMesh(
+    buildContext.raw,
+    verts.raw,
+    chunkyTriMesh.raw,
+    boundsMin,
+    boundsMax,
+    walkableSlopeAngle,
+    walkableClimb,
+    heightfield.raw,
+  );
+};
+
 export const filterLowHangingWalkableObstacles = (
   buildContext: RecastBuildContext,
   walkableClimb: number,
@@ -1,6 +1,7 @@
 import type { NavMesh } from '../nav-mesh';
 import type { TileCache } from '../tile-cache';
 import { Raw } from '../raw';
+import { readNavMeshExport } from './navmesh-export';
 
 const exportImpl = (navMesh: NavMesh, tileCache?: TileCache): Uint8Array => {
   const navMeshExport = Raw.NavMeshExporter.exportNavMesh(
@@ -8,20 +9,31 @@ const exportImpl = (navMesh: NavMesh, tileCache?: TileCache): Uint8Array => {
     tileCache?.raw as never,
   );
 
-  const arrView = new Uint8Array(
-    Raw.Module.HEAPU8.buffer,
-    navMeshExport.dataPointer,
-    navMeshExport.size,
-  );
-
-  const data = new Uint8Array(navMeshExport.size);
-  data.set(arrView);
-  Raw.NavMeshExporter.freeNavMeshExport(navMeshExport);
+  return readNavMeshExport(navMeshExport);
+};
 
-  return data;
+export type ExportNavMeshOptions = {
+  /**
+   * Whether to compress each tile with FastLZ.
+   * Compressed exports are smaller, at the cost of decompressing tiles on import.
+   * @default false
+   */
+  compress?: boolean;
 };
 
-export const exportNavMesh = (navMesh: NavMesh): Uint8Array => {
+export const exportNavMesh = (
+  navMesh: NavMesh,
+  options?: ExportNavMeshOptions,
+): Uint8Array => {
+  if (options?.compress) {
+    // without a compressor the bundled FastLZ codec is used
+    const navMeshExport = Raw.NavMeshExporter.exportNavMeshCompressed(
+      navMesh.raw,
+    );
+
+    return readNavMeshExport(navMeshExport);
+  }
+
   return exportImpl(navMesh);
 };
 
@@ -31,3 +43,72 @@ export const exportTileCache = (
 ): Uint8Array => {
   return exportImpl(navMesh, tileCache);
 };
+
+export type ExportChunkCallback = (chunk: Uint8Array) => void;
+
+export type ExportStreamOptions = {
+  /**
+   * The maximum size of each chunk passed to the callback, in bytes.
+   * @default 65536
+   */
+  chunkSize?: number;
+};
+
+const exportStreamImpl = (
+  navMesh: NavMesh,
+  tileCache: TileCache | undefined,
+  onChunk: ExportChunkCallback,
+  options?: ExportStreamOptions,
+): number => {
+  const chunkSize = options?.chunkSize ?? 65536;
+
+  const sink = new Raw.Module.NavMeshExportSink();
+
+  sink.write = (dataPtr: number, size: number) => {
+    onChunk(Raw.Module.HEAPU8.subarray(dataPtr, dataPtr + size));
+  };
+
+  const size = Raw.NavMeshExporter.exportNavMeshToSink(
+    navMesh.raw,
+    tileCache?.raw as never,
+    sink as never,
+    chunkSize,
+  );
+
+  Raw.destroy(sink);
+
+  return size;
+};
+
+/**
+ * Exports a NavMesh in chunks without creating a full copy of the export in the wasm heap.
+ *
+ * The chunk passed to the callback is a view into the wasm heap and is only valid for the duration of the callback.
+ * Copy it with `chunk.slice()` if it needs to outlive the callback.
+ *
+ * @returns the total number of bytes written
+ */
+export const exportNavMeshStream = (
+  navMesh: NavMesh,
+  onChunk: ExportChunkCallback,
+  options?: ExportStreamOptions,
+): number => {
+  return exportStreamImpl(navMesh, undefined, onChunk, options);
+};
+
+/**
+ * Exports a NavMesh and TileCache in chunks without creating a full copy of the export in the wasm heap.
+ *
+ * The chunk passed to the callback is a view into the wasm heap and is only valid for the duration of the callback.
+ * Copy it with `chunk.slice()` if it needs to outlive the callback.
+ *
+ * @returns the total number of bytes written
+ */
+export const exportTileCacheStream = (
+  navMesh: NavMesh,
+  tileCache: TileCache,
+  onChunk: ExportChunkCallback,
+  options?: ExportStreamOptions,
+): number => {
+  return exportStreamImpl(navMesh, tileCache, onChunk, options);
+};
@@ -1,24 +1,7 @@
 import { NavMesh } from '../nav-mesh';
 import { Raw, type RawModule } from '../raw';
 import { TileCache, type TileCacheMeshProcess } from '../tile-cache';
-
-const createNavMeshExport = (data: Uint8Array) => {
-  const nDataBytes = data.length * data.BYTES_PER_ELEMENT;
-  const dataPtr = Raw.Module._malloc(nDataBytes);
-
-  const dataHeap = new Uint8Array(
-    Raw.Module.HEAPU8.buffer,
-    dataPtr,
-    nDataBytes,
-  );
-  dataHeap.set(data);
-
-  const navMeshExport = new Raw.Module.NavMeshExport();
-  navMeshExport.dataPointer = dataHeap.byteOffset;
-  navMeshExport.size = data.length;
-
-  return { navMeshExport, dataHeap };
-};
+import { createNavMeshExport } from './navmesh-export';
 
 export type ImportNavMeshResult = {
   navMesh: NavMesh;
@@ -27,9 +10,20 @@ export type ImportNavMeshResult = {
 export const importNavMesh = (data: Uint8Array): ImportNavMeshResult => {
   const { navMeshExport, dataHeap } = createNavMeshExport(data);
 
+  // tiles reference the copied buffer directly, the navmesh takes ownership of it
+  const inPlaceResult =
+    Raw.NavMeshImporter.importNavMeshInPlace(navMeshExport);
+
+  if (inPlaceResult.success) {
+    Raw.destroy(navMeshExport);
+
+    return { navMesh: new NavMesh(inPlaceResult.navMesh) };
+  }
+
   const result = Raw.NavMeshImporter.importNavMesh(navMeshExport, undefined!);
 
   Raw.Module._free(dataHeap.byteOffset);
+  Raw.destroy(navMeshExport);
 
   const navMesh = new NavMesh(result.navMesh);
 
@@ -0,0 +1,177 @@
+import { UnsignedCharArray } from '../arrays';
+import { statusSucceed } from '../detour';
+import { NavMesh } from '../nav-mesh';
+import { Raw, type RawModule } from '../raw';
+import { createNavMeshExport, readNavMeshExport } from './navmesh-export';
+
+/**
+ * Exports a NavMesh to the indexed container format.
+ *
+ * The indexed format stores a header and a tile directory followed by aligned tile payloads,
+ * so individual tiles can be located and loaded without parsing the whole export.
+ */
+export const exportNavMeshIndexed = (navMesh: NavMesh): Uint8Array => {
+  const navMeshExport = Raw.NavMeshExporter.exportNavMeshIndexed(navMesh.raw);
+
+  return readNavMeshExport(navMeshExport);
+};
+
+export type NavMeshIndexTile = {
+  tileX: number;
+  tileY: number;
+  layer: number;
+  tileRef: number;
+  /**
+   * The byte offset of the tile payload in the export
+   */
+  offset: number;
+  dataSize: number;
+  checksum: number;
+};
+
+export type NavMeshIndexLoadTileResult = {
+  success: boolean;
+  status: number;
+};
+
+/**
+ * Random-access reader for exports created with `exportNavMeshIndexed`.
+ *
+ * @example
+ * ```ts
+ * const index = new NavMeshIndex(data);
+ * const navMesh = index.createNavMesh();
+ *
+ * const tileIndex = index.findTile(tileX, tileY);
+ * if (tileIndex !== -1) {
+ *   index.loadTile(navMesh, tileIndex);
+ * }
+ * ```
+ */
+export class NavMeshIndex {
+  raw: RawModule.NavMeshIndex;
+
+  private navMeshExport: RawModule.NavMeshExport;
+
+  private dataHeap: Uint8Array;
+
+  /**
+   * @param data the indexed export. Tile payloads may be omitted if tiles are loaded with `loadTileData`,
+   * in which case the data must contain at least the header and tile directory, see `NavMeshIndex.getDirectorySize`.
+   */
+  constructor(data: Uint8Array) {
+    const { navMeshExport, dataHeap } = createNavMeshExport(data);
+
+    this.raw = new Raw.Module.NavMeshIndex();
+    this.navMeshExport = navMeshExport;
+    this.dataHeap = dataHeap;
+
+    if (!this.raw.init(navMeshExport)) {
+      this.destroy();
+      throw new Error('Failed to read indexed nav mesh export');
+    }
+  }
+
+  /**
+   * Returns the number of bytes at the start of an indexed export that hold the header and tile directory.
+   * @param prefix the start of an indexed export, at least large enough to hold the fixed size header
+   * @returns the size of the header and tile directory, or 0 if the data is not an indexed export
+   */
+  static getDirectorySize(prefix: Uint8Array): number {
+    const { navMeshExport, dataHeap } = createNavMeshExport(prefix);
+
+    const raw = new Raw.Module.NavMeshIndex();
+    const size = raw.getDirectorySize(navMeshExport);
+
+    Raw.destroy(raw);
+    Raw.destroy(navMeshExport);
+    Raw.Module._free(dataHeap.byteOffset);
+
+    return size;
+  }
+
+  get tileCount(): number {
+    return this.raw.getTileCount();
+  }
+
+  /**
+   * Returns the tile directory entry at the given index, or an entry of zeros if the index is out of range.
+   */
+  getTile(i: number): NavMeshIndexTile {
+    const entry = this.raw.getTile(i);
+
+    return {
+      tileX: entry.tileX,
+      tileY: entry.tileY,
+      layer: entry.layer,
+      tileRef: entry.tileRef,
+      offset: entry.offset,
+      dataSize: entry.dataSize,
+      checksum: entry.checksum,
+    };
+  }
+
+  /**
+   * Finds the directory index of the tile at the given tile coordinates.
+   * @returns the tile index, or -1 if the export does not contain the tile
+   */
+  findTile(tileX: number, tileY: number, layer = 0): number {
+    return this.raw.findTile(tileX, tileY, layer);
+  }
+
+  /**
+   * Creates an empty tiled NavMesh using the params stored in the export.
+   */
+  createNavMesh(): NavMesh {
+    const navMesh = new NavMesh();
+
+    if (!this.raw.initNavMesh(navMesh.raw)) {
+      navMesh.destroy();
+      throw new Error('Failed to initialize nav mesh from indexed export');
+    }
+
+    return navMesh;
+  }
+
+  /**
+   * Loads a tile from the export into the NavMesh, using the tile ref stored in the export.
+   * The tile payload is verified against the directory checksum before it is added.
+   */
+  loadTile(navMesh: NavMesh, i: number): NavMeshIndexLoadTileResult {
+    const status = this.raw.loadTile(navMesh.raw, i);
+
+    return {
+      success: statusSucceed(status),
+      status,
+    };
+  }
+
+  /**
+   * Loads a tile from a separately fetched payload, e.g. a ranged request for `offset` and `dataSize` of the tile.
+   * The payload is verified against the directory checksum before it is added.
+   */
+  loadTileData(
+    navMesh: NavMesh,
+    i: number,
+    data: Uint8Array,
+  ): NavMeshIndexLoadTileResult {
+    const array = new UnsignedCharArray();
+    array.copy(data);
+
+    const status = this.raw.loadTileData(navMesh.raw, i, array.raw);
+
+    array.destroy();
+
+    return {
+      success: statusSucceed(status),
+      status,
+    };
+  }
+
+  destroy(): void {
+    this.raw.destroy();
+    Raw.destroy(this.raw);
+    Raw.destroy(this.navMeshExport);
+    Raw.Module._free(this.dataHeap.byteOffset);
+  }
+}
@@ -0,0 +1,35 @@
+import { Raw, type RawModule } from '../raw';
+
+export const createNavMeshExport = (data: Uint8Array) => {
+  const nDataBytes = data.length * data.BYTES_PER_ELEMENT;
+  const dataPtr = Raw.Module._malloc(nDataBytes);
+
+  const dataHeap = new Uint8Array(
+    Raw.Module.HEAPU8.buffer,
+    dataPtr,
+    nDataBytes,
+  );
+  dataHeap.set(data);
+
+  const navMeshExport = new Raw.Module.NavMeshExport();
+  navMeshExport.dataPointer = dataHeap.byteOffset;
+  navMeshExport.size = data.length;
+
+  return { navMeshExport, dataHeap };
+};
+
+export const readNavMeshExport = (
+  navMeshExport: RawModule.NavMeshExport,
+): Uint8Array => {
+  const arrView = new Uint8Array(
+    Raw.Module.HEAPU8.buffer,
+    navMeshExport.dataPointer,
+    navMeshExport.size,
+  );
+
+  const data = new Uint8Array(navMeshExport.size);
+  data.set(arrView);
+  Raw.NavMeshExporter.freeNavMeshExport(navMeshExport);
+
+  return data;
+};
@@ -2,49 +2,22 @@ import {
   NavMesh,
   NavMeshCreateParams,
   Raw,
-  Recast,
   RecastBuildContext,
-  type RecastCompactHeightfield,
+  RecastCompactHeightfield,
   type RecastConfig,
-  type RecastContourSet,
-  type RecastHeightfield,
-  type RecastPolyMesh,
-  type RecastPolyMeshDetail,
-  TriangleAreasArray,
+  RecastContourSet,
+  RecastHeightfield,
+  RecastPolyMesh,
+  RecastPolyMeshDetail,
   TrianglesArray,
-  type UnsignedCharArray,
+  UnsignedCharArray,
   type Vector3Tuple,
   VerticesArray,
-  allocCompactHeightfield,
-  allocContourSet,
-  allocHeightfield,
-  allocPolyMesh,
-  allocPolyMeshDetail,
-  buildCompactHeightfield,
-  buildContours,
-  buildDistanceField,
-  buildPolyMesh,
-  buildPolyMeshDetail,
-  buildRegions,
-  calcGridSize,
-  createHeightfield,
-  createNavMeshData,
   createRcConfig,
-  erodeWalkableArea,
-  filterLedgeSpans,
-  filterLowHangingWalkableObstacles,
-  filterWalkableLowHeightSpans,
-  freeCompactHeightfield,
-  freeContourSet,
-  freeHeightfield,
-  freePolyMesh,
-  freePolyMeshDetail,
-  markWalkableTriangles,
-  rasterizeTriangles,
   recastConfigDefaults,
 } from '@recast-navigation/core';
 import type { Pretty } from '../types';
-import { type OffMeshConnectionGeneratorParams, getBoundingBox } from './common';
+import type { OffMeshConnectionGeneratorParams } from './common';
 
 export type SoloNavMeshGeneratorConfig = Pretty<
   Omit<RecastConfig, 'tileSize'> &
@@ -94,8 +67,27 @@ export type GenerateSoloNavMeshDataResult =
   | GenerateSoloNavMeshDataSuccessResult
   | GenerateSoloNavMeshDataFailResult;
 
+/**
+ * Errors of the native solo generator, indexed by the step it failed at
+ */
+const soloNavMeshGeneratorErrors = [
+  '',
+  'Could not create heightfield',
+  'Could not rasterize triangles',
+  'Failed to build compact data',
+  'Failed to erode walkable area',
+  'Failed to build distance field',
+  'Failed to build regions',
+  'Failed to create contours',
+  'Failed to triangulate contours',
+  'Failed to build detail mesh',
+  'Failed to create Detour navmesh data',
+];
+
 /**
  * Builds Solo NavMesh data from the given positions and indices.
+ *
+ * The Recast and Detour steps run in a single native call, so the cost of generating small navmeshes is the cost of Recast itself.
  * @param positions a flat array of positions
  * @param indices a flat array of indices
  * @param navMeshGeneratorConfig optional configuration for the NavMesh generator
@@ -114,71 +106,15 @@ export const generateSoloNavMeshData = (
     buildContext,
   };
 
-  const cleanup = () => {
-    if (keepIntermediates) return;
-
-    if (intermediates.heightfield) {
-      freeHeightfield(intermediates.heightfield);
-      intermediates.heightfield = undefined;
-    }
-
-    if (intermediates.compactHeightfield) {
-      freeCompactHeightfield(intermediates.compactHeightfield);
-      intermediates.compactHeightfield = undefined;
-    }
-
-    if (intermediates.contourSet) {
-      freeContourSet(intermediates.contourSet);
-      intermediates.contourSet = undefined;
-    }
-
-    if (intermediates.polyMesh) {
-      freePolyMesh(intermediates.polyMesh);
-      intermediates.polyMesh = undefined;
-    }
-
-    if (intermediates.polyMeshDetail) {
-      freePolyMeshDetail(intermediates.polyMeshDetail);
-      intermediates.polyMeshDetail = undefined;
-    }
-  };
-
-  const fail = (error: string): GenerateSoloNavMeshDataFailResult => {
-    cleanup();
-
-    return {
-      navMeshData: undefined,
-      success: false,
-      intermediates,
-      error,
-    };
-  };
-
   /* input geometry */
-  const vertices = positions as number[];
-  const numVertices = indices.length;
   const verticesArray = new VerticesArray();
-  verticesArray.copy(vertices);
+  verticesArray.copy(positions as number[]);
 
-  const triangles = indices as number[];
-  const numTriangles = indices.length / 3;
   const trianglesArray = new TrianglesArray();
-  trianglesArray.copy(triangles);
-
-  let bbMin: Vector3Tuple;
-  let bbMax: Vector3Tuple;
-
-  if (navMeshGeneratorConfig.bounds) {
-    bbMin = navMeshGeneratorConfig.bounds[0];
-    bbMax = navMeshGeneratorConfig.bounds[1];
-  } else {
-    const boundingBox = getBoundingBox(positions, indices);
-    bbMin = boundingBox.bbMin;
-    bbMax = boundingBox.bbMax;
-  }
+  trianglesArray.copy(indices as number[]);
 
   //
-  // Step 1. Initialize build config.
+  // Initialize build config. Bounds are calculated natively if not provided.
   //
   const config = {
     ...soloNavMeshGeneratorConfigDefaults,
@@ -195,246 +131,95 @@ export const generateSoloNavMeshData = (
       : rcConfig.cs * rcConfig.detailSampleDist;
   rcConfig.detailSampleMaxError = rcConfig.ch * rcConfig.detailSampleMaxError;
 
-  const gridSize = calcGridSize(bbMin, bbMax, rcConfig.cs);
-  rcConfig.width = gridSize.width;
-  rcConfig.height = gridSize.height;
+  if (navMeshGeneratorConfig.bounds) {
+    const [bbMin, bbMax] = navMeshGeneratorConfig.bounds;
 
-  //
-  // Step 2. Rasterize input polygon soup.
-  //
-  // Allocate voxel heightfield where we rasterize our input data to.
-  const heightfield = allocHeightfield();
-  intermediates.heightfield = heightfield;
-
-  if (
-    !createHeightfield(
-      buildContext,
-      heightfield,
-      rcConfig.width,
-      rcConfig.height,
-      bbMin,
-      bbMax,
-      rcConfig.cs,
-      rcConfig.ch,
-    )
-  ) {
-    return fail('Could not create heightfield');
+    for (let i = 0; i < 3; i++) {
+      rcConfig.set_bmin(i, bbMin[i]);
+      rcConfig.set_bmax(i, bbMax[i]);
+    }
   }
 
-  // Find triangles which are walkable based on their slope and rasterize them.
-  // If your input data is multiple meshes, you can transform them here, calculate
-  // the are type for each of the meshes and rasterize them.
-  const triangleAreasArray = new TriangleAreasArray();
-  triangleAreasArray.resize(numTriangles);
-
-  markWalkableTriangles(
-    buildContext,
-    rcConfig.walkableSlopeAngle,
-    verticesArray,
-    numVertices,
-    trianglesArray,
-    numTriangles,
-    triangleAreasArray,
-  );
+  const navMeshCreateParams = new NavMeshCreateParams();
+  navMeshCreateParams.setBuildBvTree(config.buildBvTree);
 
-  if (
-    !rasterizeTriangles(
-      buildContext,
-      verticesArray,
-      numVertices,
-      trianglesArray,
-      triangleAreasArray,
-      numTriangles,
-      heightfield,
-      rcConfig.walkableClimb,
-    )
-  ) {
-    return fail('Could not rasterize triangles');
+  if (navMeshGeneratorConfig.offMeshConnections) {
+    navMeshCreateParams.setOffMeshConnections(
+      navMeshGeneratorConfig.offMeshConnections,
+    );
   }
 
-  triangleAreasArray.destroy();
-  verticesArray.destroy();
-  trianglesArray.destroy();
-
   //
-  // Step 3. Filter walkables surfaces.
+  // Rasterize, filter, partition, build contours, poly mesh, detail mesh and Detour data.
   //
-  // Once all geoemtry is rasterized, we do initial pass of filtering to
-  // remove unwanted overhangs caused by the conservative rasterization
-  // as well as filter spans where the character cannot possibly stand.
-  filterLowHangingWalkableObstacles(
-    buildContext,
-    rcConfig.walkableClimb,
-    heightfield,
-  );
-  filterLedgeSpans(
-    buildContext,
-    rcConfig.walkableHeight,
-    rcConfig.walkableClimb,
-    heightfield,
-  );
-  filterWalkableLowHeightSpans(
-    buildContext,
-    rcConfig.walkableHeight,
-    heightfield,
+  const navMeshData = new UnsignedCharArray();
+  const generator = new Raw.Module.SoloNavMeshGenerator();
+
+  const error = generator.generate(
+    buildContext.raw,
+    verticesArray.raw,
+    trianglesArray.raw,
+    rcConfig,
+    !navMeshGeneratorConfig.bounds,
+    navMeshCreateParams.raw,
+    keepIntermediates,
+    navMeshData.raw,
   );
 
-  //
-  // Step 4. Partition walkable surface to simple regions.
-  //
-  // Compact the heightfield so that it is faster to handle from now on.
-  // This will result more cache coherent data as well as the neighbours
-  // between walkable cells will be calculated.
-  const compactHeightfield = allocCompactHeightfield();
-  intermediates.compactHeightfield = compactHeightfield;
-
-  if (
-    !buildCompactHeightfield(
-      buildContext,
-      rcConfig.walkableHeight,
-      rcConfig.walkableClimb,
-      heightfield,
-      compactHeightfield,
-    )
-  ) {
-    return fail('Failed to build compact data');
-  }
-
-  if (!keepIntermediates) {
-    freeHeightfield(heightfield);
-    intermediates.heightfield = undefined;
-  }
-
-  // Erode the walkable area by agent radius.
-  if (
-    !erodeWalkableArea(
-      buildContext,
-      rcConfig.walkableRadius,
-      compactHeightfield,
-    )
-  ) {
-    return fail('Failed to erode walkable area');
-  }
-
-  // (Optional) Mark areas
-  // markConvexPolyArea(...)
-
-  // Prepare for region partitioning, by calculating Distance field along the walkable surface.
-  if (!buildDistanceField(buildContext, compactHeightfield)) {
-    return fail('Failed to build distance field');
-  }
-
-  // Partition the walkable surface into simple regions without holes.
-  if (
-    !buildRegions(
-      buildContext,
-      compactHeightfield,
-      rcConfig.borderSize,
-      rcConfig.minRegionArea,
-      rcConfig.mergeRegionArea,
-    )
-  ) {
-    return fail('Failed to build regions');
-  }
-
-  //
-  // Step 5. Trace and simplify region contours.
-  //
-  const contourSet = allocContourSet();
-  intermediates.contourSet = contourSet;
-
-  if (
-    !buildContours(
-      buildContext,
-      compactHeightfield,
-      rcConfig.maxSimplificationError,
-      rcConfig.maxEdgeLen,
-      contourSet,
-      Recast.RC_CONTOUR_TESS_WALL_EDGES,
-    )
-  ) {
-    return fail('Failed to create contours');
-  }
-
-  //
-  // Step 6. Build polygons mesh from contours.
-  //
-  const polyMesh = allocPolyMesh();
-  intermediates.polyMesh = polyMesh;
-  if (
-    !buildPolyMesh(buildContext, contourSet, rcConfig.maxVertsPerPoly, polyMesh)
-  ) {
-    return fail('Failed to triangulate contours');
-  }
-
-  //
-  // Step 7. Create detail mesh which allows to access approximate height on each polygon.
-  //
-  const polyMeshDetail = allocPolyMeshDetail();
-  intermediates.polyMeshDetail = polyMeshDetail;
-  if (
-    !buildPolyMeshDetail(
-      buildContext,
-      polyMesh,
-      compactHeightfield,
-      rcConfig.detailSampleDist,
-      rcConfig.detailSampleMaxError,
-      polyMeshDetail,
-    )
-  ) {
-    return fail('Failed to build detail mesh');
-  }
-
-  if (!keepIntermediates) {
-    freeCompactHeightfield(compactHeightfield);
-    intermediates.compactHeightfield = undefined;
-
-    freeContourSet(contourSet);
-    intermediates.contourSet = undefined;
-  }
+  if (keepIntermediates) {
+    const heightfield = generator.getHeightfield();
+    const compactHeightfield = generator.getCompactHeightfield();
+    const contourSet = generator.getContourSet();
+    const polyMesh = generator.getPolyMesh();
+    const polyMeshDetail = generator.getPolyMeshDetail();
 
-  //
-  // Step 8. Create Detour data from Recast poly mesh.
-  //
-  for (let i = 0; i < polyMesh.npolys(); i++) {
-    if (polyMesh.areas(i) === Recast.RC_WALKABLE_AREA) {
-      polyMesh.setAreas(i, 0);
+    if (!Raw.isNull(heightfield)) {
+      intermediates.heightfield = new RecastHeightfield(heightfield);
     }
-    if (polyMesh.areas(i) === 0) {
-      polyMesh.setFlags(i, 1);
+
+    if (!Raw.isNull(compactHeightfield)) {
+      intermediates.compactHeightfield = new RecastCompactHeightfield(
+        compactHeightfield,
+      );
     }
-  }
 
-  const navMeshCreateParams = new NavMeshCreateParams();
+    if (!Raw.isNull(contourSet)) {
+      intermediates.contourSet = new RecastContourSet(contourSet);
+    }
 
-  navMeshCreateParams.setPolyMeshCreateParams(polyMesh);
-  navMeshCreateParams.setPolyMeshDetailCreateParams(polyMeshDetail);
+    if (!Raw.isNull(polyMesh)) {
+      intermediates.polyMesh = new RecastPolyMesh(polyMesh);
+    }
 
-  navMeshCreateParams.setWalkableHeight(rcConfig.walkableHeight * rcConfig.ch);
-  navMeshCreateParams.setWalkableRadius(rcConfig.walkableRadius * rcConfig.cs);
-  navMeshCreateParams.setWalkableClimb(rcConfig.walkableClimb * rcConfig.ch);
+    if (!Raw.isNull(polyMeshDetail)) {
+      intermediates.polyMeshDetail = new RecastPolyMeshDetail(polyMeshDetail);
+    }
 
-  navMeshCreateParams.setCellSize(rcConfig.cs);
-  navMeshCreateParams.setCellHeight(rcConfig.ch);
+    // freed by the caller with freeHeightfield and friends
+    generator.releaseIntermediates();
+  }
 
-  navMeshCreateParams.setBuildBvTree(config.buildBvTree);
+  generator.destroy();
+  Raw.destroy(generator);
 
-  if (navMeshGeneratorConfig.offMeshConnections) {
-    navMeshCreateParams.setOffMeshConnections(
-      navMeshGeneratorConfig.offMeshConnections,
-    );
-  }
+  verticesArray.destroy();
+  trianglesArray.destroy();
+  Raw.destroy(rcConfig);
+  Raw.destroy(navMeshCreateParams.raw);
 
-  const createNavMeshDataResult = createNavMeshData(navMeshCreateParams);
+  if (error !== 0) {
+    navMeshData.destroy();
 
-  if (!createNavMeshDataResult.success) {
-    return fail('Failed to create Detour navmesh data');
+    return {
+      navMeshData: undefined,
+      success: false,
+      intermediates,
+      error: soloNavMeshGeneratorErrors[error],
+    };
   }
 
-  cleanup();
-
   return {
-    navMeshData: createNavMeshDataResult.navMeshData,
+    navMeshData,
     success: true,
     intermediates,
   };
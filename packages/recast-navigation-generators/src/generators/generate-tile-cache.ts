@@ -1,5 +1,4 @@
 import {
-  ChunkIdsArray,
   Detour,
   DetourTileCacheParams,
   NavMesh,
@@ -15,7 +14,6 @@ import {
   TileCache,
   TileCacheData,
   TileCacheMeshProcess,
-  TriangleAreasArray,
   TrianglesArray,
   type UnsignedCharArray,
   type Vector2Tuple,
@@ -41,8 +39,7 @@ import {
   getHeightfieldLayerAreas,
   getHeightfieldLayerCons,
   getHeightfieldLayerHeights,
-  markWalkableTriangles,
-  rasterizeTriangles,
+  rasterizeTileFromChunkyTriMesh,
   recastConfigDefaults,
   statusFailed,
   vec3,
@@ -162,7 +159,6 @@ export const generateTileCache = (
 
   /* input geometry */
   const vertices = positions as number[];
-  const numVertices = indices.length;
   const verticesArray = new VerticesArray();
   verticesArray.copy(vertices);
 
@@ -382,63 +378,23 @@ export const generateTileCache = (
     const tbmin: Vector2Tuple = [tileBoundsMin[0], tileBoundsMin[2]];
     const tbmax: Vector2Tuple = [tileBoundsMax[0], tileBoundsMax[2]];
 
-    // TODO: Make grow when returning too many items.
-    const maxChunkIds = 512;
-    const chunkIdsArray = new ChunkIdsArray();
-    chunkIdsArray.resize(maxChunkIds);
-
-    const nChunksOverlapping = chunkyTriMesh.getChunksOverlappingRect(
+    // Find triangles which are walkable based on their slope and rasterize them,
+    // for every chunk of the chunky tri mesh that overlaps the tile.
+    const nChunksRasterized = rasterizeTileFromChunkyTriMesh(
+      buildContext,
+      verticesArray,
+      chunkyTriMesh,
       tbmin,
       tbmax,
-      chunkIdsArray,
-      maxChunkIds,
+      tileConfig.walkableSlopeAngle,
+      tileConfig.walkableClimb,
+      heightfield,
     );
 
-    if (nChunksOverlapping === 0) {
+    if (nChunksRasterized <= 0) {
       return { n: 0 };
     }
 
-    for (let i = 0; i < nChunksOverlapping; ++i) {
-      const nodeId = chunkIdsArray.get(i);
-      const node = chunkyTriMesh.nodes(nodeId);
-      const nNodeTris = node.n;
-
-      const nodeTrianglesArray = chunkyTriMesh.getNodeTris(nodeId);
-
-      const triangleAreasArray = new TriangleAreasArray();
-      triangleAreasArray.resize(nNodeTris);
-
-      // Find triangles which are walkable based on their slope and rasterize them.
-      // If your input data is multiple meshes, you can transform them here, calculate
-      // the are type for each of the meshes and rasterize them.
-      markWalkableTriangles(
-        buildContext,
-        tileConfig.walkableSlopeAngle,
-        verticesArray,
-        numVertices,
-        nodeTrianglesArray,
-        nNodeTris,
-        triangleAreasArray,
-      );
-
-      const success = rasterizeTriangles(
-        buildContext,
-        verticesArray,
-        numVertices,
-        nodeTrianglesArray,
-        triangleAreasArray,
-        nNodeTris,
-        heightfield,
-        tileConfig.walkableClimb,
-      );
-
-      triangleAreasArray.destroy();
-
-      if (!success) {
-        return { n: 0 };
-      }
-    }
-
     // Once all geometry is rasterized, we do initial pass of filtering to
     // remove unwanted overhangs caused by the conservative rasterization
     // as well as filter spans where the character cannot possibly stand.
@@ -1,5 +1,4 @@
 import {
-  ChunkIdsArray,
   Detour,
   type FloatArray,
   type IntArray,
@@ -18,7 +17,6 @@ import {
   type RecastHeightfield,
   type RecastPolyMesh,
   type RecastPolyMeshDetail,
-  TriangleAreasArray,
   TrianglesArray,
   type UnsignedCharArray,
   type Vector2Tuple,
@@ -49,8 +47,7 @@ import {
   freeHeightfield,
   freePolyMesh,
   freePolyMeshDetail,
-  markWalkableTriangles,
-  rasterizeTriangles,
+  rasterizeTileFromChunkyTriMesh,
   recastConfigDefaults,
   statusFailed,
   statusToReadableString,
@@ -143,6 +140,16 @@ export type TiledNavMeshGeneratorConfig = Pretty<
        * @default true
        */
       buildBvTree?: boolean;
+
+      /**
+       * The number of threads to build tiles on, including the calling thread. 0 uses every available core.
+       *
+       * If set, tiles are built by a native tiled generator in one call, in place of a `generateTileNavMeshData` call per tile.
+       * Only the `@recast-navigation/wasm/wasm-threads` build starts worker threads, other builds build tiles on the calling thread.
+       * Crowds and generators share the build's 8 prewarmed worker threads, so fewer threads are used while others hold them.
+       * The native generator does not keep tile intermediates, so this is ignored if `keepIntermediates` is set.
+       */
+      threads?: number;
     }
 >;
 
@@ -314,12 +321,6 @@ export const generateTileNavMeshData = (
     return failTileMesh('Could not create heightfield');
   }
 
-  // Allocate array that can hold triangle flags.
-  // If you have multiple meshes you need to process, allocate
-  // and array which can hold the max number of triangles you need to process.
-  const triAreas = new TriangleAreasArray();
-  triAreas.resize(chunkyTriMesh.maxTrisPerChunk());
-
   const tbmin: Vector2Tuple = [
     expandedTileBoundsMin[0],
     expandedTileBoundsMin[2],
@@ -329,61 +330,25 @@ export const generateTileNavMeshData = (
     expandedTileBoundsMax[2],
   ];
 
-  // TODO: Make grow when returning too many items.
-  const maxChunkIds = 512;
-  const chunkIdsArray = new ChunkIdsArray();
-  chunkIdsArray.resize(maxChunkIds);
-
-  const nChunksOverlapping = chunkyTriMesh.getChunksOverlappingRect(
+  // Find triangles which are walkable based on their slope and rasterize them,
+  // for every chunk of the chunky tri mesh that overlaps the tile.
+  const nChunksRasterized = rasterizeTileFromChunkyTriMesh(
+    buildContext,
+    positions,
+    chunkyTriMesh,
     tbmin,
     tbmax,
-    chunkIdsArray,
-    maxChunkIds,
+    tileConfig.walkableSlopeAngle,
+    tileConfig.walkableClimb,
+    heightfield,
   );
 
-  if (nChunksOverlapping === 0) {
-    return { success: true, intermediates: tileIntermediate };
+  if (nChunksRasterized < 0) {
+    return failTileMesh('Could not rasterize triangles');
   }
 
-  for (let i = 0; i < nChunksOverlapping; ++i) {
-    const nodeId = chunkIdsArray.get(i);
-    const node = chunkyTriMesh.nodes(nodeId);
-    const nNodeTris = node.n;
-
-    const nodeTrianglesArray = chunkyTriMesh.getNodeTris(nodeId);
-
-    const triangleAreasArray = new TriangleAreasArray();
-    triangleAreasArray.resize(nNodeTris);
-
-    // Find triangles which are walkable based on their slope and rasterize them.
-    // If your input data is multiple meshes, you can transform them here, calculate
-    // the are type for each of the meshes and rasterize them.
-    markWalkableTriangles(
-      buildContext,
-      tileConfig.walkableSlopeAngle,
-      positions,
-      indices.size,
-      nodeTrianglesArray,
-      nNodeTris,
-      triangleAreasArray,
-    );
-
-    const success = rasterizeTriangles(
-      buildContext,
-      positions,
-      indices.size,
-      nodeTrianglesArray,
-      triangleAreasArray,
-      nNodeTris,
-      heightfield,
-      tileConfig.walkableClimb,
-    );
-
-    triangleAreasArray.destroy();
-
-    if (!success) {
-      return failTileMesh('Could not rasterize triangles');
-    }
+  if (nChunksRasterized === 0) {
+    return { success: true, intermediates: tileIntermediate };
   }
 
   // Once all geometry is rasterized, we do initial pass of filtering to
@@ -729,6 +694,57 @@ export const generateTiledNavMesh = (
 
   buildContext.startTimer(Recast.RC_TIMER_TEMP);
 
+  if (generatorConfig.threads !== undefined && !keepIntermediates) {
+    for (let i = 0; i < 3; i++) {
+      rcConfig.set_bmin(i, bbMin[i]);
+      rcConfig.set_bmax(i, bbMax[i]);
+    }
+
+    const navMeshCreateParams = new NavMeshCreateParams();
+    navMeshCreateParams.setBuildBvTree(generatorConfig.buildBvTree);
+
+    if (generatorConfig.offMeshConnections) {
+      navMeshCreateParams.setOffMeshConnections(
+        generatorConfig.offMeshConnections,
+      );
+    }
+
+    const generator = new Raw.Module.TiledNavMeshGenerator();
+    generator.init(generatorConfig.threads);
+
+    generator.generate(
+      verticesArray.raw,
+      chunkyTriMesh.raw,
+      rcConfig,
+      navMeshCreateParams.raw,
+      navMesh.raw,
+    );
+
+    const failedTileCount = generator.getFailedTileCount();
+
+    if (failedTileCount > 0) {
+      buildContext.log(
+        Recast.RC_LOG_WARNING,
+        `Failed to build or add ${failedTileCount} tiles`,
+      );
+    }
+
+    generator.destroy();
+    Raw.destroy(generator);
+    Raw.destroy(navMeshCreateParams.raw);
+    Raw.destroy(rcConfig);
+
+    buildContext.stopTimer(Recast.RC_TIMER_TEMP);
+
+    cleanup();
+
+    return {
+      success: true,
+      navMesh,
+      intermediates,
+    };
+  }
+
   const lastBuiltTileBmin: Vector3Tuple = [0, 0, 0];
   const lastBuiltTileBmax: Vector3Tuple = [0, 0, 0];
 
@@ -3,3 +3,4 @@ export * from './generate-solo-nav-mesh';
 export * from './generate-tile-cache';
 export * from './generate-tiled-nav-mesh';
 export * from './merge-positions-and-indices';
+export * from './tiled-nav-mesh-builder';
@@ -0,0 +1,363 @@
+import {
+  NavMesh,
+  NavMeshCreateParams,
+  NavMeshParams,
+  Raw,
+  type RawModule,
+  TrianglesArray,
+  type Vector3Tuple,
+  VerticesArray,
+} from '@recast-navigation/core';
+import type { Pretty } from '../types';
+import { getBoundingBox } from './common';
+import {
+  type TiledNavMeshGeneratorConfig,
+  buildTiledNavMeshRcConfig,
+  tiledNavMeshGeneratorConfigDefaults,
+} from './generate-tiled-nav-mesh';
+
+export type TiledNavMeshBuilderConfig = Pretty<
+  TiledNavMeshGeneratorConfig & {
+    /**
+     * The size in bytes of the compact heightfield cache, 0 disables it.
+     *
+     * Cached tiles keep their compressed compact heightfield, so changing area volumes skips rasterization for them.
+     * The cache stays under the size during large rebuilds, tiles built once it is full evict the least recently used tiles after the build.
+     *
+     * @default 0
+     */
+    compactHeightfieldCacheSize?: number;
+  }
+>;
+
+/**
+ * Builds a tiled NavMesh and keeps its input geometry resident, so edits only rebuild the tiles they touch.
+ *
+ * Triangles are given ids in the order they are added, starting with the triangles passed to the constructor.
+ * Adding, removing or moving triangles marks the tiles overlapping them, including the border of each tile, as dirty.
+ * `update` rebuilds the dirty tiles and swaps them into the NavMesh.
+ *
+ * Area volumes mark areas on tiles after erosion, like `markBoxArea`, `markConvexPolyArea` and `markCylinderArea`.
+ * Polys in marked areas keep their area id and get flags 1. Marking `Recast.RC_NULL_AREA` cuts the volume out of the NavMesh.
+ *
+ * The NavMesh tile grid is fixed by the bounds given to the constructor, geometry outside of it is ignored.
+ * Pass `bounds` to leave room for geometry added later.
+ *
+ * ```ts
+ * const builder = new TiledNavMeshBuilder(positions, indices, { tileSize: 32 });
+ * const navMesh = builder.navMesh;
+ *
+ * const building = builder.addTriangles(buildingPositions, buildingIndices);
+ * builder.update();
+ * ```
+ */
+export class TiledNavMeshBuilder {
+  raw: RawModule.TiledNavMeshBuilder;
+
+  /**
+   * The NavMesh built and updated by the builder. It is not destroyed with the builder.
+   */
+  navMesh: NavMesh;
+
+  /**
+   * @param positions a flat array of positions
+   * @param indices a flat array of indices
+   * @param navMeshGeneratorConfig configuration for the NavMesh generator, as for `generateTiledNavMesh`. `threads` defaults to 1.
+   */
+  constructor(
+    positions: ArrayLike<number>,
+    indices: ArrayLike<number>,
+    navMeshGeneratorConfig: Partial<TiledNavMeshBuilderConfig> = {},
+  ) {
+    if (!Raw.Module) {
+      throw new Error(
+        '"init" must be called before using any recast-navigation-js APIs. See: https://github.com/isaac-mason/recast-navigation-js?tab=readme-ov-file#initialization',
+      );
+    }
+
+    const generatorConfig = {
+      ...tiledNavMeshGeneratorConfigDefaults,
+      ...navMeshGeneratorConfig,
+    };
+
+    let bbMin: Vector3Tuple;
+    let bbMax: Vector3Tuple;
+
+    if (navMeshGeneratorConfig.bounds) {
+      bbMin = navMeshGeneratorConfig.bounds[0];
+      bbMax = navMeshGeneratorConfig.bounds[1];
+    } else {
+      const boundingBox = getBoundingBox(positions, indices);
+      bbMin = boundingBox.bbMin;
+      bbMax = boundingBox.bbMax;
+    }
+
+    const {
+      config: rcConfig,
+      orig,
+      maxTiles,
+      maxPolysPerTile,
+    } = buildTiledNavMeshRcConfig({
+      recastConfig: generatorConfig,
+      navMeshBounds: [bbMin, bbMax],
+    });
+
+    for (let i = 0; i < 3; i++) {
+      rcConfig.set_bmin(i, bbMin[i]);
+      rcConfig.set_bmax(i, bbMax[i]);
+    }
+
+    const navMeshParams = NavMeshParams.create({
+      orig,
+      tileWidth: generatorConfig.tileSize * generatorConfig.cs,
+      tileHeight: generatorConfig.tileSize * generatorConfig.cs,
+      maxTiles,
+      maxPolys: maxPolysPerTile,
+    });
+
+    this.navMesh = new NavMesh();
+
+    if (!this.navMesh.initTiled(navMeshParams)) {
+      Raw.destroy(rcConfig);
+      this.navMesh.destroy();
+
+      throw new Error('Could not init nav mesh for tiled use');
+    }
+
+    const navMeshCreateParams = new NavMeshCreateParams();
+    navMeshCreateParams.setBuildBvTree(generatorConfig.buildBvTree);
+
+    if (generatorConfig.offMeshConnections) {
+      navMeshCreateParams.setOffMeshConnections(
+        generatorConfig.offMeshConnections,
+      );
+    }
+
+    const verticesArray = new VerticesArray();
+    verticesArray.copy(positions as number[]);
+
+    const trianglesArray = new TrianglesArray();
+    trianglesArray.copy(indices as number[]);
+
+    this.raw = new Raw.Module.TiledNavMeshBuilder();
+
+    const success = this.raw.init(
+      verticesArray.raw,
+      trianglesArray.raw,
+      generatorConfig.chunkyTriMeshTrisPerChunk,
+      rcConfig,
+      navMeshCreateParams.raw,
+      this.navMesh.raw,
+      generatorConfig.threads ?? 1,
+    );
+
+    verticesArray.destroy();
+    trianglesArray.destroy();
+    Raw.destroy(rcConfig);
+    Raw.destroy(navMeshCreateParams.raw);
+
+    if (!success) {
+      Raw.destroy(this.raw);
+      this.navMesh.destroy();
+
+      throw new Error('Failed to build chunky triangle mesh');
+    }
+
+    this.raw.setCompactHeightfieldCacheSize(
+      navMeshGeneratorConfig.compactHeightfieldCacheSize ?? 0,
+    );
+
+    this.raw.buildAllTiles();
+  }
+
+  /**
+   * Adds triangles.
+   * @param positions a flat array of positions
+   * @param indices a flat array of indices into positions
+   * @returns the id of the first added triangle, the ids of the rest follow. -1 if an index is out of range.
+   */
+  addTriangles(
+    positions: ArrayLike<number>,
+    indices: ArrayLike<number>,
+  ): number {
+    const verticesArray = new VerticesArray();
+    verticesArray.copy(positions as number[]);
+
+    const trianglesArray = new TrianglesArray();
+    trianglesArray.copy(indices as number[]);
+
+    const first = this.raw.addTriangles(verticesArray.raw, trianglesArray.raw);
+
+    verticesArray.destroy();
+    trianglesArray.destroy();
+
+    return first;
+  }
+
+  /**
+   * Removes triangles. Ids of removed triangles are not reused.
+   * @param first the id of the first triangle to remove
+   * @param count the number of triangles to remove
+   * @returns false if the range is out of bounds
+   */
+  removeTriangles(first: number, count: number): boolean {
+    return this.raw.removeTriangles(first, count);
+  }
+
+  /**
+   * Moves triangles to new positions.
+   * @param first the id of the first triangle to move
+   * @param positions the new positions, 3 vertices per triangle
+   * @returns false if the range is out of bounds or contains removed triangles
+   */
+  updateTriangles(first: number, positions: ArrayLike<number>): boolean {
+    const verticesArray = new VerticesArray();
+    verticesArray.copy(positions as number[]);
+
+    const success = this.raw.updateTriangles(first, verticesArray.raw);
+
+    verticesArray.destroy();
+
+    return success;
+  }
+
+  /**
+   * Marks the tiles overlapping the given bounds as dirty, to rebuild a region without a triangle edit.
+   */
+  markDirty([bmin, bmax]: [bmin: Vector3Tuple, bmax: Vector3Tuple]): void {
+    this.raw.markDirtyBounds(bmin, bmax);
+  }
+
+  /**
+   * Marks an area id on the spans inside a box.
+   * @returns the volume id, or -1 if the area id is above `Recast.RC_WALKABLE_AREA`
+   */
+  addBoxArea(
+    [bmin, bmax]: [bmin: Vector3Tuple, bmax: Vector3Tuple],
+    areaId: number,
+  ): number {
+    return this.raw.addBoxArea(bmin, bmax, areaId);
+  }
+
+  /**
+   * Marks an area id on the spans inside a convex polygon, extruded from minY to maxY.
+   * @returns the volume id, or -1 if the area id is above `Recast.RC_WALKABLE_AREA` or there are fewer than 3 vertices
+   */
+  addConvexArea(
+    vertices: Vector3Tuple[],
+    minY: number,
+    maxY: number,
+    areaId: number,
+  ): number {
+    const verticesArray = new VerticesArray();
+    verticesArray.copy(vertices.flat());
+
+    const volumeId = this.raw.addConvexArea(
+      verticesArray.raw,
+      minY,
+      maxY,
+      areaId,
+    );
+
+    verticesArray.destroy();
+
+    return volumeId;
+  }
+
+  /**
+   * Marks an area id on the spans inside a cylinder standing on the given position.
+   * @returns the volume id, or -1 if the area id is above `Recast.RC_WALKABLE_AREA`
+   */
+  addCylinderArea(
+    position: Vector3Tuple,
+    radius: number,
+    height: number,
+    areaId: number,
+  ): number {
+    return this.raw.addCylinderArea(position, radius, height, areaId);
+  }
+
+  /**
+   * Removes an area volume. Volume ids are not reused.
+   */
+  removeArea(volumeId: number): boolean {
+    return this.raw.removeArea(volumeId);
+  }
+
+  /**
+   * Rebuilds the dirty tiles and swaps them into the NavMesh. Tiles that are empty after the rebuild are removed.
+   * @returns the number of tiles added
+   */
+  update(): number {
+    return this.raw.rebuildDirtyTiles();
+  }
+
+  /**
+   * The number of tiles to be rebuilt by the next `update`
+   */
+  get dirtyTileCount(): number {
+    return this.raw.getDirtyTileCount();
+  }
+
+  /**
+   * The number of triangle ids handed out, including removed triangles
+   */
+  get triangleCount(): number {
+    return this.raw.getTriangleCount();
+  }
+
+  /**
+   * The size in bytes of the compact heightfield cache, 0 disables it. See `compactHeightfieldCacheSize` in the constructor config.
+   * Lowering the size evicts the least recently used heightfields.
+   */
+  get compactHeightfieldCacheSize(): number {
+    return this.raw.getCompactHeightfieldCacheSize();
+  }
+
+  set compactHeightfieldCacheSize(maxBytes: number) {
+    this.raw.setCompactHeightfieldCacheSize(maxBytes);
+  }
+
+  /**
+   * The compressed size in bytes of the cached compact heightfields
+   */
+  get compactHeightfieldCacheBytes(): number {
+    return this.raw.getCompactHeightfieldCacheBytes();
+  }
+
+  /**
+   * The most bytes the compact heightfield cache has held, including while tiles were built
+   */
+  get compactHeightfieldCachePeakBytes(): number {
+    return this.raw.getCompactHeightfieldCachePeakBytes();
+  }
+
+  /**
+   * The number of tiles with a cached compact heightfield
+   */
+  get cachedTileCount(): number {
+    return this.raw.getCachedTileCount();
+  }
+
+  /**
+   * Whether the tile has a cached compact heightfield
+   */
+  isTileCached(tileX: number, tileY: number): boolean {
+    return this.raw.isTileCached(tileX, tileY);
+  }
+
+  /**
+   * The number of tiles that failed to build or add in the last build
+   */
+  get failedTileCount(): number {
+    return this.raw.getFailedTileCount();
+  }
+
+  /**
+   * Destroys the builder and its copy of the input geometry. The NavMesh is not destroyed.
+   */
+  destroy(): void {
+    this.raw.destroy();
+    Raw.destroy(this.raw);
+  }
+}
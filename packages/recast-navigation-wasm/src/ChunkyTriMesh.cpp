@@ -1,5 +1,10 @@
 #include "./ChunkyTriMesh.h"
 
+#include <string.h>
+
+// Chunk ids reserved by the first tile query
+static const int MIN_CHUNK_IDS = 64;
+
 bool ChunkyTriMeshUtils::createChunkyTriMesh(const FloatArray *verts, const IntArray *tris, int ntris, int trisPerChunk, rcChunkyTriMesh *chunkyTriMesh)
 {
     return rcCreateChunkyTriMesh(verts->data, tris->data, ntris, trisPerChunk, chunkyTriMesh);
@@ -20,3 +25,48 @@ IntArray *ChunkyTriMeshUtils::getChunkyTriMeshNodeTris(rcChunkyTriMesh *chunkyTr
 
     return result;
 }
+
+int ChunkyTriMeshUtils::rasterizeTileFromChunkyTriMesh(rcContext *ctx, const FloatArray *verts, const rcChunkyTriMesh *chunkyTriMesh, float *tbmin, float *tbmax, float walkableSlopeAngle, int walkableClimb, rcHeightfield &heightfield)
+{
+    if (chunkyTriMesh->nnodes == 0)
+    {
+        return 0;
+    }
+
+    if (m_chunkIds.empty())
+    {
+        m_chunkIds.resize(MIN_CHUNK_IDS);
+    }
+
+    // The query stops at maxIds, so a full buffer may have cut chunks off. Grow and query again until it does not.
+    int nchunks = rcGetChunksOverlappingRect(chunkyTriMesh, tbmin, tbmax, m_chunkIds.data(), int(m_chunkIds.size()));
+
+    while (nchunks == int(m_chunkIds.size()) && nchunks < chunkyTriMesh->nnodes)
+    {
+        m_chunkIds.resize(rcMin(int(m_chunkIds.size()) * 2, chunkyTriMesh->nnodes));
+        nchunks = rcGetChunksOverlappingRect(chunkyTriMesh, tbmin, tbmax, m_chunkIds.data(), int(m_chunkIds.size()));
+    }
+
+    if (int(m_triAreas.size()) < chunkyTriMesh->maxTrisPerChunk)
+    {
+        m_triAreas.resize(chunkyTriMesh->maxTrisPerChunk);
+    }
+
+    const int nverts = verts->size / 3;
+
+    for (int i = 0; i < nchunks; ++i)
+    {
+        const rcChunkyTriMeshNode &node = chunkyTriMesh->nodes[m_chunkIds[i]];
+        const int *tris = &chunkyTriMesh->tris[node.i * 3];
+
+        memset(m_triAreas.data(), 0, node.n);
+        rcMarkWalkableTriangles(ctx, walkableSlopeAngle, verts->data, nverts, tris, node.n, m_triAreas.data());
+
+        if (!rcRasterizeTriangles(ctx, verts->data, nverts, tris, m_triAreas.data(), node.n, heightfield, walkableClimb))
+        {
+            return -1;
+        }
+    }
+
+    return nchunks;
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "../recastnavigation/Recast/Include/Recast.h"
 #include "../recastnavigation/RecastDemo/Include/ChunkyTriMesh.h"
 #include "./Arrays.h"
+#include <vector>
 
 class ChunkyTriMeshUtils
 {
@@ -11,4 +13,13 @@ public:
     int getChunksOverlappingRect(rcChunkyTriMesh *chunkyTriMesh, float *tbmin, float *tbmax, IntArray *ids, const int maxIds);
 
     IntArray *getChunkyTriMeshNodeTris(rcChunkyTriMesh *chunkyTriMesh, int nodeIndex);
+
+    // Marks walkable triangles by slope and rasterizes every chunk overlapping the xz rect tbmin, tbmax into the
+    // heightfield. Chunk ids and triangle areas are kept in buffers that grow as needed and are reused across calls.
+    // Returns the number of chunks rasterized, or -1 if rasterization failed.
+    int rasterizeTileFromChunkyTriMesh(rcContext *ctx, const FloatArray *verts, const rcChunkyTriMesh *chunkyTriMesh, float *tbmin, float *tbmax, float walkableSlopeAngle, int walkableClimb, rcHeightfield &heightfield);
+
+private:
+    std::vector<int> m_chunkIds;
+    std::vector<unsigned char> m_triAreas;
 };
@@ -1,5 +1,7 @@
 #include "./Crowd.h"
 
+#include <math.h>
+
 int CrowdUtils::getActiveAgentCount(dtCrowd *crowd)
 {
     return crowd->getActiveAgents(NULL, crowd->getAgentCount());
@@ -65,3 +67,276 @@ void CrowdUtils::agentTeleport(dtCrowd *crowd, int idx, const float *destination
 
     ag->targetState = DT_CROWDAGENT_TARGET_NONE;
 }
+
+int CrowdUtils::getActiveAgentStates(dtCrowd *crowd, FloatArray *states, IntArray *indices)
+{
+    const int maxAgents = crowd->getAgentCount();
+
+    if (states->size < maxAgents * CROWD_AGENT_STATE_STRIDE || states->isView)
+    {
+        states->resize(maxAgents * CROWD_AGENT_STATE_STRIDE);
+    }
+
+    if (indices->size < maxAgents || indices->isView)
+    {
+        indices->resize(maxAgents);
+    }
+
+    int count = 0;
+    for (int i = 0; i < maxAgents; ++i)
+    {
+        const dtCrowdAgent *agent = crowd->getAgent(i);
+        if (!agent->active)
+            continue;
+
+        float *state = &states->data[count * CROWD_AGENT_STATE_STRIDE];
+        dtVcopy(&state[0], agent->npos);
+        dtVcopy(&state[3], agent->vel);
+        dtVcopy(&state[6], agent->dvel);
+        state[9] = agent->state;
+        state[10] = agent->targetState;
+        dtVcopy(&state[11], agent->ncorners ? &agent->cornerVerts[0] : agent->npos);
+
+        indices->data[count] = i;
+        count++;
+    }
+
+    return count;
+}
+
+bool CrowdUtils::isActiveAgent(dtCrowd *crowd, int idx)
+{
+    return idx >= 0 && idx < crowd->getAgentCount() && crowd->getAgent(idx)->active;
+}
+
+int CrowdUtils::requestMoveTargets(dtCrowd *crowd, const IntArray *agentIndices, const FloatArray *targets, const float *halfExtents, const dtQueryFilter *filter)
+{
+    if (targets->size < agentIndices->size * 3)
+    {
+        return 0;
+    }
+
+    const dtNavMeshQuery *navQuery = crowd->getNavMeshQuery();
+
+    int applied = 0;
+    for (int i = 0; i < agentIndices->size; ++i)
+    {
+        const int idx = agentIndices->data[i];
+        if (!isActiveAgent(crowd, idx))
+            continue;
+
+        dtPolyRef ref = 0;
+        float nearest[3];
+        dtVcopy(nearest, &targets->data[i * 3]);
+
+        navQuery->findNearestPoly(&targets->data[i * 3], halfExtents, filter, &ref, nearest);
+
+        if (crowd->requestMoveTarget(idx, ref, nearest))
+        {
+            applied++;
+        }
+    }
+
+    return applied;
+}
+
+int CrowdUtils::requestMoveVelocities(dtCrowd *crowd, const IntArray *agentIndices, const FloatArray *velocities)
+{
+    if (velocities->size < agentIndices->size * 3)
+    {
+        return 0;
+    }
+
+    int applied = 0;
+    for (int i = 0; i < agentIndices->size; ++i)
+    {
+        const int idx = agentIndices->data[i];
+        if (!isActiveAgent(crowd, idx))
+            continue;
+
+        if (crowd->requestMoveVelocity(idx, &velocities->data[i * 3]))
+        {
+            applied++;
+        }
+    }
+
+    return applied;
+}
+
+int CrowdUtils::resetMoveTargets(dtCrowd *crowd, const IntArray *agentIndices)
+{
+    int applied = 0;
+    for (int i = 0; i < agentIndices->size; ++i)
+    {
+        const int idx = agentIndices->data[i];
+        if (!isActiveAgent(crowd, idx))
+            continue;
+
+        if (crowd->resetMoveTarget(idx))
+        {
+            applied++;
+        }
+    }
+
+    return applied;
+}
+
+int CrowdUtils::agentTeleports(dtCrowd *crowd, const IntArray *agentIndices, const FloatArray *destinations, const float *halfExtents, dtQueryFilter *filter)
+{
+    if (destinations->size < agentIndices->size * 3)
+    {
+        return 0;
+    }
+
+    int applied = 0;
+    for (int i = 0; i < agentIndices->size; ++i)
+    {
+        const int idx = agentIndices->data[i];
+        if (!isActiveAgent(crowd, idx))
+            continue;
+
+        agentTeleport(crowd, idx, &destinations->data[i * 3], halfExtents, filter);
+        applied++;
+    }
+
+    return applied;
+}
+
+bool CrowdStepper::init(dtCrowd *crowd, float fixedStep, int maxSubSteps)
+{
+    if (!crowd || fixedStep <= 0)
+    {
+        return false;
+    }
+
+    m_crowd = crowd;
+    m_fixedStep = fixedStep;
+    m_maxSubSteps = maxSubSteps > 0 ? maxSubSteps : 1;
+    m_accumulator = 0;
+    m_alpha = 0;
+
+    const int maxAgents = crowd->getAgentCount();
+    m_prev.assign(maxAgents * 3, 0);
+    m_tracked.assign(maxAgents, 0);
+    m_positions.resize(maxAgents * 3);
+
+    interpolate();
+
+    return true;
+}
+
+void CrowdStepper::setFixedStep(float fixedStep)
+{
+    if (fixedStep > 0)
+    {
+        m_fixedStep = fixedStep;
+    }
+}
+
+void CrowdStepper::setMaxSubSteps(int maxSubSteps)
+{
+    m_maxSubSteps = maxSubSteps > 0 ? maxSubSteps : 1;
+}
+
+int CrowdStepper::step(float elapsed)
+{
+    if (!m_crowd)
+    {
+        return 0;
+    }
+
+    m_accumulator += elapsed;
+
+    const int maxAgents = m_crowd->getAgentCount();
+
+    int substeps = 0;
+    while (m_accumulator >= m_fixedStep && substeps < m_maxSubSteps)
+    {
+        for (int i = 0; i < maxAgents; ++i)
+        {
+            const dtCrowdAgent *agent = m_crowd->getAgent(i);
+            if (!agent->active)
+                continue;
+
+            dtVcopy(&m_prev[i * 3], agent->npos);
+            m_tracked[i] = 1;
+        }
+
+        if (m_updater)
+        {
+            m_updater->update(m_fixedStep);
+        }
+        else
+        {
+            m_crowd->update(m_fixedStep, nullptr);
+        }
+
+        m_accumulator -= m_fixedStep;
+        substeps++;
+    }
+
+    if (m_accumulator >= m_fixedStep)
+    {
+        m_accumulator = fmodf(m_accumulator, m_fixedStep);
+    }
+
+    interpolate();
+
+    return substeps;
+}
+
+void CrowdStepper::interpolate()
+{
+    m_alpha = m_accumulator / m_fixedStep;
+
+    const int maxAgents = m_crowd->getAgentCount();
+    for (int i = 0; i < maxAgents; ++i)
+    {
+        const dtCrowdAgent *agent = m_crowd->getAgent(i);
+        if (!agent->active)
+        {
+            m_tracked[i] = 0;
+            continue;
+        }
+
+        float *prev = &m_prev[i * 3];
+        if (!m_tracked[i])
+        {
+            // Agents added since the last step start at their current position
+            dtVcopy(prev, agent->npos);
+            m_tracked[i] = 1;
+        }
+
+        dtVlerp(&m_positions.data[i * 3], prev, agent->npos, m_alpha);
+    }
+}
+
+void CrowdStepper::resetAgent(int idx)
+{
+    if (!m_crowd || idx < 0 || idx >= m_crowd->getAgentCount())
+    {
+        return;
+    }
+
+    const dtCrowdAgent *agent = m_crowd->getAgent(idx);
+    dtVcopy(&m_prev[idx * 3], agent->npos);
+    dtVcopy(&m_positions.data[idx * 3], agent->npos);
+    m_tracked[idx] = agent->active ? 1 : 0;
+}
+
+void CrowdStepper::resetAgents(const IntArray *agentIndices)
+{
+    for (int i = 0; i < agentIndices->size; ++i)
+    {
+        resetAgent(agentIndices->data[i]);
+    }
+}
+
+void CrowdStepper::destroy()
+{
+    m_crowd = nullptr;
+    m_updater = nullptr;
+    m_prev.clear();
+    m_tracked.clear();
+    m_positions.free();
+}
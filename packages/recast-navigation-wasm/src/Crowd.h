@@ -2,6 +2,13 @@
 
 #include "../recastnavigation/Detour/Include/DetourCommon.h"
 #include "../recastnavigation/DetourCrowd/Include/DetourCrowd.h"
+#include "./Arrays.h"
+#include "./CrowdUpdater.h"
+#include <vector>
+
+// Floats written per agent by CrowdUtils::getActiveAgentStates:
+// [x, y, z, vx, vy, vz, dvx, dvy, dvz, state, targetState, cornerX, cornerY, cornerZ]
+static const int CROWD_AGENT_STATE_STRIDE = 14;
 
 class CrowdUtils
 {
@@ -11,4 +18,84 @@ public:
     bool overOffMeshConnection(dtCrowd *crowd, int idx);
 
     void agentTeleport(dtCrowd *crowd, int idx, const float *destination, const float *halfExtents, dtQueryFilter *filter);
+
+    // Writes the state of every active agent into states, see CROWD_AGENT_STATE_STRIDE, and their agent indices into indices.
+    // The next corner is the agent position if the agent has no corners. Arrays are only grown, so they can be reused across calls.
+    // Returns the number of active agents.
+    int getActiveAgentStates(dtCrowd *crowd, FloatArray *states, IntArray *indices);
+
+    // Batch commands for the agents in agentIndices. Vectors are packed as [(x, y, z) * count].
+    // Inactive or out of range agents are skipped. Each returns the number of agents the command was applied to.
+
+    // Snaps each target to the nearest poly with the shared half extents and filter, then requests a move target
+    int requestMoveTargets(dtCrowd *crowd, const IntArray *agentIndices, const FloatArray *targets, const float *halfExtents, const dtQueryFilter *filter);
+
+    int requestMoveVelocities(dtCrowd *crowd, const IntArray *agentIndices, const FloatArray *velocities);
+
+    int resetMoveTargets(dtCrowd *crowd, const IntArray *agentIndices);
+
+    int agentTeleports(dtCrowd *crowd, const IntArray *agentIndices, const FloatArray *destinations, const float *halfExtents, dtQueryFilter *filter);
+
+private:
+    bool isActiveAgent(dtCrowd *crowd, int idx);
+};
+
+// Steps a crowd with a fixed time step, interpolating agent positions between the last two steps.
+// Interpolated positions are written to a persistent buffer indexed by agent index, [(x, y, z) * maxAgents].
+class CrowdStepper
+{
+public:
+    CrowdStepper() : m_crowd(nullptr), m_updater(nullptr), m_fixedStep(1.0f / 60.0f), m_maxSubSteps(10), m_accumulator(0), m_alpha(0) {}
+
+    bool init(dtCrowd *crowd, float fixedStep, int maxSubSteps);
+
+    void setFixedStep(float fixedStep);
+
+    void setMaxSubSteps(int maxSubSteps);
+
+    // Steps with the updater instead of dtCrowd::update, or with dtCrowd::update again if null
+    void setUpdater(CrowdUpdater *updater)
+    {
+        m_updater = updater;
+    }
+
+    // Adds elapsed to the accumulator and updates the crowd by whole fixed steps, up to maxSubSteps.
+    // Whole steps beyond the cap are dropped. Returns the number of steps taken.
+    int step(float elapsed);
+
+    // Snaps the interpolated position of an agent to its current position, e.g. after a teleport
+    void resetAgent(int idx);
+
+    void resetAgents(const IntArray *agentIndices);
+
+    float getAlpha() const
+    {
+        return m_alpha;
+    }
+
+    float getAccumulator() const
+    {
+        return m_accumulator;
+    }
+
+    FloatArray *getInterpolatedPositions()
+    {
+        return &m_positions;
+    }
+
+    void destroy();
+
+private:
+    void interpolate();
+
+    dtCrowd *m_crowd;
+    CrowdUpdater *m_updater;
+    float m_fixedStep;
+    int m_maxSubSteps;
+    float m_accumulator;
+    float m_alpha;
+
+    std::vector<float> m_prev;
+    std::vector<unsigned char> m_tracked;
+    FloatArray m_positions;
 };
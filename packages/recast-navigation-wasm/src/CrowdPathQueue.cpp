@@ -0,0 +1,198 @@
+#include "./CrowdPathQueue.h"
+
+#include "../recastnavigation/Detour/Include/DetourCommon.h"
+#include <string.h>
+
+// Updates a completed request is kept for before its slot is freed, as in dtPathQueue
+static const int MAX_KEEP_ALIVE = 2;
+
+bool CrowdPathQueue::init(int capacity, int maxPathSize, int maxSearchNodeCount, const dtNavMesh *nav)
+{
+    destroy();
+
+    if (capacity < 1 || maxPathSize < 1 || !nav)
+    {
+        return false;
+    }
+
+    m_navQuery = dtAllocNavMeshQuery();
+    if (!m_navQuery || dtStatusFailed(m_navQuery->init(nav, maxSearchNodeCount)))
+    {
+        destroy();
+        return false;
+    }
+
+    PathQuery empty;
+    memset(&empty, 0, sizeof(empty));
+    empty.ref = DT_PATHQ_INVALID;
+
+    m_queue.assign(capacity, empty);
+    m_paths.resize(size_t(capacity) * maxPathSize);
+    m_maxPathSize = maxPathSize;
+    m_queueHead = 0;
+
+    return true;
+}
+
+int CrowdPathQueue::update(int maxIters)
+{
+    const int capacity = getCapacity();
+    if (capacity == 0)
+    {
+        return 0;
+    }
+
+    // Search requests until there is nothing to search or maxIters iterations are used
+    int iterCount = maxIters;
+
+    for (int i = 0; i < capacity; ++i)
+    {
+        PathQuery &q = m_queue[m_queueHead % capacity];
+
+        if (q.ref == DT_PATHQ_INVALID)
+        {
+            m_queueHead++;
+            continue;
+        }
+
+        if (dtStatusSucceed(q.status) || dtStatusFailed(q.status))
+        {
+            // Free the slot if the result has not been read in a few updates
+            q.keepAlive++;
+            if (q.keepAlive > MAX_KEEP_ALIVE)
+            {
+                q.ref = DT_PATHQ_INVALID;
+                q.status = 0;
+            }
+
+            m_queueHead++;
+            continue;
+        }
+
+        if (q.status == 0)
+        {
+            q.status = m_navQuery->initSlicedFindPath(q.startRef, q.endRef, q.startPos, q.endPos, q.filter);
+        }
+
+        if (dtStatusInProgress(q.status))
+        {
+            int iters = 0;
+            q.status = m_navQuery->updateSlicedFindPath(iterCount, &iters);
+            iterCount -= iters;
+        }
+
+        if (dtStatusSucceed(q.status))
+        {
+            dtPolyRef *path = &m_paths[size_t(m_queueHead % capacity) * m_maxPathSize];
+            q.status = m_navQuery->finalizeSlicedFindPath(path, &q.npath, m_maxPathSize);
+        }
+
+        // The request in progress is continued next update
+        if (iterCount <= 0)
+            break;
+
+        m_queueHead++;
+    }
+
+    return maxIters - dtMax(iterCount, 0);
+}
+
+dtPathQueueRef CrowdPathQueue::request(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter)
+{
+    PathQuery *q = nullptr;
+    for (PathQuery &slot : m_queue)
+    {
+        if (slot.ref == DT_PATHQ_INVALID)
+        {
+            q = &slot;
+            break;
+        }
+    }
+
+    if (!q)
+    {
+        return DT_PATHQ_INVALID;
+    }
+
+    const dtPathQueueRef ref = m_nextHandle++;
+    if (m_nextHandle == DT_PATHQ_INVALID)
+        m_nextHandle++;
+
+    q->ref = ref;
+    dtVcopy(q->startPos, startPos);
+    q->startRef = startRef;
+    dtVcopy(q->endPos, endPos);
+    q->endRef = endRef;
+    q->status = 0;
+    q->npath = 0;
+    q->filter = filter;
+    q->keepAlive = 0;
+
+    return ref;
+}
+
+const CrowdPathQueue::PathQuery *CrowdPathQueue::findQuery(dtPathQueueRef ref) const
+{
+    if (ref == DT_PATHQ_INVALID)
+    {
+        return nullptr;
+    }
+
+    for (const PathQuery &q : m_queue)
+    {
+        if (q.ref == ref)
+            return &q;
+    }
+
+    return nullptr;
+}
+
+dtStatus CrowdPathQueue::getRequestStatus(dtPathQueueRef ref) const
+{
+    const PathQuery *q = findQuery(ref);
+    return q ? q->status : DT_FAILURE;
+}
+
+dtStatus CrowdPathQueue::getPathResult(dtPathQueueRef ref, dtPolyRef *path, int *pathSize, int maxPath)
+{
+    PathQuery *q = const_cast<PathQuery *>(findQuery(ref));
+    if (!q)
+    {
+        return DT_FAILURE;
+    }
+
+    const dtStatus details = q->status & DT_STATUS_DETAIL_MASK;
+
+    const int n = dtMin(q->npath, maxPath);
+    memcpy(path, &m_paths[size_t(q - m_queue.data()) * m_maxPathSize], sizeof(dtPolyRef) * n);
+    *pathSize = n;
+
+    // Free the slot for reuse
+    q->ref = DT_PATHQ_INVALID;
+    q->status = 0;
+
+    return details | DT_SUCCESS;
+}
+
+int CrowdPathQueue::getActiveCount() const
+{
+    int count = 0;
+    for (const PathQuery &q : m_queue)
+    {
+        if (q.ref != DT_PATHQ_INVALID)
+            count++;
+    }
+
+    return count;
+}
+
+void CrowdPathQueue::destroy()
+{
+    dtFreeNavMeshQuery(m_navQuery);
+    m_navQuery = nullptr;
+
+    m_queue.clear();
+    m_paths.clear();
+    m_maxPathSize = 0;
+    m_queueHead = 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "../recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+#include "../recastnavigation/DetourCrowd/Include/DetourPathQueue.h"
+#include <vector>
+
+// A sliced path request queue like dtPathQueue, with a configurable number of requests in flight where dtPathQueue
+// has a compile time limit of 8.
+//
+// Requests share one dtNavMeshQuery, and are searched one at a time in request order until the iteration budget of an
+// update is used. Completed requests keep their slot until their result is read, or for a few updates.
+class CrowdPathQueue
+{
+public:
+    CrowdPathQueue() : m_maxPathSize(0), m_nextHandle(1), m_queueHead(0), m_navQuery(nullptr)
+    {
+    }
+
+    ~CrowdPathQueue()
+    {
+        destroy();
+    }
+
+    bool init(int capacity, int maxPathSize, int maxSearchNodeCount, const dtNavMesh *nav);
+
+    // Searches requests for at most maxIters A* iterations, returns the iterations used
+    int update(int maxIters);
+
+    // Returns DT_PATHQ_INVALID if every slot is in use
+    dtPathQueueRef request(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter);
+
+    dtStatus getRequestStatus(dtPathQueueRef ref) const;
+
+    // Reads the path of a completed request and frees its slot
+    dtStatus getPathResult(dtPathQueueRef ref, dtPolyRef *path, int *pathSize, int maxPath);
+
+    int getCapacity() const
+    {
+        return int(m_queue.size());
+    }
+
+    // The number of slots in use, by requests being searched, waiting to be searched, or waiting to be read
+    int getActiveCount() const;
+
+    void destroy();
+
+private:
+    struct PathQuery
+    {
+        dtPathQueueRef ref;
+        float startPos[3];
+        float endPos[3];
+        dtPolyRef startRef;
+        dtPolyRef endRef;
+        int npath;
+        dtStatus status;
+        int keepAlive;
+        const dtQueryFilter *filter;
+    };
+
+    const PathQuery *findQuery(dtPathQueueRef ref) const;
+
+    std::vector<PathQuery> m_queue;
+
+    // m_maxPathSize polys per slot
+    std::vector<dtPolyRef> m_paths;
+    int m_maxPathSize;
+
+    dtPathQueueRef m_nextHandle;
+    int m_queueHead;
+    dtNavMeshQuery *m_navQuery;
+};
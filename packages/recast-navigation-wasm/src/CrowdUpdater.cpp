@@ -0,0 +1,1518 @@
+#include "./CrowdUpdater.h"
+
+#include "../recastnavigation/Detour/Include/DetourCommon.h"
+#include "../recastnavigation/Detour/Include/DetourMath.h"
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// Constants and helpers below are adapted from DetourCrowd.cpp, where they are internal
+// The path queue constants are CrowdPathQueueParams
+static const int MAX_COMMON_NODES = 512;
+
+// dtCrowd allocates agent corridors with this many polys
+static const int MAX_CORRIDOR = 256;
+
+static const int OPT_MAX_AGENTS = 1;
+static const int CHECK_LOOKAHEAD = 10;
+static const float COLLISION_RESOLVE_FACTOR = 0.7f;
+static const int COLLISION_ITERATIONS = 4;
+
+// Agents per chunk of a parallel phase
+static const int AGENT_GRAIN = 32;
+
+static inline double getTimeMs()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline int cellCoord(const float v, const float invCellSize)
+{
+    return (int)floorf(v * invCellSize);
+}
+
+static inline unsigned int hashCell(const int x, const int z, const unsigned int mask)
+{
+    return ((unsigned int)x * 73856093u ^ (unsigned int)z * 19349663u) & mask;
+}
+
+static float tween(const float t, const float t0, const float t1)
+{
+    return dtClamp((t - t0) / (t1 - t0), 0.0f, 1.0f);
+}
+
+static void integrate(dtCrowdAgent *ag, const float dt)
+{
+    // Fake dynamic constraint
+    const float maxDelta = ag->params.maxAcceleration * dt;
+    float dv[3];
+    dtVsub(dv, ag->nvel, ag->vel);
+    const float ds = dtVlen(dv);
+    if (ds > maxDelta)
+        dtVscale(dv, dv, maxDelta / ds);
+    dtVadd(ag->vel, ag->vel, dv);
+
+    if (dtVlen(ag->vel) > 0.0001f)
+        dtVmad(ag->npos, ag->npos, ag->vel, dt);
+    else
+        dtVset(ag->vel, 0, 0, 0);
+}
+
+static bool overOffmeshConnection(const dtCrowdAgent *ag, const float radius)
+{
+    if (!ag->ncorners)
+        return false;
+
+    const bool offMeshConnection = (ag->cornerFlags[ag->ncorners - 1] & DT_STRAIGHTPATH_OFFMESH_CONNECTION) ? true : false;
+    if (offMeshConnection)
+    {
+        const float distSq = dtVdist2DSqr(ag->npos, &ag->cornerVerts[(ag->ncorners - 1) * 3]);
+        if (distSq < radius * radius)
+            return true;
+    }
+
+    return false;
+}
+
+static float getDistanceToGoal(const dtCrowdAgent *ag, const float range)
+{
+    if (!ag->ncorners)
+        return range;
+
+    const bool endOfPath = (ag->cornerFlags[ag->ncorners - 1] & DT_STRAIGHTPATH_END) ? true : false;
+    if (endOfPath)
+        return dtMin(dtVdist2D(ag->npos, &ag->cornerVerts[(ag->ncorners - 1) * 3]), range);
+
+    return range;
+}
+
+static void calcSmoothSteerDirection(const dtCrowdAgent *ag, float *dir)
+{
+    if (!ag->ncorners)
+    {
+        dtVset(dir, 0, 0, 0);
+        return;
+    }
+
+    const int ip0 = 0;
+    const int ip1 = dtMin(1, ag->ncorners - 1);
+    const float *p0 = &ag->cornerVerts[ip0 * 3];
+    const float *p1 = &ag->cornerVerts[ip1 * 3];
+
+    float dir0[3], dir1[3];
+    dtVsub(dir0, p0, ag->npos);
+    dtVsub(dir1, p1, ag->npos);
+    dir0[1] = 0;
+    dir1[1] = 0;
+
+    const float len0 = dtVlen(dir0);
+    const float len1 = dtVlen(dir1);
+    if (len1 > 0.001f)
+        dtVscale(dir1, dir1, 1.0f / len1);
+
+    dir[0] = dir0[0] - dir1[0] * len0 * 0.5f;
+    dir[1] = 0;
+    dir[2] = dir0[2] - dir1[2] * len0 * 0.5f;
+
+    dtVnormalize(dir);
+}
+
+static void calcStraightSteerDirection(const dtCrowdAgent *ag, float *dir)
+{
+    if (!ag->ncorners)
+    {
+        dtVset(dir, 0, 0, 0);
+        return;
+    }
+
+    dtVsub(dir, &ag->cornerVerts[0], ag->npos);
+    dir[1] = 0;
+    dtVnormalize(dir);
+}
+
+static int addNeighbour(const int idx, const float dist, dtCrowdNeighbour *neis, const int nneis, const int maxNeis)
+{
+    // Insert neighbour based on the distance
+    dtCrowdNeighbour *nei = 0;
+    if (!nneis)
+    {
+        nei = &neis[nneis];
+    }
+    else if (dist >= neis[nneis - 1].dist)
+    {
+        if (nneis >= maxNeis)
+            return nneis;
+        nei = &neis[nneis];
+    }
+    else
+    {
+        int i;
+        for (i = 0; i < nneis; ++i)
+            if (dist <= neis[i].dist)
+                break;
+
+        const int tgt = i + 1;
+        const int n = dtMin(nneis - i, maxNeis - tgt);
+
+        if (n > 0)
+            memmove(&neis[tgt], &neis[i], sizeof(dtCrowdNeighbour) * n);
+        nei = &neis[i];
+    }
+
+    memset(nei, 0, sizeof(dtCrowdNeighbour));
+
+    nei->idx = idx;
+    nei->dist = dist;
+
+    return dtMin(nneis + 1, maxNeis);
+}
+
+// Inserts agents sorted by greatest key, keeping at most maxAgents
+template <typename Key>
+static int addToQueue(dtCrowdAgent *newag, dtCrowdAgent **agents, const int nagents, const int maxAgents, Key key)
+{
+    int slot = 0;
+    if (!nagents)
+    {
+        slot = nagents;
+    }
+    else if (key(newag) <= key(agents[nagents - 1]))
+    {
+        if (nagents >= maxAgents)
+            return nagents;
+        slot = nagents;
+    }
+    else
+    {
+        int i;
+        for (i = 0; i < nagents; ++i)
+            if (key(newag) >= key(agents[i]))
+                break;
+
+        const int tgt = i + 1;
+        const int n = dtMin(nagents - i, maxAgents - tgt);
+
+        if (n > 0)
+            memmove(&agents[tgt], &agents[i], sizeof(dtCrowdAgent *) * n);
+        slot = i;
+    }
+
+    agents[slot] = newag;
+
+    return dtMin(nagents + 1, maxAgents);
+}
+
+bool CrowdUpdater::init(NavMesh *navMesh, dtCrowd *crowd, int threadCount)
+{
+    destroy();
+
+    if (!navMesh || !navMesh->m_navMesh || !crowd)
+    {
+        return false;
+    }
+
+    m_crowd = crowd;
+    m_maxAgents = crowd->getAgentCount();
+
+    // dtCrowd sets its placement half extents from the max agent radius, and its grid cell size to 3 radii
+    dtVcopy(m_halfExtents, crowd->getQueryHalfExtents());
+    m_gridCellSize = m_halfExtents[0] / 2 * 3;
+
+    // Power of two bucket count, at least the agent count
+    int bucketCount = 1;
+    while (bucketCount < m_maxAgents)
+        bucketCount <<= 1;
+    m_bucketStarts.resize(bucketCount + 1);
+
+    // Results are merged with the current corridor in place
+    m_maxPathResult = m_pathQueueParams.maxPathResult;
+    m_pathResult.resize(MAX_CORRIDOR);
+    m_requestQueue.resize(m_pathQueueParams.capacity);
+    if (!m_pathQueue.init(m_pathQueueParams.capacity, m_maxPathResult, m_pathQueueParams.maxSearchNodes, navMesh->m_navMesh))
+    {
+        destroy();
+        return false;
+    }
+    m_pathQueueStats = CrowdPathQueueStats();
+
+    m_pool.init(threadCount);
+
+    m_contexts.resize(m_pool.getThreadCount());
+    for (ThreadContext &context : m_contexts)
+    {
+        context.velocitySampleCount = 0;
+
+        context.navQuery = dtAllocNavMeshQuery();
+        context.obstacleQuery = dtAllocObstacleAvoidanceQuery();
+
+        if (!context.navQuery || !context.obstacleQuery)
+        {
+            destroy();
+            return false;
+        }
+
+        if (dtStatusFailed(context.navQuery->init(navMesh->m_navMesh, MAX_COMMON_NODES)) || !context.obstacleQuery->init(6, 8))
+        {
+            destroy();
+            return false;
+        }
+    }
+
+    m_agents.resize(m_maxAgents);
+    for (int i = 0; i < m_maxAgents; ++i)
+    {
+        m_agents[i] = crowd->getEditableAgent(i);
+    }
+
+    dtCrowdAgentAnimation inactive;
+    memset(&inactive, 0, sizeof(inactive));
+    m_animations.assign(m_maxAgents, inactive);
+    m_waitTimes.assign(m_maxAgents, 0.0f);
+
+    m_activeAgents.reserve(m_maxAgents);
+    m_activeIndices.reserve(m_maxAgents);
+
+    const int skippedFeatures = DT_CROWD_OBSTACLE_AVOIDANCE | DT_CROWD_ANTICIPATE_TURNS | DT_CROWD_OPTIMIZE_TOPO;
+    const int straightLineOnly = skippedFeatures | DT_CROWD_SEPARATION | DT_CROWD_OPTIMIZE_VIS;
+    setLodTier(0, 1, 0, true);
+    setLodTier(1, 2, skippedFeatures, true);
+    setLodTier(2, 4, straightLineOnly, false);
+    setLodTier(3, 8, straightLineOnly, false);
+
+    m_agentLodTiers.assign(m_maxAgents, 0);
+    m_tick = 0;
+    resetProfile();
+
+    m_positions.resize(m_maxAgents * 3);
+    m_velocities.resize(m_maxAgents * 3);
+    m_desiredVelocities.resize(m_maxAgents * 3);
+    m_displacements.resize(m_maxAgents * 3);
+    m_radii.resize(m_maxAgents);
+    m_heights.resize(m_maxAgents);
+    m_states.resize(m_maxAgents);
+    m_updateFlags.resize(m_maxAgents);
+    m_fullUpdates.resize(m_maxAgents);
+    m_collisions.resize(m_maxAgents);
+    m_cells.resize(m_maxAgents * 2);
+    m_bucketAgents.resize(m_maxAgents);
+    m_neighbours.resize(m_maxAgents * DT_CROWDAGENT_MAX_NEIGHBOURS);
+    m_neighbourCounts.resize(m_maxAgents);
+
+    return true;
+}
+
+void CrowdUpdater::requestMoveTargetReplan(dtCrowdAgent *ag, dtPolyRef ref, const float *pos)
+{
+    ag->targetRef = ref;
+    dtVcopy(ag->targetPos, pos);
+    ag->targetPathqRef = DT_PATHQ_INVALID;
+    ag->targetReplan = true;
+
+    if (ag->targetRef)
+        ag->targetState = DT_CROWDAGENT_TARGET_REQUESTING;
+    else
+        ag->targetState = DT_CROWDAGENT_TARGET_FAILED;
+}
+
+int CrowdUpdater::checkPathValidity(float dt)
+{
+    dtNavMeshQuery *navQuery = m_contexts[0].navQuery;
+
+    int replans = 0;
+
+    for (dtCrowdAgent *ag : m_activeAgents)
+    {
+        if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+            continue;
+
+        const dtQueryFilter *filter = m_crowd->getFilter(ag->params.queryFilterType);
+
+        ag->targetReplanTime += dt;
+
+        bool replan = false;
+
+        // First check that the current location is valid
+        float agentPos[3];
+        dtPolyRef agentRef = ag->corridor.getFirstPoly();
+        dtVcopy(agentPos, ag->npos);
+        if (!navQuery->isValidPolyRef(agentRef, filter))
+        {
+            // Current location is not valid, try to reposition
+            float nearest[3];
+            dtVcopy(nearest, agentPos);
+            agentRef = 0;
+            navQuery->findNearestPoly(ag->npos, m_halfExtents, filter, &agentRef, nearest);
+            dtVcopy(agentPos, nearest);
+
+            if (!agentRef)
+            {
+                // Could not find location in navmesh, set state to invalid
+                ag->corridor.reset(0, agentPos);
+                ag->partial = false;
+                ag->boundary.reset();
+                ag->state = DT_CROWDAGENT_STATE_INVALID;
+                continue;
+            }
+
+            // Make sure the first polygon is valid, but leave other valid
+            // polygons in the path so that replanner can adjust the path better
+            ag->corridor.fixPathStart(agentRef, agentPos);
+            ag->boundary.reset();
+            dtVcopy(ag->npos, agentPos);
+
+            replan = true;
+        }
+
+        // If the agent does not have move target or is controlled by velocity, no need to recover the target nor replan
+        if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+            continue;
+
+        // Try to recover move request position
+        if (ag->targetState != DT_CROWDAGENT_TARGET_FAILED)
+        {
+            if (!navQuery->isValidPolyRef(ag->targetRef, filter))
+            {
+                // Current target is not valid, try to reposition
+                float nearest[3];
+                dtVcopy(nearest, ag->targetPos);
+                ag->targetRef = 0;
+                navQuery->findNearestPoly(ag->targetPos, m_halfExtents, filter, &ag->targetRef, nearest);
+                dtVcopy(ag->targetPos, nearest);
+                replan = true;
+            }
+
+            if (!ag->targetRef)
+            {
+                // Failed to reposition target, fail move request
+                ag->corridor.reset(agentRef, agentPos);
+                ag->partial = false;
+                ag->targetState = DT_CROWDAGENT_TARGET_NONE;
+            }
+        }
+
+        // If nearby corridor is not valid, replan
+        if (!ag->corridor.isValid(CHECK_LOOKAHEAD, navQuery, filter))
+        {
+            replan = true;
+        }
+
+        // If the end of the path is near and it is not the requested location, replan
+        if (ag->targetState == DT_CROWDAGENT_TARGET_VALID)
+        {
+            if (ag->targetReplanTime > m_pathQueueParams.replanDelay &&
+                ag->corridor.getPathCount() < CHECK_LOOKAHEAD &&
+                ag->corridor.getLastPoly() != ag->targetRef)
+                replan = true;
+        }
+
+        if (replan && ag->targetState != DT_CROWDAGENT_TARGET_NONE)
+        {
+            requestMoveTargetReplan(ag, ag->targetRef, ag->targetPos);
+            replans++;
+        }
+    }
+
+    return replans;
+}
+
+int CrowdUpdater::updateMoveRequest(float dt)
+{
+    dtNavMeshQuery *navQuery = m_contexts[0].navQuery;
+
+    CrowdPathQueueStats &stats = m_pathQueueStats;
+    stats = CrowdPathQueueStats();
+
+    float completedWaitTime = 0;
+
+    // Agents wait from entering the queue until their path result is read
+    for (int i = 0; i < m_maxAgents; ++i)
+    {
+        const dtCrowdAgent *ag = m_agents[i];
+        if (ag->active && (ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE || ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_PATH))
+            m_waitTimes[i] += dt;
+        else
+            m_waitTimes[i] = 0;
+    }
+
+    dtCrowdAgent **queue = m_requestQueue.data();
+    const int maxQueue = int(m_requestQueue.size());
+    int nqueue = 0;
+
+    const auto replanTime = [](const dtCrowdAgent *ag)
+    { return ag->targetReplanTime; };
+
+    // Fire off new requests
+    for (int i = 0; i < m_maxAgents; ++i)
+    {
+        dtCrowdAgent *ag = m_agents[i];
+        if (!ag->active)
+            continue;
+        if (ag->state == DT_CROWDAGENT_STATE_INVALID)
+            continue;
+        if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+            continue;
+
+        const dtQueryFilter *filter = m_crowd->getFilter(ag->params.queryFilterType);
+
+        if (ag->targetState == DT_CROWDAGENT_TARGET_REQUESTING)
+        {
+            const dtPolyRef *path = ag->corridor.getPath();
+            const int npath = ag->corridor.getPathCount();
+
+            static const int MAX_RES = 32;
+            float reqPos[3];
+            dtPolyRef reqPath[MAX_RES];
+            int reqPathCount = 0;
+
+            // Quick search towards the goal
+            static const int MAX_ITER = 20;
+            navQuery->initSlicedFindPath(path[0], ag->targetRef, ag->npos, ag->targetPos, filter);
+            navQuery->updateSlicedFindPath(MAX_ITER, 0);
+
+            dtStatus status = 0;
+            if (ag->targetReplan)
+            {
+                // Try to use existing steady path during replan if possible
+                status = navQuery->finalizeSlicedFindPathPartial(path, npath, reqPath, &reqPathCount, MAX_RES);
+            }
+            else
+            {
+                // Try to move towards target when goal changes
+                status = navQuery->finalizeSlicedFindPath(reqPath, &reqPathCount, MAX_RES);
+            }
+
+            if (!dtStatusFailed(status) && reqPathCount > 0)
+            {
+                if (reqPath[reqPathCount - 1] != ag->targetRef)
+                {
+                    // Partial path, constrain target position inside the last polygon
+                    status = navQuery->closestPointOnPoly(reqPath[reqPathCount - 1], ag->targetPos, reqPos, 0);
+                    if (dtStatusFailed(status))
+                        reqPathCount = 0;
+                }
+                else
+                {
+                    dtVcopy(reqPos, ag->targetPos);
+                }
+            }
+            else
+            {
+                reqPathCount = 0;
+            }
+
+            if (!reqPathCount)
+            {
+                // Could not find path, start the request from current location
+                dtVcopy(reqPos, ag->npos);
+                reqPath[0] = path[0];
+                reqPathCount = 1;
+            }
+
+            ag->corridor.setCorridor(reqPos, reqPath, reqPathCount);
+            ag->boundary.reset();
+            ag->partial = false;
+
+            if (reqPath[reqPathCount - 1] == ag->targetRef)
+            {
+                ag->targetState = DT_CROWDAGENT_TARGET_VALID;
+                ag->targetReplanTime = 0;
+            }
+            else
+            {
+                // The path is longer or potentially unreachable, full plan
+                ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE;
+            }
+        }
+
+        if (ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE)
+        {
+            nqueue = addToQueue(ag, queue, nqueue, maxQueue, replanTime);
+        }
+    }
+
+    for (int i = 0; i < nqueue; ++i)
+    {
+        dtCrowdAgent *ag = queue[i];
+        ag->targetPathqRef = m_pathQueue.request(ag->corridor.getLastPoly(), ag->targetRef, ag->corridor.getTarget(), ag->targetPos, m_crowd->getFilter(ag->params.queryFilterType));
+        if (ag->targetPathqRef != DT_PATHQ_INVALID)
+        {
+            ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_PATH;
+            stats.startedRequests++;
+        }
+    }
+
+    stats.iterations = m_pathQueue.update(m_pathQueueParams.maxIterations);
+
+    // Process path results
+    for (int i = 0; i < m_maxAgents; ++i)
+    {
+        dtCrowdAgent *ag = m_agents[i];
+        if (!ag->active)
+            continue;
+        if (ag->targetState != DT_CROWDAGENT_TARGET_WAITING_FOR_PATH)
+            continue;
+
+        dtStatus status = m_pathQueue.getRequestStatus(ag->targetPathqRef);
+        if (dtStatusFailed(status) || dtStatusSucceed(status))
+        {
+            stats.completedRequests++;
+            completedWaitTime += m_waitTimes[i];
+        }
+
+        if (dtStatusFailed(status))
+        {
+            // Path find failed, retry if the target location is still valid
+            ag->targetPathqRef = DT_PATHQ_INVALID;
+            if (ag->targetRef)
+                ag->targetState = DT_CROWDAGENT_TARGET_REQUESTING;
+            else
+                ag->targetState = DT_CROWDAGENT_TARGET_FAILED;
+            ag->targetReplanTime = 0;
+        }
+        else if (dtStatusSucceed(status))
+        {
+            const dtPolyRef *path = ag->corridor.getPath();
+            const int npath = ag->corridor.getPathCount();
+
+            float targetPos[3];
+            dtVcopy(targetPos, ag->targetPos);
+
+            dtPolyRef *res = m_pathResult.data();
+            bool valid = true;
+            int nres = 0;
+            status = m_pathQueue.getPathResult(ag->targetPathqRef, res, &nres, m_maxPathResult);
+            if (dtStatusFailed(status) || !nres)
+                valid = false;
+
+            ag->partial = dtStatusDetail(status, DT_PARTIAL_RESULT);
+
+            // The agent might have moved whilst the request was processed, so merge the result with the existing
+            // path. The request was issued from the last poly of the old path.
+            if (valid && path[npath - 1] != res[0])
+                valid = false;
+
+            if (valid)
+            {
+                if (npath > 1)
+                {
+                    // Put the old path in front of the result
+                    if ((npath - 1) + nres > MAX_CORRIDOR)
+                        nres = MAX_CORRIDOR - (npath - 1);
+
+                    memmove(res + npath - 1, res, sizeof(dtPolyRef) * nres);
+                    memcpy(res, path, sizeof(dtPolyRef) * (npath - 1));
+                    nres += npath - 1;
+
+                    // Remove trackbacks
+                    for (int j = 0; j < nres; ++j)
+                    {
+                        if (j - 1 >= 0 && j + 1 < nres && res[j - 1] == res[j + 1])
+                        {
+                            memmove(res + (j - 1), res + (j + 1), sizeof(dtPolyRef) * (nres - (j + 1)));
+                            nres -= 2;
+                            j -= 2;
+                        }
+                    }
+                }
+
+                if (res[nres - 1] != ag->targetRef)
+                {
+                    // Partial path, constrain target position inside the last polygon
+                    float nearest[3];
+                    status = m_contexts[0].navQuery->closestPointOnPoly(res[nres - 1], targetPos, nearest, 0);
+                    if (dtStatusSucceed(status))
+                        dtVcopy(targetPos, nearest);
+                    else
+                        valid = false;
+                }
+            }
+
+            if (valid)
+            {
+                ag->corridor.setCorridor(targetPos, res, nres);
+                ag->boundary.reset();
+                ag->targetState = DT_CROWDAGENT_TARGET_VALID;
+            }
+            else
+            {
+                ag->targetState = DT_CROWDAGENT_TARGET_FAILED;
+            }
+
+            ag->targetReplanTime = 0;
+        }
+    }
+
+    for (int i = 0; i < m_maxAgents; ++i)
+    {
+        const dtCrowdAgent *ag = m_agents[i];
+        if (!ag->active)
+            continue;
+        if (ag->targetState != DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE && ag->targetState != DT_CROWDAGENT_TARGET_WAITING_FOR_PATH)
+            continue;
+
+        stats.queueDepth++;
+        stats.maxWaitTime = dtMax(stats.maxWaitTime, m_waitTimes[i]);
+    }
+
+    stats.activeRequests = m_pathQueue.getActiveCount();
+    if (stats.completedRequests > 0)
+        stats.averageWaitTime = completedWaitTime / stats.completedRequests;
+
+    return stats.iterations;
+}
+
+int CrowdUpdater::updateTopologyOptimization(float dt)
+{
+    dtCrowdAgent *queue[OPT_MAX_AGENTS];
+    int nqueue = 0;
+
+    const auto optTime = [](const dtCrowdAgent *ag)
+    { return ag->topologyOptTime; };
+
+    for (size_t i = 0; i < m_activeAgents.size(); ++i)
+    {
+        dtCrowdAgent *ag = m_activeAgents[i];
+        if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+            continue;
+        if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+            continue;
+        if ((getUpdateFlags(ag, m_activeIndices[i]) & DT_CROWD_OPTIMIZE_TOPO) == 0)
+            continue;
+
+        ag->topologyOptTime += dt;
+        if (ag->topologyOptTime >= m_pathQueueParams.topologyOptimizationDelay)
+            nqueue = addToQueue(ag, queue, nqueue, OPT_MAX_AGENTS, optTime);
+    }
+
+    for (int i = 0; i < nqueue; ++i)
+    {
+        dtCrowdAgent *ag = queue[i];
+        ag->corridor.optimizePathTopology(m_contexts[0].navQuery, m_crowd->getFilter(ag->params.queryFilterType));
+        ag->topologyOptTime = 0;
+    }
+
+    return nqueue;
+}
+
+void CrowdUpdater::setGridCellSize(float cellSize)
+{
+    if (!m_crowd || !(cellSize > 0))
+    {
+        return;
+    }
+
+    // Tiny cells blow up the number of cells each neighbour query visits, so cells are at least the max agent radius
+    const float maxAgentRadius = m_halfExtents[0] / 2;
+    m_gridCellSize = dtMax(cellSize, maxAgentRadius);
+}
+
+void CrowdUpdater::gatherAgents()
+{
+    const int nagents = int(m_activeAgents.size());
+
+    for (int i = 0; i < nagents; ++i)
+    {
+        const dtCrowdAgent *ag = m_activeAgents[i];
+        dtVcopy(&m_positions[i * 3], ag->npos);
+        dtVcopy(&m_velocities[i * 3], ag->vel);
+        dtVcopy(&m_desiredVelocities[i * 3], ag->dvel);
+        m_radii[i] = ag->params.radius;
+        m_heights[i] = ag->params.height;
+        m_states[i] = ag->state;
+        m_neighbourCounts[i] = 0;
+
+        const int idx = m_activeIndices[i];
+        const CrowdLodTier &tier = m_lodTiers[m_agentLodTiers[idx]];
+        m_updateFlags[i] = (unsigned char)getUpdateFlags(ag, idx);
+        m_fullUpdates[i] = (m_tick + (unsigned int)idx) % (unsigned int)tier.updateInterval == 0;
+        m_collisions[i] = tier.collision;
+    }
+}
+
+void CrowdUpdater::buildGrid()
+{
+    const int nagents = int(m_activeAgents.size());
+    const int bucketCount = int(m_bucketStarts.size()) - 1;
+    const unsigned int mask = (unsigned int)bucketCount - 1;
+    const float invCellSize = 1.0f / m_gridCellSize;
+
+    // Counting sort of agents by bucket, agents keep their order within a bucket
+    memset(m_bucketStarts.data(), 0, sizeof(int) * m_bucketStarts.size());
+
+    for (int i = 0; i < nagents; ++i)
+    {
+        const int x = cellCoord(m_positions[i * 3], invCellSize);
+        const int z = cellCoord(m_positions[i * 3 + 2], invCellSize);
+        m_cells[i * 2] = x;
+        m_cells[i * 2 + 1] = z;
+        m_bucketStarts[hashCell(x, z, mask) + 1]++;
+    }
+
+    for (int b = 0; b < bucketCount; ++b)
+    {
+        m_bucketStarts[b + 1] += m_bucketStarts[b];
+    }
+
+    // m_bucketAgents is filled from each bucket start, which shifts the starts by one bucket
+    for (int i = 0; i < nagents; ++i)
+    {
+        const unsigned int bucket = hashCell(m_cells[i * 2], m_cells[i * 2 + 1], mask);
+        m_bucketAgents[m_bucketStarts[bucket]++] = i;
+    }
+
+    for (int b = bucketCount; b > 0; --b)
+    {
+        m_bucketStarts[b] = m_bucketStarts[b - 1];
+    }
+    m_bucketStarts[0] = 0;
+}
+
+int CrowdUpdater::queryNeighbours(int i, float range, dtCrowdNeighbour *result) const
+{
+    const float *pos = &m_positions[i * 3];
+    const float height = m_heights[i];
+
+    const unsigned int mask = (unsigned int)(m_bucketStarts.size() - 2);
+    const float invCellSize = 1.0f / m_gridCellSize;
+
+    const int minx = cellCoord(pos[0] - range, invCellSize);
+    const int maxx = cellCoord(pos[0] + range, invCellSize);
+    const int minz = cellCoord(pos[2] - range, invCellSize);
+    const int maxz = cellCoord(pos[2] + range, invCellSize);
+
+    int n = 0;
+
+    for (int z = minz; z <= maxz; ++z)
+    {
+        for (int x = minx; x <= maxx; ++x)
+        {
+            const unsigned int bucket = hashCell(x, z, mask);
+            for (int k = m_bucketStarts[bucket]; k < m_bucketStarts[bucket + 1]; ++k)
+            {
+                const int other = m_bucketAgents[k];
+
+                // Buckets are shared by cells with the same hash
+                if (other == i || m_cells[other * 2] != x || m_cells[other * 2 + 1] != z)
+                    continue;
+
+                const float *otherPos = &m_positions[other * 3];
+
+                float diff[3];
+                dtVsub(diff, pos, otherPos);
+                if (dtMathFabsf(diff[1]) >= (height + m_heights[other]) / 2.0f)
+                    continue;
+                diff[1] = 0;
+                const float distSqr = dtVlenSqr(diff);
+                if (distSqr > dtSqr(range))
+                    continue;
+
+                n = addNeighbour(other, distSqr, result, n, DT_CROWDAGENT_MAX_NEIGHBOURS);
+            }
+        }
+    }
+
+    return n;
+}
+
+void CrowdUpdater::updateNeighbours(int i, ThreadContext &context)
+{
+    dtCrowdAgent *ag = m_activeAgents[i];
+    if (ag->state != DT_CROWDAGENT_STATE_WALKING || !m_fullUpdates[i])
+        return;
+
+    const dtQueryFilter *filter = m_crowd->getFilter(ag->params.queryFilterType);
+
+    // Update the collision boundary after certain distance has been passed or if it has become invalid
+    const float updateThr = ag->params.collisionQueryRange * 0.25f;
+    if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) || !ag->boundary.isValid(context.navQuery, filter))
+    {
+        ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange, context.navQuery, filter);
+    }
+
+    ag->nneis = queryNeighbours(i, ag->params.collisionQueryRange, ag->neis);
+
+    int *neighbours = &m_neighbours[i * DT_CROWDAGENT_MAX_NEIGHBOURS];
+    for (int j = 0; j < ag->nneis; j++)
+    {
+        neighbours[j] = ag->neis[j].idx;
+        ag->neis[j].idx = m_activeIndices[neighbours[j]];
+    }
+    m_neighbourCounts[i] = ag->nneis;
+}
+
+void CrowdUpdater::updateCorners(int i, ThreadContext &context)
+{
+    dtCrowdAgent *ag = m_activeAgents[i];
+    if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+        return;
+    if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+        return;
+
+    const dtQueryFilter *filter = m_crowd->getFilter(ag->params.queryFilterType);
+
+    ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys, DT_CROWDAGENT_MAX_CORNERS, context.navQuery, filter);
+
+    // Agents between full updates only refresh their corners, to steer along their corridor
+    if (!m_fullUpdates[i])
+        return;
+
+    // Check to see if the corner after the next corner is directly visible, and short cut to there
+    if ((m_updateFlags[i] & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
+    {
+        const float *target = &ag->cornerVerts[dtMin(1, ag->ncorners - 1) * 3];
+        ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, context.navQuery, filter);
+    }
+}
+
+void CrowdUpdater::triggerOffMeshConnection(int i)
+{
+    dtCrowdAgent *ag = m_activeAgents[i];
+    const int idx = m_activeIndices[i];
+
+    if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+        return;
+    if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+        return;
+
+    const float triggerRadius = ag->params.radius * 2.25f;
+    if (!overOffmeshConnection(ag, triggerRadius))
+        return;
+
+    dtCrowdAgentAnimation *anim = &m_animations[idx];
+
+    // Adjust the path over the off-mesh connection. If it fails, path validity checks replan the path.
+    dtPolyRef refs[2];
+    if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners - 1], refs, anim->startPos, anim->endPos, m_contexts[0].navQuery))
+    {
+        dtVcopy(anim->initPos, ag->npos);
+        anim->polyRef = refs[1];
+        anim->active = true;
+        anim->t = 0.0f;
+        anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
+
+        ag->state = DT_CROWDAGENT_STATE_OFFMESH;
+        ag->ncorners = 0;
+        ag->nneis = 0;
+
+        m_states[i] = ag->state;
+        m_neighbourCounts[i] = 0;
+
+        const CrowdLodTier &tier = m_lodTiers[m_agentLodTiers[idx]];
+        m_updateFlags[i] = (unsigned char)getUpdateFlags(ag, idx);
+        m_collisions[i] = tier.collision;
+    }
+}
+
+void CrowdUpdater::updateSteering(int i)
+{
+    dtCrowdAgent *ag = m_activeAgents[i];
+
+    if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+        return;
+    if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
+        return;
+
+    // Agents between full updates steer straight at their next corner, without separation
+    const bool fullUpdate = m_fullUpdates[i];
+
+    float dvel[3] = {0, 0, 0};
+
+    if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+    {
+        dtVcopy(dvel, ag->targetPos);
+        ag->desiredSpeed = dtVlen(ag->targetPos);
+    }
+    else
+    {
+        if (fullUpdate && (m_updateFlags[i] & DT_CROWD_ANTICIPATE_TURNS))
+            calcSmoothSteerDirection(ag, dvel);
+        else
+            calcStraightSteerDirection(ag, dvel);
+
+        // Slow down at the end of the path
+        const float slowDownRadius = ag->params.radius * 2;
+        const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
+
+        ag->desiredSpeed = ag->params.maxSpeed;
+        dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
+    }
+
+    if (fullUpdate && (m_updateFlags[i] & DT_CROWD_SEPARATION))
+    {
+        const float separationDist = ag->params.collisionQueryRange;
+        const float invSeparationDist = 1.0f / separationDist;
+        const float separationWeight = ag->params.separationWeight;
+
+        float w = 0;
+        float disp[3] = {0, 0, 0};
+
+        const int *neighbours = &m_neighbours[i * DT_CROWDAGENT_MAX_NEIGHBOURS];
+        for (int j = 0; j < m_neighbourCounts[i]; ++j)
+        {
+            float diff[3];
+            dtVsub(diff, ag->npos, &m_positions[neighbours[j] * 3]);
+            diff[1] = 0;
+
+            const float distSqr = dtVlenSqr(diff);
+            if (distSqr < 0.00001f)
+                continue;
+            if (distSqr > dtSqr(separationDist))
+                continue;
+
+            const float dist = dtMathSqrtf(distSqr);
+            const float weight = separationWeight * (1.0f - dtSqr(dist * invSeparationDist));
+
+            dtVmad(disp, disp, diff, weight / dist);
+            w += 1.0f;
+        }
+
+        if (w > 0.0001f)
+        {
+            // Adjust desired velocity, and clamp it to the desired speed
+            dtVmad(dvel, dvel, disp, 1.0f / w);
+
+            const float speedSqr = dtVlenSqr(dvel);
+            const float desiredSqr = dtSqr(ag->desiredSpeed);
+            if (speedSqr > desiredSqr)
+                dtVscale(dvel, dvel, desiredSqr / speedSqr);
+        }
+    }
+
+    dtVcopy(ag->dvel, dvel);
+    dtVcopy(&m_desiredVelocities[i * 3], dvel);
+}
+
+void CrowdUpdater::planVelocity(int i, ThreadContext &context)
+{
+    dtCrowdAgent *ag = m_activeAgents[i];
+
+    if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+        return;
+
+    if (!m_fullUpdates[i] || !(m_updateFlags[i] & DT_CROWD_OBSTACLE_AVOIDANCE))
+    {
+        // If not using velocity planning, new velocity is directly the desired velocity
+        dtVcopy(ag->nvel, ag->dvel);
+        return;
+    }
+
+    dtObstacleAvoidanceQuery *obstacleQuery = context.obstacleQuery;
+    obstacleQuery->reset();
+
+    // Add neighbours as obstacles
+    const int *neighbours = &m_neighbours[i * DT_CROWDAGENT_MAX_NEIGHBOURS];
+    for (int j = 0; j < m_neighbourCounts[i]; ++j)
+    {
+        const int nei = neighbours[j];
+        obstacleQuery->addCircle(&m_positions[nei * 3], m_radii[nei], &m_velocities[nei * 3], &m_desiredVelocities[nei * 3]);
+    }
+
+    // Append neighbour segments as obstacles
+    for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
+    {
+        const float *s = ag->boundary.getSegment(j);
+        if (dtTriArea2D(ag->npos, s, s + 3) < 0.0f)
+            continue;
+        obstacleQuery->addSegment(s, s + 3);
+    }
+
+    const dtObstacleAvoidanceParams *params = m_crowd->getObstacleAvoidanceParams(ag->params.obstacleAvoidanceType);
+
+    context.velocitySampleCount += obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed, ag->vel, ag->dvel, ag->nvel, params, 0);
+}
+
+void CrowdUpdater::resolveCollision(int i)
+{
+    float *disp = &m_displacements[i * 3];
+    dtVset(disp, 0, 0, 0);
+
+    if (m_states[i] != DT_CROWDAGENT_STATE_WALKING || !m_collisions[i])
+        return;
+
+    const float *pos = &m_positions[i * 3];
+    const float *dvel = &m_desiredVelocities[i * 3];
+    const float radius = m_radii[i];
+    const int idx = m_activeIndices[i];
+
+    float w = 0;
+
+    const int *neighbours = &m_neighbours[i * DT_CROWDAGENT_MAX_NEIGHBOURS];
+    for (int j = 0; j < m_neighbourCounts[i]; ++j)
+    {
+        const int nei = neighbours[j];
+        const float neiRadius = m_radii[nei];
+
+        float diff[3];
+        dtVsub(diff, pos, &m_positions[nei * 3]);
+        diff[1] = 0;
+
+        float dist = dtVlenSqr(diff);
+        if (dist > dtSqr(radius + neiRadius))
+            continue;
+        dist = dtMathSqrtf(dist);
+
+        float pen = (radius + neiRadius) - dist;
+        if (dist < 0.0001f)
+        {
+            // Agents on top of each other, try to choose diverging separation directions
+            if (idx > m_activeIndices[nei])
+                dtVset(diff, -dvel[2], 0, dvel[0]);
+            else
+                dtVset(diff, dvel[2], 0, -dvel[0]);
+            pen = 0.01f;
+        }
+        else
+        {
+            pen = (1.0f / dist) * (pen * 0.5f) * COLLISION_RESOLVE_FACTOR;
+        }
+
+        dtVmad(disp, disp, diff, pen);
+
+        w += 1.0f;
+    }
+
+    if (w > 0.0001f)
+    {
+        const float iw = 1.0f / w;
+        dtVscale(disp, disp, iw);
+    }
+}
+
+void CrowdUpdater::movePosition(dtCrowdAgent *ag, ThreadContext &context)
+{
+    if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+        return;
+
+    // Move along navmesh, and get the valid constrained position back
+    ag->corridor.movePosition(ag->npos, context.navQuery, m_crowd->getFilter(ag->params.queryFilterType));
+    dtVcopy(ag->npos, ag->corridor.getPos());
+
+    // If not using path, truncate the corridor to just one poly
+    if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+    {
+        ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
+        ag->partial = false;
+    }
+}
+
+void CrowdUpdater::updateOffMeshAnimation(dtCrowdAgent *ag, int idx, float dt)
+{
+    dtCrowdAgentAnimation *anim = &m_animations[idx];
+
+    if (ag->state != DT_CROWDAGENT_STATE_OFFMESH)
+    {
+        // e.g. teleported while crossing a connection
+        anim->active = false;
+        return;
+    }
+
+    if (!anim->active)
+    {
+        // The connection was started by dtCrowd::update, which owns its animation
+        ag->state = DT_CROWDAGENT_STATE_WALKING;
+        return;
+    }
+
+    anim->t += dt;
+    if (anim->t > anim->tmax)
+    {
+        anim->active = false;
+        ag->state = DT_CROWDAGENT_STATE_WALKING;
+        return;
+    }
+
+    const float ta = anim->tmax * 0.15f;
+    const float tb = anim->tmax;
+    if (anim->t < ta)
+    {
+        const float u = tween(anim->t, 0.0, ta);
+        dtVlerp(ag->npos, anim->initPos, anim->startPos, u);
+    }
+    else
+    {
+        const float u = tween(anim->t, ta, tb);
+        dtVlerp(ag->npos, anim->startPos, anim->endPos, u);
+    }
+
+    dtVset(ag->vel, 0, 0, 0);
+    dtVset(ag->dvel, 0, 0, 0);
+}
+
+bool CrowdUpdater::setLodTier(int tier, int updateInterval, int disabledUpdateFlags, bool collision)
+{
+    if (tier < 0 || tier >= CROWD_MAX_LOD_TIERS || updateInterval < 1)
+    {
+        return false;
+    }
+
+    m_lodTiers[tier].updateInterval = updateInterval;
+    m_lodTiers[tier].disabledUpdateFlags = disabledUpdateFlags;
+    m_lodTiers[tier].collision = collision;
+
+    return true;
+}
+
+CrowdLodTier CrowdUpdater::getLodTier(int tier) const
+{
+    if (tier < 0 || tier >= CROWD_MAX_LOD_TIERS)
+    {
+        tier = 0;
+    }
+
+    return m_lodTiers[tier];
+}
+
+bool CrowdUpdater::setAgentLodTier(int idx, int tier)
+{
+    if (idx < 0 || idx >= m_maxAgents || tier < 0 || tier >= CROWD_MAX_LOD_TIERS)
+    {
+        return false;
+    }
+
+    m_agentLodTiers[idx] = (unsigned char)tier;
+
+    return true;
+}
+
+int CrowdUpdater::getAgentLodTier(int idx) const
+{
+    if (idx < 0 || idx >= m_maxAgents)
+    {
+        return 0;
+    }
+
+    return m_agentLodTiers[idx];
+}
+
+const dtCrowdAgentAnimation *CrowdUpdater::getAgentAnimation(int idx) const
+{
+    if (idx < 0 || idx >= m_maxAgents)
+    {
+        return nullptr;
+    }
+
+    return &m_animations[idx];
+}
+
+bool CrowdUpdater::setAgentAnimation(int idx, const dtCrowdAgentAnimation *animation)
+{
+    if (idx < 0 || idx >= m_maxAgents)
+    {
+        return false;
+    }
+
+    m_animations[idx] = *animation;
+
+    return true;
+}
+
+int CrowdUpdater::setLodTiersFromFocusPoints(const FloatArray *focusPoints, const FloatArray *tierDistances)
+{
+    const int pointCount = focusPoints->size / 3;
+    const int distanceCount = tierDistances->size;
+
+    int reduced = 0;
+
+    for (int idx = 0; idx < m_maxAgents; ++idx)
+    {
+        const dtCrowdAgent *ag = m_agents[idx];
+        if (!ag->active)
+            continue;
+
+        // Without focus points every agent gets full detail
+        float nearestSqr = pointCount > 0 ? FLT_MAX : 0.0f;
+        for (int p = 0; p < pointCount; ++p)
+        {
+            nearestSqr = dtMin(nearestSqr, dtVdist2DSqr(ag->npos, &focusPoints->data[p * 3]));
+        }
+
+        int tier = 0;
+        while (tier < distanceCount && nearestSqr >= dtSqr(tierDistances->data[tier]))
+            tier++;
+
+        tier = dtMin(tier, CROWD_MAX_LOD_TIERS - 1);
+
+        m_agentLodTiers[idx] = (unsigned char)tier;
+        if (tier > 0)
+            reduced++;
+    }
+
+    return reduced;
+}
+
+bool CrowdUpdater::setPathQueueParams(const CrowdPathQueueParams *params)
+{
+    if (params->capacity < 1 || params->maxIterations < 1 || params->maxSearchNodes < 1 || params->maxSearchNodes > 65535 ||
+        params->maxPathResult < 1 || params->replanDelay < 0 || params->topologyOptimizationDelay < 0)
+    {
+        return false;
+    }
+
+    m_pathQueueParams = *params;
+    m_pathQueueParams.maxPathResult = dtMin(params->maxPathResult, MAX_CORRIDOR);
+
+    if (!m_crowd)
+    {
+        return true;
+    }
+
+    m_maxPathResult = m_pathQueueParams.maxPathResult;
+    m_requestQueue.resize(m_pathQueueParams.capacity);
+
+    if (!m_pathQueue.init(m_pathQueueParams.capacity, m_maxPathResult, m_pathQueueParams.maxSearchNodes, m_crowd->getNavMeshQuery()->getAttachedNavMesh()))
+    {
+        return false;
+    }
+
+    // Requests in flight were dropped with the old queue
+    for (int i = 0; i < m_maxAgents; ++i)
+    {
+        dtCrowdAgent *ag = m_agents[i];
+        if (ag->active && ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_PATH)
+        {
+            ag->targetPathqRef = DT_PATHQ_INVALID;
+            ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE;
+        }
+    }
+
+    return true;
+}
+
+void CrowdUpdater::setProfilingEnabled(bool enabled)
+{
+    m_profiling = enabled;
+}
+
+void CrowdUpdater::resetProfile()
+{
+    memset(m_profile, 0, sizeof(m_profile));
+}
+
+CrowdUpdatePhaseProfile CrowdUpdater::getPhaseProfile(int phase) const
+{
+    if (phase < 0 || phase >= CROWD_UPDATE_PHASE_COUNT)
+    {
+        CrowdUpdatePhaseProfile empty = {0, 0};
+        return empty;
+    }
+
+    return m_profile[phase];
+}
+
+int CrowdUpdater::getProfile(FloatArray *profile) const
+{
+    const int size = CROWD_UPDATE_PHASE_COUNT * 2;
+    if (profile->size < size || profile->isView)
+    {
+        profile->resize(size);
+    }
+
+    for (int i = 0; i < CROWD_UPDATE_PHASE_COUNT; ++i)
+    {
+        profile->data[i * 2] = float(m_profile[i].time);
+        profile->data[i * 2 + 1] = float(m_profile[i].count);
+    }
+
+    return CROWD_UPDATE_PHASE_COUNT;
+}
+
+void CrowdUpdater::endPhase(int phase, int count, double &phaseStart)
+{
+    if (!m_profiling)
+    {
+        return;
+    }
+
+    const double now = getTimeMs();
+    m_profile[phase].time += now - phaseStart;
+    m_profile[phase].count += count;
+    phaseStart = now;
+}
+
+void CrowdUpdater::update(float dt)
+{
+    if (!m_crowd)
+    {
+        return;
+    }
+
+    m_activeAgents.clear();
+    m_activeIndices.clear();
+    for (int i = 0; i < m_maxAgents; ++i)
+    {
+        if (m_agents[i]->active)
+        {
+            m_activeAgents.push_back(m_agents[i]);
+            m_activeIndices.push_back(i);
+        }
+        else
+        {
+            m_animations[i].active = false;
+            m_agentLodTiers[i] = 0;
+        }
+    }
+
+    const int nagents = int(m_activeAgents.size());
+
+    for (ThreadContext &context : m_contexts)
+    {
+        context.velocitySampleCount = 0;
+    }
+
+    const double updateStart = m_profiling ? getTimeMs() : 0;
+    double phaseStart = updateStart;
+
+    const int replans = checkPathValidity(dt);
+    endPhase(CROWD_UPDATE_PHASE_PATH_VALIDITY, replans, phaseStart);
+
+    const int pathIterations = updateMoveRequest(dt);
+    endPhase(CROWD_UPDATE_PHASE_PATH_QUEUE, pathIterations, phaseStart);
+
+    const int optimized = updateTopologyOptimization(dt);
+    endPhase(CROWD_UPDATE_PHASE_TOPOLOGY, optimized, phaseStart);
+
+    gatherAgents();
+    buildGrid();
+
+    m_pool.parallelFor(nagents, AGENT_GRAIN, [this](int begin, int end, int threadIndex)
+                       {
+        for (int i = begin; i < end; ++i)
+            updateNeighbours(i, m_contexts[threadIndex]); });
+
+    if (m_profiling)
+    {
+        int neighbourPairs = 0;
+        for (int i = 0; i < nagents; ++i)
+            neighbourPairs += m_neighbourCounts[i];
+        endPhase(CROWD_UPDATE_PHASE_NEIGHBOURS, neighbourPairs, phaseStart);
+    }
+
+    m_pool.parallelFor(nagents, AGENT_GRAIN, [this](int begin, int end, int threadIndex)
+                       {
+        for (int i = begin; i < end; ++i)
+            updateCorners(i, m_contexts[threadIndex]); });
+    endPhase(CROWD_UPDATE_PHASE_CORNERS, nagents, phaseStart);
+
+    // Animations are shared, and few agents reach a connection in a step
+    for (int i = 0; i < nagents; ++i)
+    {
+        triggerOffMeshConnection(i);
+    }
+
+    m_pool.parallelFor(nagents, AGENT_GRAIN, [this](int begin, int end, int)
+                       {
+        for (int i = begin; i < end; ++i)
+            updateSteering(i); });
+    endPhase(CROWD_UPDATE_PHASE_STEERING, nagents, phaseStart);
+
+    m_pool.parallelFor(nagents, AGENT_GRAIN, [this](int begin, int end, int threadIndex)
+                       {
+        for (int i = begin; i < end; ++i)
+            planVelocity(i, m_contexts[threadIndex]); });
+
+    m_velocitySampleCount = 0;
+    for (const ThreadContext &context : m_contexts)
+    {
+        m_velocitySampleCount += context.velocitySampleCount;
+    }
+    endPhase(CROWD_UPDATE_PHASE_AVOIDANCE, m_velocitySampleCount, phaseStart);
+
+    // Separate from velocity planning, which reads the velocity of neighbours
+    m_pool.parallelFor(nagents, AGENT_GRAIN, [this, dt](int begin, int end, int)
+                       {
+        for (int i = begin; i < end; ++i)
+        {
+            dtCrowdAgent *ag = m_activeAgents[i];
+            if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+                continue;
+
+            integrate(ag, dt);
+            dtVcopy(&m_positions[i * 3], ag->npos);
+            dtVcopy(&m_velocities[i * 3], ag->vel);
+        } });
+    endPhase(CROWD_UPDATE_PHASE_INTEGRATE, nagents, phaseStart);
+
+    for (int iter = 0; iter < COLLISION_ITERATIONS; ++iter)
+    {
+        m_pool.parallelFor(nagents, AGENT_GRAIN, [this](int begin, int end, int)
+                           {
+            for (int i = begin; i < end; ++i)
+                resolveCollision(i); });
+
+        m_pool.parallelFor(nagents, AGENT_GRAIN, [this](int begin, int end, int)
+                           {
+            for (int i = begin; i < end; ++i)
+            {
+                if (m_states[i] != DT_CROWDAGENT_STATE_WALKING)
+                    continue;
+
+                dtCrowdAgent *ag = m_activeAgents[i];
+                dtVadd(&m_positions[i * 3], &m_positions[i * 3], &m_displacements[i * 3]);
+                dtVcopy(ag->npos, &m_positions[i * 3]);
+                dtVcopy(ag->disp, &m_displacements[i * 3]);
+            } });
+    }
+    endPhase(CROWD_UPDATE_PHASE_COLLISION, COLLISION_ITERATIONS, phaseStart);
+
+    m_pool.parallelFor(nagents, AGENT_GRAIN, [this](int begin, int end, int threadIndex)
+                       {
+        for (int i = begin; i < end; ++i)
+            movePosition(m_activeAgents[i], m_contexts[threadIndex]); });
+
+    for (int i = 0; i < nagents; ++i)
+    {
+        updateOffMeshAnimation(m_activeAgents[i], m_activeIndices[i], dt);
+    }
+    endPhase(CROWD_UPDATE_PHASE_MOVE, nagents, phaseStart);
+
+    if (m_profiling)
+    {
+        m_profile[CROWD_UPDATE_PHASE_TOTAL].time += getTimeMs() - updateStart;
+        m_profile[CROWD_UPDATE_PHASE_TOTAL].count++;
+    }
+
+    m_tick++;
+}
+
+void CrowdUpdater::destroy()
+{
+    m_pool.destroy();
+
+    for (ThreadContext &context : m_contexts)
+    {
+        dtFreeNavMeshQuery(context.navQuery);
+        dtFreeObstacleAvoidanceQuery(context.obstacleQuery);
+    }
+    m_contexts.clear();
+
+    m_agents.clear();
+    m_animations.clear();
+    m_waitTimes.clear();
+    m_activeAgents.clear();
+    m_activeIndices.clear();
+    m_pathQueue.destroy();
+    m_pathResult.clear();
+    m_requestQueue.clear();
+
+    m_positions.clear();
+    m_velocities.clear();
+    m_desiredVelocities.clear();
+    m_displacements.clear();
+    m_radii.clear();
+    m_heights.clear();
+    m_states.clear();
+    m_updateFlags.clear();
+    m_fullUpdates.clear();
+    m_collisions.clear();
+    m_agentLodTiers.clear();
+    m_cells.clear();
+    m_bucketStarts.clear();
+    m_bucketAgents.clear();
+    m_neighbours.clear();
+    m_neighbourCounts.clear();
+
+    m_crowd = nullptr;
+    m_maxAgents = 0;
+    m_velocitySampleCount = 0;
+}
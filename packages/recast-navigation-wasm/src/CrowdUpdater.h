@@ -0,0 +1,352 @@
+#pragma once
+
+#include "../recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+#include "../recastnavigation/DetourCrowd/Include/DetourCrowd.h"
+#include "./Arrays.h"
+#include "./CrowdPathQueue.h"
+#include "./NavMesh.h"
+#include "./WorkerPool.h"
+#include <vector>
+
+static const int CROWD_MAX_LOD_TIERS = 4;
+
+// A crowd level of detail tier, see CrowdUpdater::setLodTier
+struct CrowdLodTier
+{
+    // Agents get a full update every updateInterval updates, staggered by agent index. In between they refresh their
+    // corners and steer straight at the next one, skipping neighbours, separation, avoidance and path optimization.
+    int updateInterval;
+
+    // Agent UpdateFlags disabled in the tier, e.g. DT_CROWD_ANTICIPATE_TURNS for straight line steering
+    int disabledUpdateFlags;
+
+    // Whether agents resolve collisions with their neighbours
+    bool collision;
+};
+
+// Phases of CrowdUpdater::update, and the work counted for each
+enum CrowdUpdatePhase
+{
+    // Replans requested for agents with invalid corridors
+    CROWD_UPDATE_PHASE_PATH_VALIDITY,
+    // A* iterations run by the path queue
+    CROWD_UPDATE_PHASE_PATH_QUEUE,
+    // Corridors optimized
+    CROWD_UPDATE_PHASE_TOPOLOGY,
+    // Neighbour pairs found, including building the neighbour grid and boundary queries
+    CROWD_UPDATE_PHASE_NEIGHBOURS,
+    // Active agents
+    CROWD_UPDATE_PHASE_CORNERS,
+    // Active agents, including triggering off-mesh connections
+    CROWD_UPDATE_PHASE_STEERING,
+    // Obstacle avoidance velocity samples
+    CROWD_UPDATE_PHASE_AVOIDANCE,
+    // Active agents
+    CROWD_UPDATE_PHASE_INTEGRATE,
+    // Collision resolution passes
+    CROWD_UPDATE_PHASE_COLLISION,
+    // Active agents, including off-mesh connection animations
+    CROWD_UPDATE_PHASE_MOVE,
+    // Updates
+    CROWD_UPDATE_PHASE_TOTAL,
+    CROWD_UPDATE_PHASE_COUNT
+};
+
+// Summed over updates. Doubles, so long profiles neither overflow the count nor drop small time increments.
+struct CrowdUpdatePhaseProfile
+{
+    // Wall time in milliseconds
+    double time;
+    double count;
+};
+
+// Path queue budget of a CrowdUpdater, see CrowdUpdater::setPathQueueParams. Defaults match dtCrowd.
+struct CrowdPathQueueParams
+{
+    CrowdPathQueueParams()
+        : capacity(8), maxIterations(100), maxSearchNodes(4096), maxPathResult(256), replanDelay(1.0f), topologyOptimizationDelay(0.5f)
+    {
+    }
+
+    // Path requests in flight, and the most requests started per update
+    int capacity;
+
+    // A* iterations per update, shared by the requests in flight
+    int maxIterations;
+
+    // Search nodes of the path queue's dtNavMeshQuery, limiting the area a request can explore
+    int maxSearchNodes;
+
+    // Polys in a path result, at most the 256 polys of a dtCrowd agent corridor
+    int maxPathResult;
+
+    // Seconds an agent with a valid target waits before replanning a corridor that ends short of the target
+    float replanDelay;
+
+    // Seconds between corridor topology optimizations of an agent
+    float topologyOptimizationDelay;
+};
+
+// Path queue counters of the last CrowdUpdater::update
+struct CrowdPathQueueStats
+{
+    // Agents waiting for a slot in the queue or for their path, after the update
+    int queueDepth;
+
+    // Queue slots in use after the update
+    int activeRequests;
+
+    // Requests added to the queue
+    int startedRequests;
+
+    // Requests whose result was read, successful or failed
+    int completedRequests;
+
+    // A* iterations run
+    int iterations;
+
+    // Longest time an agent still waiting has waited, in seconds
+    float maxWaitTime;
+
+    // Mean time from queueing to result of the completed requests, in seconds
+    float averageWaitTime;
+};
+
+// Updates a dtCrowd in place of dtCrowd::update, splitting the per agent phases across a WorkerPool.
+//
+// The update follows dtCrowd::update phase by phase. Path validity checks, path requests, topology optimization,
+// the neighbour grid and off-mesh connections run on the calling thread. Boundary and neighbour queries, corner finding,
+// steering, obstacle avoidance sampling, integration, collision resolution and corridor movement run in parallel.
+//
+// Each thread has its own dtNavMeshQuery and dtObstacleAvoidanceQuery, and a parallel phase only writes the agent it
+// processes, reading other agents as left by the previous phase. Results are the same for any number of threads.
+//
+// Agents stay in the dtCrowd, so CrowdAgent and CrowdUtils work as before. Hot agent state is gathered into contiguous
+// arrays each update, which neighbour queries, steering, avoidance and collision resolution read instead of the large
+// dtCrowdAgent structs. Neighbours come from a hashed uniform grid with a configurable cell size, and are the nearest
+// agents in range, where dtCrowd picks them from the first 32 agents found in its proximity grid.
+//
+// Agents can be given level of detail tiers, which update them less often and with fewer features.
+//
+// Path requests go through a path queue with a configurable capacity and iteration budget, which reports counters.
+//
+// The updater has its own path queue and off-mesh connection animations, so a crowd should be updated either with
+// dtCrowd::update or with an updater, not both.
+class CrowdUpdater
+{
+public:
+    CrowdUpdater() : m_crowd(nullptr), m_maxAgents(0), m_maxPathResult(0), m_gridCellSize(1), m_tick(0), m_velocitySampleCount(0), m_profiling(false)
+    {
+        m_pathQueueStats = CrowdPathQueueStats();
+        resetProfile();
+    }
+
+    ~CrowdUpdater()
+    {
+        destroy();
+    }
+
+    // threadCount includes the calling thread, 0 uses every available core. Single threaded builds always use one thread.
+    bool init(NavMesh *navMesh, dtCrowd *crowd, int threadCount);
+
+    void update(float dt);
+
+    int getThreadCount() const
+    {
+        return m_pool.getThreadCount();
+    }
+
+    // The thread count used for a threadCount of 0, 1 in single threaded builds
+    int getMaxThreadCount() const
+    {
+        return WorkerPool::getMaxThreadCount();
+    }
+
+    // Sets the neighbour grid cell size, after init. Defaults to 3 times the crowd's max agent radius, like dtCrowd.
+    // Sizes below the max agent radius are clamped to it.
+    // Cells around the collision query range of agents keep the number of agents tested per query low.
+    void setGridCellSize(float cellSize);
+
+    float getGridCellSize() const
+    {
+        return m_gridCellSize;
+    }
+
+    // Configures a level of detail tier. Tier 0 is a full update by default. Tiers 1, 2 and 3 update every 2nd, 4th and
+    // 8th step. Tier 1 disables obstacle avoidance, turn anticipation and topology optimization, tiers 2 and 3 also
+    // disable separation, visibility optimization and collisions.
+    bool setLodTier(int tier, int updateInterval, int disabledUpdateFlags, bool collision);
+
+    CrowdLodTier getLodTier(int tier) const;
+
+    bool setAgentLodTier(int idx, int tier);
+
+    int getAgentLodTier(int idx) const;
+
+    // Sets the tier of every active agent from its 2D distance to the nearest focus point, packed as [(x, y, z) * count].
+    // Agents closer than tierDistances[i] get tier i, and agents beyond every distance get the tier after the last distance.
+    // Tiers are capped to the last tier. Returns the number of agents given a tier other than 0.
+    int setLodTiersFromFocusPoints(const FloatArray *focusPoints, const FloatArray *tierDistances);
+
+    // Off-mesh connection animation state, for crowd snapshots
+    const dtCrowdAgentAnimation *getAgentAnimation(int idx) const;
+
+    bool setAgentAnimation(int idx, const dtCrowdAgentAnimation *animation);
+
+    // The update count, which staggers level of detail updates
+    unsigned int getTick() const
+    {
+        return m_tick;
+    }
+
+    void setTick(unsigned int tick)
+    {
+        m_tick = tick;
+    }
+
+    // Configures the path queue and replan intervals, may be called before or after init. Requests in flight are
+    // queued again if the queue is reinitialized. maxPathResult is capped to the dtCrowd corridor size.
+    bool setPathQueueParams(const CrowdPathQueueParams *params);
+
+    CrowdPathQueueParams getPathQueueParams() const
+    {
+        return m_pathQueueParams;
+    }
+
+    CrowdPathQueueStats getPathQueueStats() const
+    {
+        return m_pathQueueStats;
+    }
+
+    // The number of obstacle avoidance velocity samples taken in the last update
+    int getVelocitySampleCount() const
+    {
+        return m_velocitySampleCount;
+    }
+
+    // Records wall time and work counts per update phase while enabled. Off by default.
+    void setProfilingEnabled(bool enabled);
+
+    bool isProfilingEnabled() const
+    {
+        return m_profiling;
+    }
+
+    // Profiles are summed over updates until reset, the total phase counts updates
+    void resetProfile();
+
+    CrowdUpdatePhaseProfile getPhaseProfile(int phase) const;
+
+    // Writes [time, count] for each phase, returns the phase count
+    int getProfile(FloatArray *profile) const;
+
+    void destroy();
+
+private:
+    struct ThreadContext
+    {
+        dtNavMeshQuery *navQuery;
+        dtObstacleAvoidanceQuery *obstacleQuery;
+        int velocitySampleCount;
+    };
+
+    // Return their work counts for profiling
+    int checkPathValidity(float dt);
+
+    int updateMoveRequest(float dt);
+
+    int updateTopologyOptimization(float dt);
+
+    void requestMoveTargetReplan(dtCrowdAgent *ag, dtPolyRef ref, const float *pos);
+
+    void gatherAgents();
+
+    void buildGrid();
+
+    // Writes the nearest agents in range as active indices, returns the count
+    int queryNeighbours(int i, float range, dtCrowdNeighbour *result) const;
+
+    void updateNeighbours(int i, ThreadContext &context);
+
+    void updateCorners(int i, ThreadContext &context);
+
+    void triggerOffMeshConnection(int i);
+
+    void updateSteering(int i);
+
+    void planVelocity(int i, ThreadContext &context);
+
+    void resolveCollision(int i);
+
+    void movePosition(dtCrowdAgent *ag, ThreadContext &context);
+
+    void updateOffMeshAnimation(dtCrowdAgent *ag, int idx, float dt);
+
+    void endPhase(int phase, int count, double &phaseStart);
+
+    int getUpdateFlags(const dtCrowdAgent *ag, int idx) const
+    {
+        return ag->params.updateFlags & ~m_lodTiers[m_agentLodTiers[idx]].disabledUpdateFlags;
+    }
+
+    dtCrowd *m_crowd;
+    int m_maxAgents;
+    float m_halfExtents[3];
+
+    WorkerPool m_pool;
+    std::vector<ThreadContext> m_contexts;
+
+    CrowdPathQueue m_pathQueue;
+    CrowdPathQueueParams m_pathQueueParams;
+    CrowdPathQueueStats m_pathQueueStats;
+    int m_maxPathResult;
+    std::vector<dtPolyRef> m_pathResult;
+
+    // Agents sorted by replan time, at most the queue capacity
+    std::vector<dtCrowdAgent *> m_requestQueue;
+
+    // Indexed by agent index
+    std::vector<dtCrowdAgent *> m_agents;
+    std::vector<dtCrowdAgentAnimation> m_animations;
+    std::vector<float> m_waitTimes;
+
+    // Active agents of the current update, and their agent indices
+    std::vector<dtCrowdAgent *> m_activeAgents;
+    std::vector<int> m_activeIndices;
+
+    // Hot state of the active agents, indexed by active index
+    std::vector<float> m_positions;
+    std::vector<float> m_velocities;
+    std::vector<float> m_desiredVelocities;
+    std::vector<float> m_displacements;
+    std::vector<float> m_radii;
+    std::vector<float> m_heights;
+    std::vector<unsigned char> m_states;
+
+    // Level of detail of the active agents, their update flags, whether they are fully updated this step and collide
+    std::vector<unsigned char> m_updateFlags;
+    std::vector<unsigned char> m_fullUpdates;
+    std::vector<unsigned char> m_collisions;
+
+    // Neighbours of each active agent as active indices, DT_CROWDAGENT_MAX_NEIGHBOURS per agent
+    std::vector<int> m_neighbours;
+    std::vector<int> m_neighbourCounts;
+
+    // Hashed grid, the (x, z) cell of each active agent, and the active agents of each bucket sorted by bucket
+    float m_gridCellSize;
+    std::vector<int> m_cells;
+    std::vector<int> m_bucketStarts;
+    std::vector<int> m_bucketAgents;
+
+    CrowdLodTier m_lodTiers[CROWD_MAX_LOD_TIERS];
+
+    // Indexed by agent index
+    std::vector<unsigned char> m_agentLodTiers;
+
+    unsigned int m_tick;
+
+    int m_velocitySampleCount;
+
+    bool m_profiling;
+    CrowdUpdatePhaseProfile m_profile[CROWD_UPDATE_PHASE_COUNT];
+};
@@ -0,0 +1,340 @@
+#include "./FlowField.h"
+
+#include "../recastnavigation/Detour/Include/DetourCommon.h"
+#include "../recastnavigation/DetourCrowd/Include/DetourPathQueue.h"
+
+// dtCrowd allocates agent corridors with this many polys
+static const int MAX_CORRIDOR = 256;
+
+// The midpoint of the portal from one poly to a linked poly, as in dtNavMeshQuery::getPortalPoints.
+// Returns false if the from poly has no link to the to poly.
+static bool getPortalMidPoint(dtPolyRef from, const dtMeshTile *fromTile, const dtPoly *fromPoly,
+                              dtPolyRef to, const dtMeshTile *toTile, const dtPoly *toPoly, float *mid)
+{
+    const dtLink *link = nullptr;
+    for (unsigned int i = fromPoly->firstLink; i != DT_NULL_LINK; i = fromTile->links[i].next)
+    {
+        if (fromTile->links[i].ref == to)
+        {
+            link = &fromTile->links[i];
+            break;
+        }
+    }
+
+    if (!link)
+        return false;
+
+    // Off-mesh connections are entered and left at their endpoints
+    if (fromPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+    {
+        dtVcopy(mid, &fromTile->verts[fromPoly->verts[link->edge] * 3]);
+        return true;
+    }
+
+    if (toPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+    {
+        for (unsigned int i = toPoly->firstLink; i != DT_NULL_LINK; i = toTile->links[i].next)
+        {
+            if (toTile->links[i].ref == from)
+            {
+                dtVcopy(mid, &toTile->verts[toPoly->verts[toTile->links[i].edge] * 3]);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const float *v0 = &fromTile->verts[fromPoly->verts[link->edge] * 3];
+    const float *v1 = &fromTile->verts[fromPoly->verts[(link->edge + 1) % fromPoly->vertCount] * 3];
+
+    float left[3], right[3];
+    dtVcopy(left, v0);
+    dtVcopy(right, v1);
+
+    // Links across tile borders may only cover part of the edge
+    if (link->side != 0xff && (link->bmin != 0 || link->bmax != 255))
+    {
+        const float s = 1.0f / 255.0f;
+        dtVlerp(left, v0, v1, link->bmin * s);
+        dtVlerp(right, v0, v1, link->bmax * s);
+    }
+
+    mid[0] = (left[0] + right[0]) * 0.5f;
+    mid[1] = (left[1] + right[1]) * 0.5f;
+    mid[2] = (left[2] + right[2]) * 0.5f;
+
+    return true;
+}
+
+dtStatus FlowField::compute(NavMesh *navMesh, dtPolyRef goalRef, const float *goalPos, const dtQueryFilter *filter, float maxCost, int maxPolys)
+{
+    if (!navMesh || !navMesh->m_navMesh || !filter || !goalPos || maxPolys <= 0)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const dtNavMesh *nav = navMesh->m_navMesh;
+    if (!nav->isValidPolyRef(goalRef) || !dtVisfinite(goalPos))
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    // Node indices are stored in 16 bits
+    maxPolys = dtMin(maxPolys, int(DT_NULL_IDX) - 1);
+
+    // The pool size is the maxPolys bound, so a larger pool from an earlier compute is not reused
+    if (!m_nodePool || m_nodePool->getMaxNodes() != maxPolys)
+    {
+        destroy();
+
+        m_nodePool = new dtNodePool(maxPolys, int(dtNextPow2(dtMax(1, maxPolys / 4))));
+        m_openList = new dtNodeQueue(maxPolys);
+    }
+
+    m_nodePool->clear();
+    m_openList->clear();
+
+    m_goalRef = goalRef;
+    dtVcopy(m_goalPos, goalPos);
+
+    dtNode *goalNode = m_nodePool->getNode(goalRef);
+    dtVcopy(goalNode->pos, goalPos);
+    goalNode->pidx = 0;
+    goalNode->cost = 0;
+    goalNode->total = 0;
+    goalNode->id = goalRef;
+    goalNode->flags = DT_NODE_OPEN;
+    m_openList->push(goalNode);
+
+    dtStatus status = DT_SUCCESS;
+
+    while (!m_openList->empty())
+    {
+        dtNode *bestNode = m_openList->pop();
+        bestNode->flags &= ~DT_NODE_OPEN;
+        bestNode->flags |= DT_NODE_CLOSED;
+
+        const dtPolyRef bestRef = bestNode->id;
+        const dtMeshTile *bestTile = nullptr;
+        const dtPoly *bestPoly = nullptr;
+        nav->getTileAndPolyByRefUnsafe(bestRef, &bestTile, &bestPoly);
+
+        // The parent is the next poly towards the goal
+        dtPolyRef parentRef = 0;
+        const dtMeshTile *parentTile = nullptr;
+        const dtPoly *parentPoly = nullptr;
+        if (bestNode->pidx)
+            parentRef = m_nodePool->getNodeAtIdx(bestNode->pidx)->id;
+        if (parentRef)
+            nav->getTileAndPolyByRefUnsafe(parentRef, &parentTile, &parentPoly);
+
+        for (unsigned int i = bestPoly->firstLink; i != DT_NULL_LINK; i = bestTile->links[i].next)
+        {
+            const dtPolyRef neighbourRef = bestTile->links[i].ref;
+            if (!neighbourRef || neighbourRef == parentRef)
+                continue;
+
+            const dtMeshTile *neighbourTile = nullptr;
+            const dtPoly *neighbourPoly = nullptr;
+            nav->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
+
+            if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
+                continue;
+
+            // Agents move from the neighbour into the best poly, which needs a link in that direction
+            float portal[3];
+            if (!getPortalMidPoint(neighbourRef, neighbourTile, neighbourPoly, bestRef, bestTile, bestPoly, portal))
+                continue;
+
+            // The cost of crossing the best poly, from the neighbour's portal to the best poly's exit
+            const float cost = bestNode->cost + filter->getCost(portal, bestNode->pos,
+                                                                neighbourRef, neighbourTile, neighbourPoly,
+                                                                bestRef, bestTile, bestPoly,
+                                                                parentRef, parentTile, parentPoly);
+
+            if (maxCost > 0 && cost > maxCost)
+                continue;
+
+            dtNode *neighbourNode = m_nodePool->getNode(neighbourRef);
+            if (!neighbourNode)
+            {
+                status |= DT_OUT_OF_NODES;
+                continue;
+            }
+
+            if (neighbourNode->flags & DT_NODE_CLOSED)
+                continue;
+
+            if ((neighbourNode->flags & DT_NODE_OPEN) && cost >= neighbourNode->cost)
+                continue;
+
+            neighbourNode->id = neighbourRef;
+            neighbourNode->pidx = m_nodePool->getNodeIdx(bestNode);
+            neighbourNode->cost = cost;
+            neighbourNode->total = cost;
+            dtVcopy(neighbourNode->pos, portal);
+
+            if (neighbourNode->flags & DT_NODE_OPEN)
+            {
+                m_openList->modify(neighbourNode);
+            }
+            else
+            {
+                neighbourNode->flags = DT_NODE_OPEN;
+                m_openList->push(neighbourNode);
+            }
+        }
+    }
+
+    return status;
+}
+
+const dtNode *FlowField::findNode(dtPolyRef ref) const
+{
+    if (!m_nodePool || !ref)
+    {
+        return nullptr;
+    }
+
+    return m_nodePool->findNode(ref, 0);
+}
+
+int FlowField::getPolyCount() const
+{
+    return m_nodePool ? m_nodePool->getNodeCount() : 0;
+}
+
+float FlowField::getCost(dtPolyRef ref) const
+{
+    const dtNode *node = findNode(ref);
+    return node ? node->cost : -1.0f;
+}
+
+dtPolyRef FlowField::getParent(dtPolyRef ref) const
+{
+    const dtNode *node = findNode(ref);
+    if (!node || !node->pidx)
+    {
+        return 0;
+    }
+
+    return m_nodePool->getNodeAtIdx(node->pidx)->id;
+}
+
+bool FlowField::getExitPoint(dtPolyRef ref, Vec3 *point) const
+{
+    const dtNode *node = findNode(ref);
+    if (!node)
+    {
+        return false;
+    }
+
+    // Node positions are the portal into the parent poly, set when the parent was found
+    dtVcopy(&point->x, node->pos);
+    return true;
+}
+
+int FlowField::followParents(dtPolyRef startRef, dtPolyRef *path, int maxPath) const
+{
+    const dtNode *node = findNode(startRef);
+
+    int count = 0;
+    while (node && count < maxPath)
+    {
+        path[count++] = node->id;
+        node = node->pidx ? m_nodePool->getNodeAtIdx(node->pidx) : nullptr;
+    }
+
+    return count;
+}
+
+int FlowField::getPath(dtPolyRef startRef, UnsignedIntArray *path, int maxPath) const
+{
+    if (maxPath <= 0)
+    {
+        return 0;
+    }
+
+    if (path->size < maxPath || path->isView)
+    {
+        path->resize(maxPath);
+    }
+
+    return followParents(startRef, path->data, maxPath);
+}
+
+int FlowField::getPolys(UnsignedIntArray *refs, UnsignedIntArray *parents, FloatArray *costs) const
+{
+    const int count = getPolyCount();
+
+    if (refs->size < count || refs->isView)
+        refs->resize(count);
+    if (parents->size < count || parents->isView)
+        parents->resize(count);
+    if (costs->size < count || costs->isView)
+        costs->resize(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const dtNode *node = m_nodePool->getNodeAtIdx(i + 1);
+        refs->data[i] = node->id;
+        parents->data[i] = node->pidx ? m_nodePool->getNodeAtIdx(node->pidx)->id : 0;
+        costs->data[i] = node->cost;
+    }
+
+    return count;
+}
+
+int FlowField::setCrowdAgentCorridors(dtCrowd *crowd, const IntArray *agentIndices)
+{
+    if (!m_nodePool || !crowd)
+    {
+        return 0;
+    }
+
+    m_corridor.resize(MAX_CORRIDOR);
+
+    int count = 0;
+
+    for (int i = 0; i < agentIndices->size; ++i)
+    {
+        dtCrowdAgent *ag = crowd->getEditableAgent(agentIndices->data[i]);
+        if (!ag || !ag->active || ag->state != DT_CROWDAGENT_STATE_WALKING)
+            continue;
+
+        const int npath = followParents(ag->corridor.getFirstPoly(), m_corridor.data(), MAX_CORRIDOR);
+        if (npath == 0)
+            continue;
+
+        const dtPolyRef lastRef = m_corridor[npath - 1];
+        const bool partial = lastRef != m_goalRef;
+
+        const float *targetPos = partial ? findNode(lastRef)->pos : m_goalPos;
+
+        // As a completed move request in dtCrowd::update
+        ag->corridor.setCorridor(targetPos, m_corridor.data(), npath);
+        ag->boundary.reset();
+        ag->partial = partial;
+
+        ag->targetRef = lastRef;
+        dtVcopy(ag->targetPos, targetPos);
+        ag->targetPathqRef = DT_PATHQ_INVALID;
+        ag->targetReplan = false;
+        ag->targetReplanTime = 0;
+        ag->targetState = DT_CROWDAGENT_TARGET_VALID;
+
+        count++;
+    }
+
+    return count;
+}
+
+void FlowField::destroy()
+{
+    delete m_nodePool;
+    m_nodePool = nullptr;
+
+    delete m_openList;
+    m_openList = nullptr;
+}
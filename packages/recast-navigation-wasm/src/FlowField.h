@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../recastnavigation/Detour/Include/DetourStatus.h"
+#include "../recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "../recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+#include "../recastnavigation/Detour/Include/DetourNode.h"
+#include "../recastnavigation/DetourCrowd/Include/DetourCrowd.h"
+#include "./Arrays.h"
+#include "./NavMesh.h"
+#include <vector>
+
+// A goal rooted flow field over a navmesh, for many agents sharing a destination.
+//
+// compute runs one Dijkstra expansion outwards from the goal poly, like dtNavMeshQuery::findPolysAroundCircle, storing
+// the cost to the goal and the parent poly of every reached poly. The parent of a poly is the next poly on the cheapest
+// path to the goal, so the corridor of an agent is found by following parent links instead of running a search.
+//
+// Polys are only expanded through links agents can traverse towards the goal, so one way off-mesh connections are
+// respected. Costs come from the query filter in the direction of travel, as in dtNavMeshQuery::findPath.
+//
+// The field is a snapshot of the navmesh, and should be recomputed after tiles change.
+class FlowField
+{
+public:
+    FlowField() : m_nodePool(nullptr), m_openList(nullptr), m_goalRef(0)
+    {
+        m_goalPos[0] = m_goalPos[1] = m_goalPos[2] = 0;
+    }
+
+    ~FlowField()
+    {
+        destroy();
+    }
+
+    // Expands from the goal until every reachable poly is visited, or maxPolys polys are visited, or costs exceed
+    // maxCost if it is greater than 0. Returns DT_OUT_OF_NODES with success if maxPolys was reached.
+    dtStatus compute(NavMesh *navMesh, dtPolyRef goalRef, const float *goalPos, const dtQueryFilter *filter, float maxCost, int maxPolys);
+
+    dtPolyRef getGoalRef() const
+    {
+        return m_goalRef;
+    }
+
+    const float *getGoalPos() const
+    {
+        return m_goalPos;
+    }
+
+    // The number of polys reached by the last compute
+    int getPolyCount() const;
+
+    bool isReached(dtPolyRef ref) const
+    {
+        return findNode(ref) != nullptr;
+    }
+
+    // The cost from the poly to the goal, or -1 if the poly was not reached
+    float getCost(dtPolyRef ref) const;
+
+    // The next poly towards the goal, or 0 for the goal and polys that were not reached
+    dtPolyRef getParent(dtPolyRef ref) const;
+
+    // The point the path from the poly to the goal leaves the poly, the goal position for the goal poly
+    bool getExitPoint(dtPolyRef ref, Vec3 *point) const;
+
+    // Writes the corridor from startRef towards the goal, at most maxPath polys. Returns the poly count, 0 if the start
+    // poly was not reached.
+    int getPath(dtPolyRef startRef, UnsignedIntArray *path, int maxPath) const;
+
+    // Writes every reached poly with its parent and cost
+    int getPolys(UnsignedIntArray *refs, UnsignedIntArray *parents, FloatArray *costs) const;
+
+    // Sets the corridors of crowd agents to their paths through the field, in place of requestMoveTarget.
+    // Agents whose poly was not reached are left unchanged. Corridors longer than a dtCrowd corridor target the exit
+    // point of their last poly, and are marked partial. Returns the number of agents given a corridor.
+    int setCrowdAgentCorridors(dtCrowd *crowd, const IntArray *agentIndices);
+
+    void destroy();
+
+private:
+    const dtNode *findNode(dtPolyRef ref) const;
+
+    int followParents(dtPolyRef startRef, dtPolyRef *path, int maxPath) const;
+
+    dtNodePool *m_nodePool;
+    dtNodeQueue *m_openList;
+
+    dtPolyRef m_goalRef;
+    float m_goalPos[3];
+
+    std::vector<dtPolyRef> m_corridor;
+};
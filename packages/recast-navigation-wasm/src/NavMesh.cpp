@@ -16,7 +16,14 @@ bool NavMesh::initTiled(const dtNavMeshParams *params)
 
 dtStatus NavMesh::addTile(UnsignedCharArray *navMeshData, int flags, dtTileRef lastRef, UnsignedIntRef *tileRef)
 {
-    return m_navMesh->addTile(navMeshData->data, navMeshData->size, flags, lastRef, &tileRef->value);
+    dtStatus status = m_navMesh->addTile(navMeshData->data, navMeshData->size, flags, lastRef, &tileRef->value);
+
+    if (dtStatusSucceed(status))
+    {
+        markTileChanged(tileRef->value);
+    }
+
+    return status;
 }
 
 NavMeshRemoveTileResult NavMesh::removeTile(dtTileRef ref)
@@ -25,6 +32,11 @@ NavMeshRemoveTileResult NavMesh::removeTile(dtTileRef ref)
 
     result.status = m_navMesh->removeTile(ref, &result.data, &result.dataSize);
 
+    if (dtStatusSucceed(result.status))
+    {
+        markTileChanged(ref);
+    }
+
     return result;
 }
 
@@ -134,7 +146,14 @@ const dtOffMeshConnection *NavMesh::getOffMeshConnectionByRef(dtPolyRef ref) con
 
 dtStatus NavMesh::setPolyFlags(dtPolyRef ref, unsigned short flags)
 {
-    return m_navMesh->setPolyFlags(ref, flags);
+    dtStatus status = m_navMesh->setPolyFlags(ref, flags);
+
+    if (dtStatusSucceed(status))
+    {
+        markTileChanged(ref);
+    }
+
+    return status;
 }
 
 dtStatus NavMesh::getPolyFlags(dtPolyRef ref, UnsignedShortRef *flags) const
@@ -144,7 +163,14 @@ dtStatus NavMesh::getPolyFlags(dtPolyRef ref, UnsignedShortRef *flags) const
 
 dtStatus NavMesh::setPolyArea(dtPolyRef ref, unsigned char area)
 {
-    return m_navMesh->setPolyArea(ref, area);
+    dtStatus status = m_navMesh->setPolyArea(ref, area);
+
+    if (dtStatusSucceed(status))
+    {
+        markTileChanged(ref);
+    }
+
+    return status;
 }
 
 dtStatus NavMesh::getPolyArea(dtPolyRef ref, UnsignedCharRef *area) const
@@ -172,9 +198,42 @@ dtStatus NavMesh::restoreTileState(dtMeshTile *tile, const unsigned char *data,
     return m_navMesh->restoreTileState(tile, data, maxDataSize);
 }
 
+void NavMesh::adoptData(void *data)
+{
+    free(m_ownedData);
+    m_ownedData = data;
+}
+
+void NavMesh::markTileChanged(dtPolyRef ref)
+{
+    const unsigned int tileIndex = m_navMesh->decodePolyIdTile(ref);
+
+    if (tileIndex >= m_tileVersions.size())
+    {
+        const int maxTiles = m_navMesh->getMaxTiles();
+        m_tileVersions.resize(tileIndex < (unsigned int)maxTiles ? maxTiles : tileIndex + 1, 0);
+    }
+
+    m_tileVersions[tileIndex]++;
+}
+
+unsigned int NavMesh::getTileVersion(int tileIndex) const
+{
+    if (tileIndex < 0 || tileIndex >= int(m_tileVersions.size()))
+    {
+        return 0;
+    }
+
+    return m_tileVersions[tileIndex];
+}
+
 void NavMesh::destroy()
 {
     dtFreeNavMesh(m_navMesh);
+    m_tileVersions.clear();
+
+    free(m_ownedData);
+    m_ownedData = nullptr;
 }
 
 const dtMeshTile *NavMesh::getTile(int i) const
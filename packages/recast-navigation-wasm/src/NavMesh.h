@@ -7,6 +7,7 @@
 #include "./Refs.h"
 #include "./Arrays.h"
 #include "./Vec.h"
+#include <vector>
 
 struct NavMeshRemoveTileResult
 {
@@ -46,12 +47,15 @@ class NavMesh
 public:
     dtNavMesh *m_navMesh;
 
-    NavMesh()
+    // Buffer that tiles added without DT_TILE_FREE_DATA point into, freed on destroy
+    void *m_ownedData;
+
+    NavMesh() : m_ownedData(nullptr)
     {
         m_navMesh = dtAllocNavMesh();
     }
 
-    NavMesh(dtNavMesh *navMesh)
+    NavMesh(dtNavMesh *navMesh) : m_ownedData(nullptr)
     {
         m_navMesh = navMesh;
     }
@@ -115,5 +119,16 @@ public:
 
     dtStatus restoreTileState(dtMeshTile *tile, const unsigned char *data, const int maxDataSize);
 
+    void adoptData(void *data);
+
+    // Per-tile change counters, bumped when tiles are added or removed or have poly flags or areas set through this wrapper.
+    // Takes a tile ref or a poly ref within the tile.
+    void markTileChanged(dtPolyRef ref);
+
+    unsigned int getTileVersion(int tileIndex) const;
+
     void destroy();
+
+private:
+    std::vector<unsigned int> m_tileVersions;
 };
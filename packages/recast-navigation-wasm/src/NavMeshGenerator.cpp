@@ -0,0 +1,539 @@
+#include "./NavMeshGenerator.h"
+
+#include "../recastnavigation/Detour/Include/DetourCommon.h"
+#include <float.h>
+#include <string.h>
+#include <vector>
+
+// Bounds of the vertices referenced by the triangles, as getBoundingBox in the generators package
+static void calcTriangleBounds(const float *verts, const int *tris, int nt, float *bmin, float *bmax)
+{
+    bmin[0] = bmin[1] = bmin[2] = FLT_MAX;
+    bmax[0] = bmax[1] = bmax[2] = -FLT_MAX;
+
+    for (int i = 0; i < nt * 3; ++i)
+    {
+        const float *v = &verts[tris[i] * 3];
+        rcVmin(bmin, v);
+        rcVmax(bmax, v);
+    }
+}
+
+int SoloNavMeshGenerator::generate(rcContext *ctx, const FloatArray *positions, const IntArray *indices, rcConfig *config, bool computeBounds, dtNavMeshCreateParams *createParams, bool keepIntermediates, UnsignedCharArray *navMeshData)
+{
+    destroy();
+
+    const auto fail = [this, keepIntermediates](int error)
+    {
+        if (!keepIntermediates)
+            destroy();
+
+        return error;
+    };
+
+    const float *verts = positions->data;
+    const int nverts = positions->size / 3;
+    const int *tris = indices->data;
+    const int ntris = indices->size / 3;
+
+    //
+    // Step 1. Initialize build config.
+    //
+    if (computeBounds)
+    {
+        if (ntris <= 0)
+            return fail(NAVMESH_GENERATOR_CREATE_HEIGHTFIELD);
+
+        calcTriangleBounds(verts, tris, ntris, config->bmin, config->bmax);
+    }
+
+    rcCalcGridSize(config->bmin, config->bmax, config->cs, &config->width, &config->height);
+
+    //
+    // Step 2. Rasterize input polygon soup.
+    //
+    m_heightfield = rcAllocHeightfield();
+    if (!m_heightfield || !rcCreateHeightfield(ctx, *m_heightfield, config->width, config->height, config->bmin, config->bmax, config->cs, config->ch))
+    {
+        return fail(NAVMESH_GENERATOR_CREATE_HEIGHTFIELD);
+    }
+
+    std::vector<unsigned char> triAreas(ntris, 0);
+    rcMarkWalkableTriangles(ctx, config->walkableSlopeAngle, verts, nverts, tris, ntris, triAreas.data());
+
+    if (!rcRasterizeTriangles(ctx, verts, nverts, tris, triAreas.data(), ntris, *m_heightfield, config->walkableClimb))
+    {
+        return fail(NAVMESH_GENERATOR_RASTERIZE_TRIANGLES);
+    }
+
+    //
+    // Step 3. Filter walkable surfaces.
+    //
+    rcFilterLowHangingWalkableObstacles(ctx, config->walkableClimb, *m_heightfield);
+    rcFilterLedgeSpans(ctx, config->walkableHeight, config->walkableClimb, *m_heightfield);
+    rcFilterWalkableLowHeightSpans(ctx, config->walkableHeight, *m_heightfield);
+
+    //
+    // Step 4. Partition walkable surface to simple regions.
+    //
+    m_compactHeightfield = rcAllocCompactHeightfield();
+    if (!m_compactHeightfield || !rcBuildCompactHeightfield(ctx, config->walkableHeight, config->walkableClimb, *m_heightfield, *m_compactHeightfield))
+    {
+        return fail(NAVMESH_GENERATOR_BUILD_COMPACT_HEIGHTFIELD);
+    }
+
+    if (!keepIntermediates)
+    {
+        rcFreeHeightField(m_heightfield);
+        m_heightfield = nullptr;
+    }
+
+    if (!rcErodeWalkableArea(ctx, config->walkableRadius, *m_compactHeightfield))
+    {
+        return fail(NAVMESH_GENERATOR_ERODE_WALKABLE_AREA);
+    }
+
+    if (!rcBuildDistanceField(ctx, *m_compactHeightfield))
+    {
+        return fail(NAVMESH_GENERATOR_BUILD_DISTANCE_FIELD);
+    }
+
+    if (!rcBuildRegions(ctx, *m_compactHeightfield, config->borderSize, config->minRegionArea, config->mergeRegionArea))
+    {
+        return fail(NAVMESH_GENERATOR_BUILD_REGIONS);
+    }
+
+    //
+    // Step 5. Trace and simplify region contours.
+    //
+    m_contourSet = rcAllocContourSet();
+    if (!m_contourSet || !rcBuildContours(ctx, *m_compactHeightfield, config->maxSimplificationError, config->maxEdgeLen, *m_contourSet, RC_CONTOUR_TESS_WALL_EDGES))
+    {
+        return fail(NAVMESH_GENERATOR_BUILD_CONTOURS);
+    }
+
+    //
+    // Step 6. Build polygons mesh from contours.
+    //
+    m_polyMesh = rcAllocPolyMesh();
+    if (!m_polyMesh || !rcBuildPolyMesh(ctx, *m_contourSet, config->maxVertsPerPoly, *m_polyMesh))
+    {
+        return fail(NAVMESH_GENERATOR_BUILD_POLY_MESH);
+    }
+
+    //
+    // Step 7. Create detail mesh which allows to access approximate height on each polygon.
+    //
+    m_polyMeshDetail = rcAllocPolyMeshDetail();
+    if (!m_polyMeshDetail || !rcBuildPolyMeshDetail(ctx, *m_polyMesh, *m_compactHeightfield, config->detailSampleDist, config->detailSampleMaxError, *m_polyMeshDetail))
+    {
+        return fail(NAVMESH_GENERATOR_BUILD_POLY_MESH_DETAIL);
+    }
+
+    if (!keepIntermediates)
+    {
+        rcFreeCompactHeightfield(m_compactHeightfield);
+        m_compactHeightfield = nullptr;
+
+        rcFreeContourSet(m_contourSet);
+        m_contourSet = nullptr;
+    }
+
+    //
+    // Step 8. Create Detour data from Recast poly mesh.
+    //
+    for (int i = 0; i < m_polyMesh->npolys; ++i)
+    {
+        if (m_polyMesh->areas[i] == RC_WALKABLE_AREA)
+            m_polyMesh->areas[i] = 0;
+        if (m_polyMesh->areas[i] == 0)
+            m_polyMesh->flags[i] = 1;
+    }
+
+    createParams->verts = m_polyMesh->verts;
+    createParams->vertCount = m_polyMesh->nverts;
+    createParams->polys = m_polyMesh->polys;
+    createParams->polyAreas = m_polyMesh->areas;
+    createParams->polyFlags = m_polyMesh->flags;
+    createParams->polyCount = m_polyMesh->npolys;
+    createParams->nvp = m_polyMesh->nvp;
+    rcVcopy(createParams->bmin, m_polyMesh->bmin);
+    rcVcopy(createParams->bmax, m_polyMesh->bmax);
+
+    createParams->detailMeshes = m_polyMeshDetail->meshes;
+    createParams->detailVerts = m_polyMeshDetail->verts;
+    createParams->detailVertsCount = m_polyMeshDetail->nverts;
+    createParams->detailTris = m_polyMeshDetail->tris;
+    createParams->detailTriCount = m_polyMeshDetail->ntris;
+
+    createParams->walkableHeight = config->walkableHeight * config->ch;
+    createParams->walkableRadius = config->walkableRadius * config->cs;
+    createParams->walkableClimb = config->walkableClimb * config->ch;
+    createParams->cs = config->cs;
+    createParams->ch = config->ch;
+
+    unsigned char *data = nullptr;
+    int dataSize = 0;
+    if (!dtCreateNavMeshData(createParams, &data, &dataSize))
+    {
+        return fail(NAVMESH_GENERATOR_CREATE_NAVMESH_DATA);
+    }
+
+    navMeshData->free();
+    navMeshData->data = data;
+    navMeshData->size = dataSize;
+    navMeshData->isView = false;
+
+    if (!keepIntermediates)
+    {
+        destroy();
+    }
+
+    return NAVMESH_GENERATOR_SUCCESS;
+}
+
+void SoloNavMeshGenerator::releaseIntermediates()
+{
+    m_heightfield = nullptr;
+    m_compactHeightfield = nullptr;
+    m_contourSet = nullptr;
+    m_polyMesh = nullptr;
+    m_polyMeshDetail = nullptr;
+}
+
+void SoloNavMeshGenerator::destroy()
+{
+    rcFreeHeightField(m_heightfield);
+    rcFreeCompactHeightfield(m_compactHeightfield);
+    rcFreeContourSet(m_contourSet);
+    rcFreePolyMesh(m_polyMesh);
+    rcFreePolyMeshDetail(m_polyMeshDetail);
+
+    releaseIntermediates();
+}
+
+bool TiledNavMeshGenerator::init(int threadCount)
+{
+    destroy();
+
+    if (!m_pool.init(threadCount))
+    {
+        return false;
+    }
+
+    m_contexts.resize(m_pool.getThreadCount());
+
+    return true;
+}
+
+void TiledNavMeshGenerator::calcTileCount(const rcConfig &config, int *tileWidth, int *tileHeight)
+{
+    *tileWidth = 0;
+    *tileHeight = 0;
+
+    if (config.tileSize <= 0)
+        return;
+
+    int gridWidth = 0;
+    int gridHeight = 0;
+    rcCalcGridSize(config.bmin, config.bmax, config.cs, &gridWidth, &gridHeight);
+
+    *tileWidth = (gridWidth + config.tileSize - 1) / config.tileSize;
+    *tileHeight = (gridHeight + config.tileSize - 1) / config.tileSize;
+}
+
+void TiledNavMeshGenerator::gatherTileTriangles(ThreadContext &scratch, float *tbmin, float *tbmax) const
+{
+    scratch.tris.clear();
+
+    const rcChunkyTriMesh *chunkyTriMesh = m_chunkyTriMesh;
+    if (!chunkyTriMesh || chunkyTriMesh->nnodes == 0)
+        return;
+
+    // Sized to every node, so overlapping chunks are never cut off
+    scratch.chunkIds.resize(chunkyTriMesh->nnodes);
+    const int nchunks = rcGetChunksOverlappingRect(chunkyTriMesh, tbmin, tbmax, scratch.chunkIds.data(), int(scratch.chunkIds.size()));
+
+    for (int i = 0; i < nchunks; ++i)
+    {
+        const rcChunkyTriMeshNode &node = chunkyTriMesh->nodes[scratch.chunkIds[i]];
+        const int *tris = &chunkyTriMesh->tris[node.i * 3];
+
+        scratch.tris.insert(scratch.tris.end(), tris, tris + node.n * 3);
+    }
+}
+
+int TiledNavMeshGenerator::buildCompactHeightfield(rcContext *ctx, ThreadContext &scratch, const float *verts, int nverts, const rcConfig &tileConfig, int tileIndex, rcCompactHeightfield **compactHeightfield)
+{
+    *compactHeightfield = nullptr;
+
+    float tbmin[2] = {tileConfig.bmin[0], tileConfig.bmin[2]};
+    float tbmax[2] = {tileConfig.bmax[0], tileConfig.bmax[2]};
+
+    gatherTileTriangles(scratch, tbmin, tbmax);
+
+    const int ntris = int(scratch.tris.size()) / 3;
+    if (ntris == 0)
+    {
+        return NAVMESH_GENERATOR_SUCCESS;
+    }
+
+    rcHeightfield *heightfield = rcAllocHeightfield();
+    if (!heightfield || !rcCreateHeightfield(ctx, *heightfield, tileConfig.width, tileConfig.height, tileConfig.bmin, tileConfig.bmax, tileConfig.cs, tileConfig.ch))
+    {
+        rcFreeHeightField(heightfield);
+        return NAVMESH_GENERATOR_CREATE_HEIGHTFIELD;
+    }
+
+    scratch.triAreas.assign(ntris, 0);
+    rcMarkWalkableTriangles(ctx, tileConfig.walkableSlopeAngle, verts, nverts, scratch.tris.data(), ntris, scratch.triAreas.data());
+
+    if (!rcRasterizeTriangles(ctx, verts, nverts, scratch.tris.data(), scratch.triAreas.data(), ntris, *heightfield, tileConfig.walkableClimb))
+    {
+        rcFreeHeightField(heightfield);
+        return NAVMESH_GENERATOR_RASTERIZE_TRIANGLES;
+    }
+
+    rcFilterLowHangingWalkableObstacles(ctx, tileConfig.walkableClimb, *heightfield);
+    rcFilterLedgeSpans(ctx, tileConfig.walkableHeight, tileConfig.walkableClimb, *heightfield);
+    rcFilterWalkableLowHeightSpans(ctx, tileConfig.walkableHeight, *heightfield);
+
+    rcCompactHeightfield *chf = rcAllocCompactHeightfield();
+    if (!chf || !rcBuildCompactHeightfield(ctx, tileConfig.walkableHeight, tileConfig.walkableClimb, *heightfield, *chf))
+    {
+        rcFreeHeightField(heightfield);
+        rcFreeCompactHeightfield(chf);
+        return NAVMESH_GENERATOR_BUILD_COMPACT_HEIGHTFIELD;
+    }
+
+    rcFreeHeightField(heightfield);
+
+    *compactHeightfield = chf;
+
+    return NAVMESH_GENERATOR_SUCCESS;
+}
+
+int TiledNavMeshGenerator::buildTile(rcContext *ctx, ThreadContext &scratch, const float *verts, int nverts, const rcConfig &config, const dtNavMeshCreateParams &createParams, int tileIndex, int tileWidth, TileResult &result)
+{
+    result.data = nullptr;
+    result.dataSize = 0;
+
+    const int tx = tileIndex % tileWidth;
+    const int ty = tileIndex / tileWidth;
+
+    // Expand the tile bounds by the border size, so tiles connect at their borders and obstacles near the border are
+    // handled by erosion, see generateTileNavMeshData
+    const float tcs = config.tileSize * config.cs;
+    const float border = config.borderSize * config.cs;
+
+    rcConfig tileConfig = config;
+    tileConfig.bmin[0] = config.bmin[0] + tx * tcs - border;
+    tileConfig.bmin[1] = config.bmin[1];
+    tileConfig.bmin[2] = config.bmin[2] + ty * tcs - border;
+    tileConfig.bmax[0] = config.bmin[0] + (tx + 1) * tcs + border;
+    tileConfig.bmax[1] = config.bmax[1];
+    tileConfig.bmax[2] = config.bmin[2] + (ty + 1) * tcs + border;
+
+    rcCompactHeightfield *compactHeightfield = nullptr;
+    rcContourSet *contourSet = nullptr;
+    rcPolyMesh *polyMesh = nullptr;
+    rcPolyMeshDetail *polyMeshDetail = nullptr;
+
+    const auto finish = [&](int error)
+    {
+        rcFreeCompactHeightfield(compactHeightfield);
+        rcFreeContourSet(contourSet);
+        rcFreePolyMesh(polyMesh);
+        rcFreePolyMeshDetail(polyMeshDetail);
+
+        return error;
+    };
+
+    const int error = buildCompactHeightfield(ctx, scratch, verts, nverts, tileConfig, tileIndex, &compactHeightfield);
+    if (error != NAVMESH_GENERATOR_SUCCESS || !compactHeightfield)
+    {
+        return finish(error);
+    }
+
+    if (!rcErodeWalkableArea(ctx, tileConfig.walkableRadius, *compactHeightfield))
+    {
+        return finish(NAVMESH_GENERATOR_ERODE_WALKABLE_AREA);
+    }
+
+    markAreas(ctx, tileConfig, *compactHeightfield);
+
+    if (!rcBuildDistanceField(ctx, *compactHeightfield))
+    {
+        return finish(NAVMESH_GENERATOR_BUILD_DISTANCE_FIELD);
+    }
+
+    if (!rcBuildRegions(ctx, *compactHeightfield, tileConfig.borderSize, tileConfig.minRegionArea, tileConfig.mergeRegionArea))
+    {
+        return finish(NAVMESH_GENERATOR_BUILD_REGIONS);
+    }
+
+    contourSet = rcAllocContourSet();
+    if (!contourSet || !rcBuildContours(ctx, *compactHeightfield, tileConfig.maxSimplificationError, tileConfig.maxEdgeLen, *contourSet, RC_CONTOUR_TESS_WALL_EDGES))
+    {
+        return finish(NAVMESH_GENERATOR_BUILD_CONTOURS);
+    }
+
+    polyMesh = rcAllocPolyMesh();
+    if (!polyMesh || !rcBuildPolyMesh(ctx, *contourSet, tileConfig.maxVertsPerPoly, *polyMesh))
+    {
+        return finish(NAVMESH_GENERATOR_BUILD_POLY_MESH);
+    }
+
+    polyMeshDetail = rcAllocPolyMeshDetail();
+    if (!polyMeshDetail || !rcBuildPolyMeshDetail(ctx, *polyMesh, *compactHeightfield, tileConfig.detailSampleDist, tileConfig.detailSampleMaxError, *polyMeshDetail))
+    {
+        return finish(NAVMESH_GENERATOR_BUILD_POLY_MESH_DETAIL);
+    }
+
+    // Nothing walkable in this tile
+    if (polyMesh->nverts == 0 || polyMesh->npolys == 0)
+    {
+        return finish(NAVMESH_GENERATOR_SUCCESS);
+    }
+
+    // Polys of marked areas keep their area id, and are walkable by default like unmarked polys
+    for (int i = 0; i < polyMesh->npolys; ++i)
+    {
+        if (polyMesh->areas[i] == RC_WALKABLE_AREA)
+            polyMesh->areas[i] = 0;
+
+        polyMesh->flags[i] = 1;
+    }
+
+    dtNavMeshCreateParams params = createParams;
+
+    params.verts = polyMesh->verts;
+    params.vertCount = polyMesh->nverts;
+    params.polys = polyMesh->polys;
+    params.polyAreas = polyMesh->areas;
+    params.polyFlags = polyMesh->flags;
+    params.polyCount = polyMesh->npolys;
+    params.nvp = polyMesh->nvp;
+    rcVcopy(params.bmin, polyMesh->bmin);
+    rcVcopy(params.bmax, polyMesh->bmax);
+
+    params.detailMeshes = polyMeshDetail->meshes;
+    params.detailVerts = polyMeshDetail->verts;
+    params.detailVertsCount = polyMeshDetail->nverts;
+    params.detailTris = polyMeshDetail->tris;
+    params.detailTriCount = polyMeshDetail->ntris;
+
+    params.walkableHeight = tileConfig.walkableHeight * tileConfig.ch;
+    params.walkableRadius = tileConfig.walkableRadius * tileConfig.cs;
+    params.walkableClimb = tileConfig.walkableClimb * tileConfig.ch;
+    params.cs = tileConfig.cs;
+    params.ch = tileConfig.ch;
+    params.tileX = tx;
+    params.tileY = ty;
+    params.tileLayer = 0;
+
+    if (!dtCreateNavMeshData(&params, &result.data, &result.dataSize))
+    {
+        result.data = nullptr;
+        result.dataSize = 0;
+        return finish(NAVMESH_GENERATOR_CREATE_NAVMESH_DATA);
+    }
+
+    return finish(NAVMESH_GENERATOR_SUCCESS);
+}
+
+int TiledNavMeshGenerator::buildTiles(const int *tileIndices, int tileCount, int tileWidth, const float *verts, int nverts, const rcConfig &config, const dtNavMeshCreateParams &createParams, NavMesh *navMesh)
+{
+    m_failedTileCount = 0;
+
+    m_contexts.resize(m_pool.getThreadCount());
+
+    TileResult empty = {nullptr, 0, NAVMESH_GENERATOR_SUCCESS};
+    m_results.assign(tileCount, empty);
+
+    m_pool.parallelFor(tileCount, 1, [&](int begin, int end, int threadIndex)
+    {
+        // The JS build context can only be called from the main thread, so tiles log to a disabled context
+        rcContext ctx(false);
+
+        for (int i = begin; i < end; ++i)
+        {
+            TileResult &result = m_results[i];
+            result.error = buildTile(&ctx, m_contexts[threadIndex], verts, nverts, config, createParams, tileIndices[i], tileWidth, result);
+        }
+    });
+
+    // Replace tiles from this thread, in the order of tileIndices
+    int addedTileCount = 0;
+
+    for (int i = 0; i < tileCount; ++i)
+    {
+        TileResult &result = m_results[i];
+
+        if (result.error != NAVMESH_GENERATOR_SUCCESS)
+        {
+            m_failedTileCount++;
+            continue;
+        }
+
+        const int tx = tileIndices[i] % tileWidth;
+        const int ty = tileIndices[i] / tileWidth;
+
+        const dtTileRef existing = navMesh->getTileRefAt(tx, ty, 0);
+        if (existing)
+        {
+            navMesh->removeTile(existing);
+        }
+
+        if (!result.data)
+        {
+            continue;
+        }
+
+        dtTileRef tileRef = 0;
+        const dtStatus status = navMesh->m_navMesh->addTile(result.data, result.dataSize, DT_TILE_FREE_DATA, 0, &tileRef);
+
+        if (dtStatusFailed(status))
+        {
+            dtFree(result.data);
+            m_failedTileCount++;
+            continue;
+        }
+
+        navMesh->markTileChanged(tileRef);
+        addedTileCount++;
+    }
+
+    m_results.clear();
+
+    return addedTileCount;
+}
+
+int TiledNavMeshGenerator::generate(const FloatArray *positions, const rcChunkyTriMesh *chunkyTriMesh, const rcConfig *config, const dtNavMeshCreateParams *createParams, NavMesh *navMesh)
+{
+    int tileWidth = 0;
+    int tileHeight = 0;
+    calcTileCount(*config, &tileWidth, &tileHeight);
+
+    m_tileIndices.resize(tileWidth * tileHeight);
+    for (int i = 0; i < int(m_tileIndices.size()); ++i)
+    {
+        m_tileIndices[i] = i;
+    }
+
+    m_chunkyTriMesh = chunkyTriMesh;
+
+    const int addedTileCount = buildTiles(m_tileIndices.data(), int(m_tileIndices.size()), tileWidth, positions->data, positions->size / 3, *config, *createParams, navMesh);
+
+    m_chunkyTriMesh = nullptr;
+
+    return addedTileCount;
+}
+
+void TiledNavMeshGenerator::destroy()
+{
+    m_pool.destroy();
+    m_contexts.clear();
+    m_results.clear();
+    m_tileIndices.clear();
+}
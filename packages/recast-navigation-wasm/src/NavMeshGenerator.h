@@ -0,0 +1,187 @@
+#pragma once
+
+#include "../recastnavigation/Recast/Include/Recast.h"
+#include "../recastnavigation/Detour/Include/DetourNavMeshBuilder.h"
+#include "./Arrays.h"
+#include "./ChunkyTriMesh.h"
+#include "./NavMesh.h"
+#include "./WorkerPool.h"
+#include <vector>
+
+// The step a generator failed at, see SoloNavMeshGenerator::generate
+enum NavMeshGeneratorError
+{
+    NAVMESH_GENERATOR_SUCCESS,
+    NAVMESH_GENERATOR_CREATE_HEIGHTFIELD,
+    NAVMESH_GENERATOR_RASTERIZE_TRIANGLES,
+    NAVMESH_GENERATOR_BUILD_COMPACT_HEIGHTFIELD,
+    NAVMESH_GENERATOR_ERODE_WALKABLE_AREA,
+    NAVMESH_GENERATOR_BUILD_DISTANCE_FIELD,
+    NAVMESH_GENERATOR_BUILD_REGIONS,
+    NAVMESH_GENERATOR_BUILD_CONTOURS,
+    NAVMESH_GENERATOR_BUILD_POLY_MESH,
+    NAVMESH_GENERATOR_BUILD_POLY_MESH_DETAIL,
+    NAVMESH_GENERATOR_CREATE_NAVMESH_DATA
+};
+
+// Builds solo navmesh data in one call, running the Recast and Detour steps of generateSoloNavMeshData natively instead
+// of through a binding call and array copy per step.
+//
+// Intermediates are owned by the generator, and freed by the next generate or destroy. With keepIntermediates they are
+// kept after generate, and releaseIntermediates hands them to the caller, who frees them with the Recast free functions.
+class SoloNavMeshGenerator
+{
+public:
+    SoloNavMeshGenerator() : m_heightfield(nullptr), m_compactHeightfield(nullptr), m_contourSet(nullptr), m_polyMesh(nullptr), m_polyMeshDetail(nullptr)
+    {
+    }
+
+    ~SoloNavMeshGenerator()
+    {
+        destroy();
+    }
+
+    // config holds the values the Recast steps take: region areas in cells squared, and the detail sample distance and
+    // max error in world units. If computeBounds is set, config bmin and bmax are set to the bounds of the indexed
+    // vertices. The grid size is calculated from the bounds.
+    //
+    // createParams supplies buildBvTree and off-mesh connections, the poly mesh, detail mesh and agent params are set
+    // by the generator. On success navMeshData holds the Detour navmesh data.
+    //
+    // Returns NAVMESH_GENERATOR_SUCCESS, or the step that failed.
+    int generate(rcContext *ctx, const FloatArray *positions, const IntArray *indices, rcConfig *config, bool computeBounds, dtNavMeshCreateParams *createParams, bool keepIntermediates, UnsignedCharArray *navMeshData);
+
+    rcHeightfield *getHeightfield() const
+    {
+        return m_heightfield;
+    }
+
+    rcCompactHeightfield *getCompactHeightfield() const
+    {
+        return m_compactHeightfield;
+    }
+
+    rcContourSet *getContourSet() const
+    {
+        return m_contourSet;
+    }
+
+    rcPolyMesh *getPolyMesh() const
+    {
+        return m_polyMesh;
+    }
+
+    rcPolyMeshDetail *getPolyMeshDetail() const
+    {
+        return m_polyMeshDetail;
+    }
+
+    // Stops owning the intermediates, which stay valid for the caller
+    void releaseIntermediates();
+
+    void destroy();
+
+private:
+    rcHeightfield *m_heightfield;
+    rcCompactHeightfield *m_compactHeightfield;
+    rcContourSet *m_contourSet;
+    rcPolyMesh *m_polyMesh;
+    rcPolyMeshDetail *m_polyMeshDetail;
+};
+
+// Builds the tiles of a tiled navmesh natively, as generateTileNavMeshData does one tile at a time, and adds them to a
+// NavMesh.
+//
+// Tiles only read the input geometry and chunky tri mesh, so they are built across a WorkerPool, each thread with its
+// own rcContext and scratch buffers. Finished tiles are added to the navmesh on the calling thread, in tile order.
+class TiledNavMeshGenerator
+{
+public:
+    TiledNavMeshGenerator() : m_chunkyTriMesh(nullptr), m_failedTileCount(0)
+    {
+    }
+
+    virtual ~TiledNavMeshGenerator()
+    {
+        destroy();
+    }
+
+    // threadCount includes the calling thread, 0 uses every available core.
+    // Only the threaded build starts worker threads.
+    bool init(int threadCount);
+
+    // config is the tile config of buildTiledNavMeshRcConfig, with bmin and bmax set to the navmesh bounds. Tiles cover
+    // the bounds in tileSize * cs squares, and their heightfields are expanded by borderSize cells on each side.
+    //
+    // createParams supplies buildBvTree and off-mesh connections, the rest is set per tile.
+    //
+    // Existing tiles at the built locations are replaced. Returns the number of tiles added to the navmesh. Tiles
+    // without walkable polygons are skipped, tiles that fail to build or add are counted by getFailedTileCount.
+    int generate(const FloatArray *positions, const rcChunkyTriMesh *chunkyTriMesh, const rcConfig *config, const dtNavMeshCreateParams *createParams, NavMesh *navMesh);
+
+    int getFailedTileCount() const
+    {
+        return m_failedTileCount;
+    }
+
+    int getThreadCount() const
+    {
+        return m_pool.getThreadCount();
+    }
+
+    // The thread count used for a threadCount of 0, 1 in single threaded builds
+    int getMaxThreadCount() const
+    {
+        return WorkerPool::getMaxThreadCount();
+    }
+
+    void destroy();
+
+    // The number of tiles covering the bounds of a tile config
+    static void calcTileCount(const rcConfig &config, int *tileWidth, int *tileHeight);
+
+protected:
+    struct ThreadContext
+    {
+        std::vector<int> tris;
+        std::vector<unsigned char> triAreas;
+        std::vector<int> chunkIds;
+        std::vector<unsigned char> buffer;
+    };
+
+    // Fills scratch.tris with the vertex indices of the triangles overlapping the xz rect of a tile's expanded bounds.
+    // Called from worker threads, so it may only read shared state.
+    virtual void gatherTileTriangles(ThreadContext &scratch, float *tbmin, float *tbmax) const;
+
+    // Rasterizes and filters the triangles of a tile into a compact heightfield, ready for erosion. Sets
+    // compactHeightfield to null for tiles without triangles. Called from worker threads, and may only write state
+    // owned by tileIndex.
+    virtual int buildCompactHeightfield(rcContext *ctx, ThreadContext &scratch, const float *verts, int nverts, const rcConfig &tileConfig, int tileIndex, rcCompactHeightfield **compactHeightfield);
+
+    // Marks areas on the eroded compact heightfield of a tile. Called from worker threads.
+    virtual void markAreas(rcContext *ctx, const rcConfig &tileConfig, rcCompactHeightfield &compactHeightfield) const
+    {
+    }
+
+    // Builds the tiles at tileIndices, which are ty * tileWidth + tx, and replaces them in the navmesh from the calling
+    // thread. Tiles that are empty after the build are removed. Returns the number of tiles added.
+    int buildTiles(const int *tileIndices, int tileCount, int tileWidth, const float *verts, int nverts, const rcConfig &config, const dtNavMeshCreateParams &createParams, NavMesh *navMesh);
+
+    const rcChunkyTriMesh *m_chunkyTriMesh;
+
+private:
+    struct TileResult
+    {
+        unsigned char *data;
+        int dataSize;
+        int error;
+    };
+
+    int buildTile(rcContext *ctx, ThreadContext &scratch, const float *verts, int nverts, const rcConfig &config, const dtNavMeshCreateParams &createParams, int tileIndex, int tileWidth, TileResult &result);
+
+    WorkerPool m_pool;
+    std::vector<ThreadContext> m_contexts;
+    std::vector<TileResult> m_results;
+    std::vector<int> m_tileIndices;
+    int m_failedTileCount;
+};
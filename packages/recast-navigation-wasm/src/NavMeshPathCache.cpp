@@ -0,0 +1,244 @@
+#include "./NavMeshPathCache.h"
+
+bool NavMeshPathCache::init(NavMesh *navMesh, int maxEntries)
+{
+    if (!navMesh || !navMesh->m_navMesh || maxEntries <= 0)
+    {
+        return false;
+    }
+
+    clear();
+
+    m_navMesh = navMesh;
+    m_maxEntries = maxEntries;
+    m_entries.reserve(maxEntries);
+
+    return true;
+}
+
+void NavMeshPathCache::readFilterSettings(const dtQueryFilter *filter, FilterSettings *settings)
+{
+    // Zeroed so padding does not affect comparisons and hashes
+    memset(settings, 0, sizeof(FilterSettings));
+    settings->includeFlags = filter->getIncludeFlags();
+    settings->excludeFlags = filter->getExcludeFlags();
+    for (int i = 0; i < DT_MAX_AREAS; ++i)
+    {
+        settings->areaCosts[i] = filter->getAreaCost(i);
+    }
+}
+
+unsigned int NavMeshPathCache::hashFilterSettings(const FilterSettings &settings)
+{
+    // FNV-1a
+    const unsigned char *bytes = (const unsigned char *)&settings;
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < sizeof(FilterSettings); ++i)
+    {
+        h = (h ^ bytes[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+bool NavMeshPathCache::isValid(const Entry &entry) const
+{
+    const dtNavMesh *navMesh = m_navMesh->m_navMesh;
+
+    for (const TileStamp &stamp : entry.tiles)
+    {
+        const dtMeshTile *tile = navMesh->getTile(int(stamp.tileIndex));
+        if (!tile || !tile->header || navMesh->getTileRef(tile) != stamp.tileRef)
+        {
+            return false;
+        }
+
+        if (m_navMesh->getTileVersion(int(stamp.tileIndex)) != stamp.version)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int NavMeshPathCache::entryBytes(const Entry &entry) const
+{
+    // The key is held by both the map and the lru list
+    return int(sizeof(Key) * 2 + sizeof(Entry) + entry.path.capacity() * sizeof(dtPolyRef) + entry.tiles.capacity() * sizeof(TileStamp));
+}
+
+NavMeshPathCache::EntryMap::iterator NavMeshPathCache::erase(EntryMap::iterator it)
+{
+    m_memoryBytes -= entryBytes(it->second);
+    m_lru.erase(it->second.lru);
+    return m_entries.erase(it);
+}
+
+bool NavMeshPathCache::find(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter *filter, dtPolyRef *path, int *pathCount, int maxPath, dtStatus *status)
+{
+    if (!m_navMesh || !filter)
+    {
+        return false;
+    }
+
+    FilterSettings settings;
+    readFilterSettings(filter, &settings);
+
+    const Key key = {startRef, endRef, hashFilterSettings(settings)};
+
+    EntryMap::iterator it = m_entries.find(key);
+    if (it == m_entries.end() || !(it->second.filter == settings))
+    {
+        m_misses++;
+        return false;
+    }
+
+    if (!isValid(it->second))
+    {
+        erase(it);
+        m_invalidations++;
+        m_misses++;
+        return false;
+    }
+
+    const Entry &entry = it->second;
+    if (int(entry.path.size()) > maxPath)
+    {
+        m_misses++;
+        return false;
+    }
+
+    memcpy(path, entry.path.data(), entry.path.size() * sizeof(dtPolyRef));
+    *pathCount = int(entry.path.size());
+    *status = entry.status;
+
+    m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+    m_hits++;
+
+    return true;
+}
+
+void NavMeshPathCache::store(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter *filter, const dtPolyRef *path, int pathCount, dtStatus status)
+{
+    if (!m_navMesh || !filter || pathCount <= 0 || dtStatusFailed(status))
+    {
+        return;
+    }
+
+    // Truncated paths would be served to later queries with a larger maxPath, and partial paths stay partial after
+    // a tile off the corridor is rebuilt to reach the end poly, as only corridor tiles are stamped
+    if (dtStatusDetail(status, DT_PARTIAL_RESULT) || dtStatusDetail(status, DT_BUFFER_TOO_SMALL) || dtStatusDetail(status, DT_OUT_OF_NODES))
+    {
+        return;
+    }
+
+    FilterSettings settings;
+    readFilterSettings(filter, &settings);
+
+    const Key key = {startRef, endRef, hashFilterSettings(settings)};
+
+    EntryMap::iterator existing = m_entries.find(key);
+    if (existing != m_entries.end())
+    {
+        erase(existing);
+    }
+
+    while (int(m_entries.size()) >= m_maxEntries)
+    {
+        erase(m_entries.find(m_lru.back()));
+        m_evictions++;
+    }
+
+    Entry entry;
+    entry.filter = settings;
+    entry.path.assign(path, path + pathCount);
+    entry.status = status;
+
+    // Corridors cross few tiles, so a linear search for unique tiles is enough
+    const dtNavMesh *navMesh = m_navMesh->m_navMesh;
+    for (int i = 0; i < pathCount; ++i)
+    {
+        const unsigned int tileIndex = navMesh->decodePolyIdTile(path[i]);
+
+        bool seen = false;
+        for (const TileStamp &stamp : entry.tiles)
+        {
+            if (stamp.tileIndex == tileIndex)
+            {
+                seen = true;
+                break;
+            }
+        }
+        if (seen)
+            continue;
+
+        TileStamp stamp;
+        stamp.tileIndex = tileIndex;
+        stamp.tileRef = navMesh->getTileRef(navMesh->getTile(int(tileIndex)));
+        stamp.version = m_navMesh->getTileVersion(int(tileIndex));
+        entry.tiles.push_back(stamp);
+    }
+
+    m_lru.push_front(key);
+    entry.lru = m_lru.begin();
+
+    m_memoryBytes += entryBytes(entry);
+    m_entries.emplace(key, std::move(entry));
+}
+
+int NavMeshPathCache::prune()
+{
+    int removed = 0;
+
+    EntryMap::iterator it = m_entries.begin();
+    while (it != m_entries.end())
+    {
+        if (isValid(it->second))
+        {
+            ++it;
+            continue;
+        }
+
+        it = erase(it);
+        removed++;
+    }
+
+    m_invalidations += removed;
+
+    return removed;
+}
+
+void NavMeshPathCache::clear()
+{
+    m_entries.clear();
+    m_lru.clear();
+    m_memoryBytes = 0;
+}
+
+NavMeshPathCacheStats NavMeshPathCache::getStats() const
+{
+    NavMeshPathCacheStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.invalidations = m_invalidations;
+    stats.evictions = m_evictions;
+    stats.entries = int(m_entries.size());
+    stats.memoryBytes = m_memoryBytes;
+    return stats;
+}
+
+void NavMeshPathCache::resetStats()
+{
+    m_hits = 0;
+    m_misses = 0;
+    m_invalidations = 0;
+    m_evictions = 0;
+}
+
+void NavMeshPathCache::destroy()
+{
+    clear();
+    m_navMesh = nullptr;
+    m_maxEntries = 0;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <list>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+#include "../recastnavigation/Detour/Include/DetourStatus.h"
+#include "../recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "../recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+#include "./NavMesh.h"
+
+struct NavMeshPathCacheStats
+{
+    int hits;
+    int misses;
+    int invalidations;
+    int evictions;
+    int entries;
+    int memoryBytes;
+};
+
+// Caches poly paths keyed on (startRef, endRef, filter), where the filter is keyed by its include and exclude flags and
+// area costs. Changing a filter's settings misses its earlier entries, and filters with the same settings share entries.
+//
+// An entry is invalidated when any tile on its corridor is removed, rebuilt or re-added, or has poly flags or areas set.
+// Rebuilt tiles, e.g. by TileCache::update, are detected from the tile salt, other changes from NavMesh tile versions.
+// Entries are validated when they are looked up, and the least recently used entry is evicted when the cache is full.
+class NavMeshPathCache
+{
+public:
+    NavMeshPathCache() : m_navMesh(nullptr), m_maxEntries(0), m_memoryBytes(0)
+    {
+        resetStats();
+    }
+
+    bool init(NavMesh *navMesh, int maxEntries);
+
+    // Returns true and writes the cached path if a valid entry exists, and the path fits in maxPath
+    bool find(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter *filter, dtPolyRef *path, int *pathCount, int maxPath, dtStatus *status);
+
+    // Stores a complete path. Failed, partial, truncated and out of nodes results are not stored.
+    void store(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter *filter, const dtPolyRef *path, int pathCount, dtStatus status);
+
+    // Removes all entries whose corridor is no longer valid
+    int prune();
+
+    void clear();
+
+    NavMeshPathCacheStats getStats() const;
+
+    void resetStats();
+
+    void destroy();
+
+private:
+    struct FilterSettings
+    {
+        unsigned short includeFlags;
+        unsigned short excludeFlags;
+        float areaCosts[DT_MAX_AREAS];
+
+        bool operator==(const FilterSettings &other) const
+        {
+            return memcmp(this, &other, sizeof(FilterSettings)) == 0;
+        }
+    };
+
+    // The key holds a hash of the filter settings, entries hold the settings to rule out collisions
+    struct Key
+    {
+        dtPolyRef startRef;
+        dtPolyRef endRef;
+        unsigned int filterHash;
+
+        bool operator==(const Key &other) const
+        {
+            return startRef == other.startRef && endRef == other.endRef && filterHash == other.filterHash;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            size_t h = std::hash<unsigned long long>()(((unsigned long long)key.startRef << 32) | key.endRef);
+            return h ^ (key.filterHash + 0x9e3779b9 + (h << 6) + (h >> 2));
+        }
+    };
+
+    struct TileStamp
+    {
+        unsigned int tileIndex;
+        dtTileRef tileRef;
+        unsigned int version;
+    };
+
+    struct Entry
+    {
+        FilterSettings filter;
+        std::vector<dtPolyRef> path;
+        std::vector<TileStamp> tiles;
+        dtStatus status;
+        std::list<Key>::iterator lru;
+    };
+
+    typedef std::unordered_map<Key, Entry, KeyHash> EntryMap;
+
+    static void readFilterSettings(const dtQueryFilter *filter, FilterSettings *settings);
+
+    static unsigned int hashFilterSettings(const FilterSettings &settings);
+
+    bool isValid(const Entry &entry) const;
+
+    int entryBytes(const Entry &entry) const;
+
+    EntryMap::iterator erase(EntryMap::iterator it);
+
+    NavMesh *m_navMesh;
+    int m_maxEntries;
+    int m_memoryBytes;
+
+    EntryMap m_entries;
+    std::list<Key> m_lru;
+
+    int m_hits;
+    int m_misses;
+    int m_invalidations;
+    int m_evictions;
+};
@@ -0,0 +1,259 @@
+#include "./NavMeshPathRequestManager.h"
+
+#include <chrono>
+#include <string.h>
+#include "../recastnavigation/Detour/Include/DetourCommon.h"
+
+static double pathRequestNowUs()
+{
+    using namespace std::chrono;
+    return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool NavMeshPathRequestManager::init(NavMesh *navMesh, int maxNodes, int maxRequests, int maxPath)
+{
+    if (!navMesh || !navMesh->m_navMesh || maxRequests <= 0 || maxRequests > 0xffff || maxPath <= 0)
+    {
+        return false;
+    }
+
+    destroy();
+
+    m_navQuery = dtAllocNavMeshQuery();
+    if (!m_navQuery || dtStatusFailed(m_navQuery->init(navMesh->m_navMesh, maxNodes)))
+    {
+        destroy();
+        return false;
+    }
+
+    m_maxRequests = maxRequests;
+    m_maxPath = maxPath;
+    m_requests.resize(maxRequests);
+    m_salts.assign(maxRequests, 1);
+    m_paths.resize(size_t(maxRequests) * maxPath);
+
+    for (Request &request : m_requests)
+    {
+        request.handle = 0;
+        request.state = PATH_REQUEST_INVALID;
+    }
+
+    return true;
+}
+
+int NavMeshPathRequestManager::findRequest(unsigned int handle) const
+{
+    const int slot = int(handle & 0xffff) - 1;
+    if (slot < 0 || slot >= m_maxRequests)
+    {
+        return -1;
+    }
+
+    if (m_requests[slot].state == PATH_REQUEST_INVALID || m_requests[slot].handle != handle)
+    {
+        return -1;
+    }
+
+    return slot;
+}
+
+unsigned int NavMeshPathRequestManager::request(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter, int priority)
+{
+    for (int i = 0; i < m_maxRequests; ++i)
+    {
+        Request &request = m_requests[i];
+        if (request.state != PATH_REQUEST_INVALID)
+            continue;
+
+        request.handle = (unsigned int)(m_salts[i]) << 16 | (unsigned int)(i + 1);
+        request.state = PATH_REQUEST_QUEUED;
+        request.priority = priority;
+        request.sequence = m_sequence++;
+        request.startRef = startRef;
+        request.endRef = endRef;
+        dtVcopy(request.startPos, startPos);
+        dtVcopy(request.endPos, endPos);
+        request.filter = filter;
+        request.status = 0;
+        request.pathCount = 0;
+
+        m_pending++;
+
+        return request.handle;
+    }
+
+    return 0;
+}
+
+int NavMeshPathRequestManager::nextRequest() const
+{
+    int best = -1;
+    for (int i = 0; i < m_maxRequests; ++i)
+    {
+        const Request &request = m_requests[i];
+        if (request.state != PATH_REQUEST_QUEUED)
+            continue;
+
+        if (best == -1 || request.priority > m_requests[best].priority ||
+            (request.priority == m_requests[best].priority && int(request.sequence - m_requests[best].sequence) < 0))
+        {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+NavMeshPathRequestManagerUpdateResult NavMeshPathRequestManager::update(int maxIterations, float maxTimeUs)
+{
+    NavMeshPathRequestManagerUpdateResult result;
+    result.iterations = 0;
+    result.completed = 0;
+
+    if (!m_navQuery)
+    {
+        result.pending = m_pending;
+        return result;
+    }
+
+    const double start = pathRequestNowUs();
+
+    while (m_pending > 0)
+    {
+        if (maxIterations > 0 && result.iterations >= maxIterations)
+            break;
+        if (maxTimeUs > 0 && result.iterations > 0 && pathRequestNowUs() - start >= maxTimeUs)
+            break;
+
+        if (m_active == -1)
+        {
+            m_active = nextRequest();
+            if (m_active == -1)
+                break;
+
+            Request &request = m_requests[m_active];
+            request.state = PATH_REQUEST_IN_PROGRESS;
+            request.status = m_navQuery->initSlicedFindPath(request.startRef, request.endRef, request.startPos, request.endPos, request.filter);
+        }
+
+        Request &request = m_requests[m_active];
+
+        if (dtStatusInProgress(request.status))
+        {
+            int iters = m_itersPerSlice;
+            if (maxIterations > 0 && maxIterations - result.iterations < iters)
+            {
+                iters = maxIterations - result.iterations;
+            }
+
+            int doneIters = 0;
+            request.status = m_navQuery->updateSlicedFindPath(iters, &doneIters);
+
+            // Count at least one iteration so an empty slice cannot stall the loop
+            result.iterations += doneIters > 0 ? doneIters : 1;
+        }
+
+        if (dtStatusSucceed(request.status))
+        {
+            request.status = m_navQuery->finalizeSlicedFindPath(&m_paths[size_t(m_active) * m_maxPath], &request.pathCount, m_maxPath);
+        }
+
+        if (dtStatusInProgress(request.status))
+            continue;
+
+        request.state = dtStatusSucceed(request.status) ? PATH_REQUEST_DONE : PATH_REQUEST_FAILED;
+        if (request.state == PATH_REQUEST_FAILED)
+        {
+            request.pathCount = 0;
+        }
+
+        m_active = -1;
+        m_pending--;
+        result.completed++;
+    }
+
+    result.pending = m_pending;
+    return result;
+}
+
+void NavMeshPathRequestManager::setIterationsPerSlice(int iterations)
+{
+    m_itersPerSlice = iterations > 0 ? iterations : 1;
+}
+
+int NavMeshPathRequestManager::getRequestState(unsigned int handle) const
+{
+    const int slot = findRequest(handle);
+    if (slot == -1)
+    {
+        return PATH_REQUEST_INVALID;
+    }
+
+    return m_requests[slot].state;
+}
+
+dtStatus NavMeshPathRequestManager::getRequestPath(unsigned int handle, UnsignedIntArray *path) const
+{
+    const int slot = findRequest(handle);
+    if (slot == -1)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const Request &request = m_requests[slot];
+    if (request.state == PATH_REQUEST_QUEUED || request.state == PATH_REQUEST_IN_PROGRESS)
+    {
+        return DT_IN_PROGRESS;
+    }
+
+    path->copy(&m_paths[size_t(slot) * m_maxPath], request.pathCount);
+
+    return request.status;
+}
+
+void NavMeshPathRequestManager::release(unsigned int handle)
+{
+    const int slot = findRequest(handle);
+    if (slot == -1)
+    {
+        return;
+    }
+
+    Request &request = m_requests[slot];
+    if (request.state == PATH_REQUEST_QUEUED || request.state == PATH_REQUEST_IN_PROGRESS)
+    {
+        m_pending--;
+    }
+
+    // An abandoned sliced query is replaced by the next initSlicedFindPath
+    if (m_active == slot)
+    {
+        m_active = -1;
+    }
+
+    request.handle = 0;
+    request.state = PATH_REQUEST_INVALID;
+
+    m_salts[slot]++;
+    if (m_salts[slot] == 0)
+    {
+        m_salts[slot] = 1;
+    }
+}
+
+void NavMeshPathRequestManager::destroy()
+{
+    if (m_navQuery)
+    {
+        dtFreeNavMeshQuery(m_navQuery);
+        m_navQuery = nullptr;
+    }
+
+    m_requests.clear();
+    m_salts.clear();
+    m_paths.clear();
+    m_maxRequests = 0;
+    m_maxPath = 0;
+    m_active = -1;
+    m_pending = 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include "../recastnavigation/Detour/Include/DetourStatus.h"
+#include "../recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "../recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+#include "./Arrays.h"
+#include "./NavMesh.h"
+
+enum NavMeshPathRequestState
+{
+    PATH_REQUEST_INVALID = 0,
+    PATH_REQUEST_QUEUED,
+    PATH_REQUEST_IN_PROGRESS,
+    PATH_REQUEST_DONE,
+    PATH_REQUEST_FAILED,
+};
+
+struct NavMeshPathRequestManagerUpdateResult
+{
+    int iterations;
+    int completed;
+    int pending;
+};
+
+// Runs path requests with sliced pathfinding under a per-update budget.
+// Requests are started highest priority first, ties in the order they were made.
+// The request being advanced runs to completion before another is started, so a new higher priority request waits for it.
+class NavMeshPathRequestManager
+{
+public:
+    NavMeshPathRequestManager() : m_navQuery(nullptr), m_maxRequests(0), m_maxPath(0), m_active(-1), m_sequence(0), m_pending(0), m_itersPerSlice(32) {}
+
+    // The manager uses its own dtNavMeshQuery so sliced queries do not interfere with other queries on the navmesh
+    bool init(NavMesh *navMesh, int maxNodes, int maxRequests, int maxPath);
+
+    // The filter must outlive the request. Returns a handle, or 0 if the request table is full.
+    unsigned int request(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter, int priority);
+
+    // Advances queued requests until either budget is used. A budget of 0 or less is unlimited.
+    NavMeshPathRequestManagerUpdateResult update(int maxIterations, float maxTimeUs);
+
+    // The number of search iterations per updateSlicedFindPath call, which is the granularity of the time budget
+    void setIterationsPerSlice(int iterations);
+
+    int getRequestState(unsigned int handle) const;
+
+    // Copies the path of a done request, the status has DT_PARTIAL_RESULT set if the end was not reached
+    dtStatus getRequestPath(unsigned int handle, UnsignedIntArray *path) const;
+
+    // Cancels the request if it is not done and frees its handle
+    void release(unsigned int handle);
+
+    int getPendingCount() const
+    {
+        return m_pending;
+    }
+
+    void destroy();
+
+private:
+    struct Request
+    {
+        unsigned int handle;
+        int state;
+        int priority;
+        unsigned int sequence;
+        dtPolyRef startRef;
+        dtPolyRef endRef;
+        float startPos[3];
+        float endPos[3];
+        const dtQueryFilter *filter;
+        dtStatus status;
+        int pathCount;
+    };
+
+    int findRequest(unsigned int handle) const;
+
+    int nextRequest() const;
+
+    dtNavMeshQuery *m_navQuery;
+    int m_maxRequests;
+    int m_maxPath;
+    int m_active;
+    unsigned int m_sequence;
+    int m_pending;
+    int m_itersPerSlice;
+
+    std::vector<Request> m_requests;
+    std::vector<unsigned short> m_salts;
+    std::vector<dtPolyRef> m_paths;
+};
@@ -1,11 +1,11 @@
 #include "./NavMeshQuery.h"
 
-NavMeshQuery::NavMeshQuery()
+NavMeshQuery::NavMeshQuery() : m_pathCache(nullptr)
 {
     m_navQuery = dtAllocNavMeshQuery();
 }
 
-NavMeshQuery::NavMeshQuery(dtNavMeshQuery *navMeshQuery)
+NavMeshQuery::NavMeshQuery(dtNavMeshQuery *navMeshQuery) : m_pathCache(nullptr)
 {
     m_navQuery = navMeshQuery;
 }
@@ -16,19 +16,270 @@ dtStatus NavMeshQuery::init(NavMesh *navMesh, const int maxNodes)
     return m_navQuery->init(nav, maxNodes);
 }
 
+void NavMeshQuery::setPathCache(NavMeshPathCache *pathCache)
+{
+    m_pathCache = pathCache;
+}
+
+void NavMeshQuery::clearPathCache()
+{
+    m_pathCache = nullptr;
+}
+
+dtStatus NavMeshQuery::findPathScratch(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter, int *pathCount, int maxPath)
+{
+    dtStatus status;
+
+    if (m_pathCache && m_pathCache->find(startRef, endRef, filter, m_pathScratch.data(), pathCount, maxPath, &status))
+    {
+        return status;
+    }
+
+    status = m_navQuery->findPath(startRef, endRef, startPos, endPos, filter, m_pathScratch.data(), pathCount, maxPath);
+
+    if (m_pathCache)
+    {
+        m_pathCache->store(startRef, endRef, filter, m_pathScratch.data(), *pathCount, status);
+    }
+
+    return status;
+}
+
 dtStatus NavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter, UnsignedIntArray *path, int maxPath)
 {
-    dtPolyRef *pathArray = new dtPolyRef[maxPath];
-    int pathCount;
+    if (int(m_pathScratch.size()) < maxPath)
+    {
+        m_pathScratch.resize(maxPath);
+    }
 
-    dtStatus status = m_navQuery->findPath(startRef, endRef, startPos, endPos, filter, pathArray, &pathCount, maxPath);
+    int pathCount = 0;
 
-    path->copy(pathArray, pathCount);
-    delete[] pathArray;
+    dtStatus status = findPathScratch(startRef, endRef, startPos, endPos, filter, &pathCount, maxPath);
+
+    path->copy(m_pathScratch.data(), pathCount);
 
     return status;
 }
 
+dtStatus NavMeshQuery::initSlicedFindPath(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter, const unsigned int options)
+{
+    return m_navQuery->initSlicedFindPath(startRef, endRef, startPos, endPos, filter, options);
+}
+
+dtStatus NavMeshQuery::updateSlicedFindPath(const int maxIter, IntRef *doneIters)
+{
+    int iters = 0;
+
+    dtStatus status = m_navQuery->updateSlicedFindPath(maxIter, &iters);
+
+    doneIters->value = iters;
+
+    return status;
+}
+
+dtStatus NavMeshQuery::finalizeSlicedFindPath(UnsignedIntArray *path, int maxPath)
+{
+    if (int(m_pathScratch.size()) < maxPath)
+    {
+        m_pathScratch.resize(maxPath);
+    }
+
+    int pathCount = 0;
+
+    dtStatus status = m_navQuery->finalizeSlicedFindPath(m_pathScratch.data(), &pathCount, maxPath);
+
+    path->copy(m_pathScratch.data(), pathCount);
+
+    return status;
+}
+
+dtStatus NavMeshQuery::finalizeSlicedFindPathPartial(const UnsignedIntArray *existing, UnsignedIntArray *path, int maxPath)
+{
+    if (int(m_pathScratch.size()) < maxPath)
+    {
+        m_pathScratch.resize(maxPath);
+    }
+
+    int pathCount = 0;
+
+    dtStatus status = m_navQuery->finalizeSlicedFindPathPartial(existing->data, existing->size, m_pathScratch.data(), &pathCount, maxPath);
+
+    path->copy(m_pathScratch.data(), pathCount);
+
+    return status;
+}
+
+dtStatus NavMeshQuery::findPathBatch(const FloatArray *positions, const float *halfExtents, const dtQueryFilter *filter, int maxPath, UnsignedIntArray *result)
+{
+    if (!positions || positions->size % 6 != 0 || maxPath <= 0)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const int count = positions->size / 6;
+
+    if (int(m_pathScratch.size()) < maxPath)
+    {
+        m_pathScratch.resize(maxPath);
+    }
+
+    // offsets and statuses, poly refs are appended after
+    std::vector<unsigned int> &packed = m_batchScratch;
+    packed.assign(count * 2 + 1, 0);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const float *startPos = &positions->data[i * 6];
+        const float *endPos = &positions->data[i * 6 + 3];
+
+        dtPolyRef startRef = 0;
+        dtPolyRef endRef = 0;
+        dtStatus status = m_navQuery->findNearestPoly(startPos, halfExtents, filter, &startRef, nullptr);
+        if (dtStatusSucceed(status))
+        {
+            status = m_navQuery->findNearestPoly(endPos, halfExtents, filter, &endRef, nullptr);
+        }
+        if (dtStatusSucceed(status) && (!startRef || !endRef))
+        {
+            status = DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        int pathCount = 0;
+        if (dtStatusSucceed(status))
+        {
+            status = findPathScratch(startRef, endRef, startPos, endPos, filter, &pathCount, maxPath);
+        }
+
+        if (dtStatusSucceed(status))
+        {
+            packed.insert(packed.end(), m_pathScratch.begin(), m_pathScratch.begin() + pathCount);
+        }
+        else
+        {
+            pathCount = 0;
+        }
+
+        packed[i + 1] = packed[i] + pathCount;
+        packed[count + 1 + i] = status;
+    }
+
+    const int size = int(packed.size());
+    if (result->size < size || result->isView)
+    {
+        result->resize(size);
+    }
+    memcpy(result->data, packed.data(), size * sizeof(unsigned int));
+
+    return DT_SUCCESS;
+}
+
+NavMeshQueryComputePathResult NavMeshQuery::computePath(const float *start, const float *end, const float *halfExtents, const dtQueryFilter *filter, int maxPathPolys, int maxStraightPathPoints, UnsignedIntArray *result)
+{
+    NavMeshQueryComputePathResult computePathResult;
+    computePathResult.status = DT_SUCCESS;
+    computePathResult.error = COMPUTE_PATH_ERROR_NONE;
+    computePathResult.straightPathCount = 0;
+
+    if (maxPathPolys <= 0 || maxStraightPathPoints <= 0)
+    {
+        computePathResult.status = DT_FAILURE | DT_INVALID_PARAM;
+        computePathResult.error = COMPUTE_PATH_ERROR_FIND_PATH_FAILED;
+        return computePathResult;
+    }
+
+    // find nearest polygons for start and end positions
+    dtPolyRef startRef = 0;
+    dtStatus status = m_navQuery->findNearestPoly(start, halfExtents, filter, &startRef, nullptr);
+    if (dtStatusFailed(status))
+    {
+        computePathResult.status = status;
+        computePathResult.error = COMPUTE_PATH_ERROR_START_NEAREST_POLY_FAILED;
+        return computePathResult;
+    }
+
+    dtPolyRef endRef = 0;
+    status = m_navQuery->findNearestPoly(end, halfExtents, filter, &endRef, nullptr);
+    if (dtStatusFailed(status))
+    {
+        computePathResult.status = status;
+        computePathResult.error = COMPUTE_PATH_ERROR_END_NEAREST_POLY_FAILED;
+        return computePathResult;
+    }
+
+    // find polygon path
+    if (int(m_pathScratch.size()) < maxPathPolys)
+    {
+        m_pathScratch.resize(maxPathPolys);
+    }
+
+    int pathCount = 0;
+    status = findPathScratch(startRef, endRef, start, end, filter, &pathCount, maxPathPolys);
+    if (dtStatusFailed(status))
+    {
+        computePathResult.status = status;
+        computePathResult.error = COMPUTE_PATH_ERROR_FIND_PATH_FAILED;
+        return computePathResult;
+    }
+
+    if (pathCount <= 0)
+    {
+        computePathResult.error = COMPUTE_PATH_ERROR_NO_POLYGON_PATH_FOUND;
+        return computePathResult;
+    }
+
+    // clamp the end to the last polygon of partial paths
+    float closestEnd[3];
+    dtVcopy(closestEnd, end);
+
+    const dtPolyRef lastPoly = m_pathScratch[pathCount - 1];
+    if (lastPoly != endRef)
+    {
+        status = m_navQuery->closestPointOnPoly(lastPoly, end, closestEnd, nullptr);
+        if (dtStatusFailed(status))
+        {
+            computePathResult.status = status;
+            computePathResult.error = COMPUTE_PATH_ERROR_NO_CLOSEST_POINT_ON_LAST_POLYGON_FOUND;
+            return computePathResult;
+        }
+    }
+
+    // find straight path
+    if (int(m_straightPathRefsScratch.size()) < maxStraightPathPoints)
+    {
+        m_straightPathScratch.resize(maxStraightPathPoints * 3);
+        m_straightPathFlagsScratch.resize(maxStraightPathPoints);
+        m_straightPathRefsScratch.resize(maxStraightPathPoints);
+    }
+
+    int straightPathCount = 0;
+    status = m_navQuery->findStraightPath(start, closestEnd, m_pathScratch.data(), pathCount, m_straightPathScratch.data(), m_straightPathFlagsScratch.data(), m_straightPathRefsScratch.data(), &straightPathCount, maxStraightPathPoints, 0);
+    if (dtStatusFailed(status))
+    {
+        computePathResult.status = status;
+        computePathResult.error = COMPUTE_PATH_ERROR_FIND_STRAIGHT_PATH_FAILED;
+        return computePathResult;
+    }
+
+    // pack corners
+    const int size = straightPathCount * 5;
+    if (result->size < size || result->isView)
+    {
+        result->resize(size);
+    }
+
+    for (int i = 0; i < straightPathCount; ++i)
+    {
+        unsigned int *corner = &result->data[i * 5];
+        memcpy(corner, &m_straightPathScratch[i * 3], sizeof(float) * 3);
+        corner[3] = m_straightPathFlagsScratch[i];
+        corner[4] = m_straightPathRefsScratch[i];
+    }
+
+    computePathResult.status = status;
+    computePathResult.straightPathCount = straightPathCount;
+    return computePathResult;
+}
+
 dtStatus NavMeshQuery::closestPointOnPoly(dtPolyRef ref, const float *pos, Vec3 *closest, BoolRef *posOverPoly)
 {
     return m_navQuery->closestPointOnPoly(ref, pos, &closest->x, &posOverPoly->value);
@@ -53,6 +304,76 @@ dtStatus NavMeshQuery::findNearestPoly(const float *center, const float *halfExt
     return m_navQuery->findNearestPoly(center, halfExtents, filter, &nearestRef->value, &nearestPt->x, &isOverPoly->value);
 }
 
+dtStatus NavMeshQuery::findNearestPolyBatch(const FloatArray *points, const float *halfExtents, const dtQueryFilter *filter, UnsignedIntArray *nearestRefs, FloatArray *nearestPoints, UnsignedCharArray *isOverPoly)
+{
+    if (!points || points->size % 3 != 0)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const int count = points->size / 3;
+
+    if (nearestRefs->size < count || nearestRefs->isView)
+    {
+        nearestRefs->resize(count);
+    }
+    if (nearestPoints->size < count * 3 || nearestPoints->isView)
+    {
+        nearestPoints->resize(count * 3);
+    }
+    if (isOverPoly->size < count || isOverPoly->isView)
+    {
+        isOverPoly->resize(count);
+    }
+
+    const dtNavMesh *navMesh = m_navQuery->getAttachedNavMesh();
+
+    dtPolyRef prevRef = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const float *pos = &points->data[i * 3];
+        float *nearestPt = &nearestPoints->data[i * 3];
+
+        // Neighbouring points often land on the same poly. If the point is over the previous poly, within climb height
+        // of it and within the query box, findNearestPoly would also find that poly as a zero distance match, so skip
+        // the tile query.
+        if (prevRef)
+        {
+            const dtMeshTile *tile = 0;
+            const dtPoly *poly = 0;
+            navMesh->getTileAndPolyByRefUnsafe(prevRef, &tile, &poly);
+
+            bool posOverPoly = false;
+            if (poly->getType() == DT_POLYTYPE_GROUND &&
+                dtStatusSucceed(m_navQuery->closestPointOnPoly(prevRef, pos, nearestPt, &posOverPoly)) &&
+                posOverPoly && dtAbs(nearestPt[1] - pos[1]) <= tile->header->walkableClimb &&
+                dtAbs(nearestPt[1] - pos[1]) <= halfExtents[1])
+            {
+                nearestRefs->data[i] = prevRef;
+                isOverPoly->data[i] = 1;
+                continue;
+            }
+        }
+
+        dtPolyRef ref = 0;
+        bool overPoly = false;
+        dtStatus status = m_navQuery->findNearestPoly(pos, halfExtents, filter, &ref, nearestPt, &overPoly);
+
+        if (dtStatusFailed(status) || !ref)
+        {
+            ref = 0;
+            overPoly = false;
+            dtVcopy(nearestPt, pos);
+        }
+
+        nearestRefs->data[i] = ref;
+        isOverPoly->data[i] = overPoly ? 1 : 0;
+        prevRef = ref;
+    }
+
+    return DT_SUCCESS;
+}
+
 dtStatus NavMeshQuery::findPolysAroundCircle(dtPolyRef startRef, const float *centerPos, const float radius, const dtQueryFilter *filter, UnsignedIntArray *resultRef, UnsignedIntArray *resultParent, FloatArray *resultCost, IntRef *resultCount, const int maxResult)
 {
     return m_navQuery->findPolysAroundCircle(startRef, centerPos, radius, filter, resultRef->data, resultParent->data, resultCost->data, &resultCount->value, maxResult);
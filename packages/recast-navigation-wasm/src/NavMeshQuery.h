@@ -8,6 +8,8 @@
 #include "./Arrays.h"
 #include "./Vec.h"
 #include "./NavMesh.h"
+#include "./NavMeshPathCache.h"
+#include <vector>
 
 class FastRand
 {
@@ -36,6 +38,24 @@ public:
     }
 };
 
+enum NavMeshQueryComputePathError
+{
+    COMPUTE_PATH_ERROR_NONE = 0,
+    COMPUTE_PATH_ERROR_START_NEAREST_POLY_FAILED,
+    COMPUTE_PATH_ERROR_END_NEAREST_POLY_FAILED,
+    COMPUTE_PATH_ERROR_FIND_PATH_FAILED,
+    COMPUTE_PATH_ERROR_NO_POLYGON_PATH_FOUND,
+    COMPUTE_PATH_ERROR_NO_CLOSEST_POINT_ON_LAST_POLYGON_FOUND,
+    COMPUTE_PATH_ERROR_FIND_STRAIGHT_PATH_FAILED,
+};
+
+struct NavMeshQueryComputePathResult
+{
+    unsigned int status;
+    int error;
+    int straightPathCount;
+};
+
 class NavMeshQuery
 {
 public:
@@ -47,8 +67,30 @@ public:
 
     dtStatus init(NavMesh *navMesh, const int maxNodes);
 
+    // Paths found by findPath, findPathBatch and computePath are looked up in and stored to the cache while one is set
+    void setPathCache(NavMeshPathCache *pathCache);
+
+    void clearPathCache();
+
     dtStatus findPath(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter, UnsignedIntArray *path, int maxPath);
 
+    dtStatus initSlicedFindPath(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter, const unsigned int options);
+
+    dtStatus updateSlicedFindPath(const int maxIter, IntRef *doneIters);
+
+    dtStatus finalizeSlicedFindPath(UnsignedIntArray *path, int maxPath);
+
+    dtStatus finalizeSlicedFindPathPartial(const UnsignedIntArray *existing, UnsignedIntArray *path, int maxPath);
+
+    // Finds paths for each start/end pair in positions [(startX, startY, startZ, endX, endY, endZ) * count].
+    // The result is packed as [offsets (count + 1)][statuses (count)][poly refs], offsets index into the poly refs.
+    // The result array is only grown, so it can be reused across calls.
+    dtStatus findPathBatch(const FloatArray *positions, const float *halfExtents, const dtQueryFilter *filter, int maxPath, UnsignedIntArray *result);
+
+    // Finds the nearest polys, the poly path, clamps the end to the last poly of partial paths and finds the straight path.
+    // Corners are packed into result as [x, y, z (float bits), flags, ref] * straightPathCount. The result array is only grown.
+    NavMeshQueryComputePathResult computePath(const float *start, const float *end, const float *halfExtents, const dtQueryFilter *filter, int maxPathPolys, int maxStraightPathPoints, UnsignedIntArray *result);
+
     dtStatus closestPointOnPoly(dtPolyRef ref, const float *pos, Vec3 *closest, BoolRef *posOverPoly);
 
     dtStatus findClosestPoint(const float *position, const float *halfExtents, const dtQueryFilter *filter, UnsignedIntRef *resultPolyRef, Vec3 *resultPoint, BoolRef *resultPosOverPoly);
@@ -66,6 +108,10 @@ public:
 
     dtStatus findNearestPoly(const float *center, const float *halfExtents, const dtQueryFilter *filter, UnsignedIntRef *nearestRef, Vec3 *nearestPt, BoolRef *isOverPoly);
 
+    // Finds the nearest poly for each point in points [(x, y, z) * count], writing refs, nearest points and over-poly flags.
+    // Refs are 0 where no poly was found. Output arrays are only grown, so they can be reused across calls.
+    dtStatus findNearestPolyBatch(const FloatArray *points, const float *halfExtents, const dtQueryFilter *filter, UnsignedIntArray *nearestRefs, FloatArray *nearestPoints, UnsignedCharArray *isOverPoly);
+
     dtStatus findPolysAroundCircle(dtPolyRef startRef, const float *centerPos, const float radius, const dtQueryFilter *filter, UnsignedIntArray *resultRef, UnsignedIntArray *resultParent, FloatArray *resultCost, IntRef *resultCount, const int maxResult);
 
     dtStatus queryPolygons(const float *center, const float *halfExtents, const dtQueryFilter *filter, UnsignedIntArray *polys, IntRef *polyCount, const int maxPolys);
@@ -81,4 +127,15 @@ public:
     dtStatus getPolyHeight(dtPolyRef ref, const float *pos, FloatRef *height);
 
     void destroy();
+
+private:
+    // Finds a path into m_pathScratch, which must hold maxPath refs
+    dtStatus findPathScratch(dtPolyRef startRef, dtPolyRef endRef, const float *startPos, const float *endPos, const dtQueryFilter *filter, int *pathCount, int maxPath);
+
+    NavMeshPathCache *m_pathCache;
+    std::vector<dtPolyRef> m_pathScratch;
+    std::vector<unsigned int> m_batchScratch;
+    std::vector<float> m_straightPathScratch;
+    std::vector<unsigned char> m_straightPathFlagsScratch;
+    std::vector<dtPolyRef> m_straightPathRefsScratch;
 };
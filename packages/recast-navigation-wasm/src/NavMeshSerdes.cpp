@@ -1,9 +1,27 @@
 #include "./NavMeshSerdes.h"
 
+#include <algorithm>
+#include <limits.h>
+#include <stdint.h>
+#include <vector>
+
 static const int NAVMESHSET_MAGIC = 'M' << 24 | 'S' << 16 | 'E' << 8 | 'T'; //'MSET';
 static const int NAVMESHSET_VERSION = 1;
 static const int TILECACHESET_MAGIC = 'T' << 24 | 'S' << 16 | 'E' << 8 | 'T'; //'TSET';
 static const int TILECACHESET_VERSION = 1;
+static const int NAVMESHSET_COMPRESSED_MAGIC = 'M' << 24 | 'S' << 16 | 'E' << 8 | 'Z'; //'MSEZ';
+static const int NAVMESHSET_COMPRESSED_VERSION = 1;
+static const int NAVMESHSET_COMPRESSION_FASTLZ = 1;
+static const int NAVMESHSET_COMPRESSION_CUSTOM = 2;
+static const int NAVMESHINDEX_MAGIC = 'M' << 24 | 'I' << 16 | 'D' << 8 | 'X'; //'MIDX';
+static const int NAVMESHINDEX_VERSION = 1;
+static const int NAVMESHINDEX_PAYLOAD_ALIGNMENT = 16;
+static const int CROWDSNAPSHOT_MAGIC = 'C' << 24 | 'R' << 16 | 'W' << 8 | 'D'; //'CRWD';
+static const int CROWDSNAPSHOT_VERSION = 1;
+static const int CROWDSNAPSHOT_HAS_UPDATER = 1;
+
+// dtCrowd allocates agent corridors with this many polys
+static const int CROWDSNAPSHOT_MAX_PATH = 256;
 
 struct RecastHeader
 {
@@ -35,12 +53,113 @@ struct NavMeshTileHeader
     int dataSize;
 };
 
-NavMeshImporterResult NavMeshImporter::importNavMesh(NavMeshExport *navMeshExport, TileCacheMeshProcessJsImpl &meshProcess)
+struct NavMeshCompressedSetHeader
+{
+    dtNavMeshParams params;
+    int compression;
+};
+
+struct NavMeshCompressedTileHeader
+{
+    dtTileRef tileRef;
+    int dataSize;
+    int compressedSize;
+};
+
+struct NavMeshIndexHeader
+{
+    dtNavMeshParams params;
+    int payloadAlignment;
+};
+
+struct CrowdSnapshotHeader
+{
+    int maxAgents;
+    int flags;
+    unsigned int tick;
+
+    // Struct sizes of the build that wrote the snapshot, which must match to restore it
+    int agentSize;
+    int boundarySize;
+};
+
+struct CrowdSnapshotFilter
+{
+    float areaCost[DT_MAX_AREAS];
+    unsigned short includeFlags;
+    unsigned short excludeFlags;
+};
+
+// Followed by pathCount corridor polys and the agent's dtLocalBoundary
+struct CrowdSnapshotAgent
+{
+    int idx;
+    unsigned char state;
+    unsigned char partial;
+    unsigned char targetState;
+    unsigned char targetReplan;
+    dtCrowdAgentParams params;
+    float topologyOptTime;
+    dtCrowdNeighbour neis[DT_CROWDAGENT_MAX_NEIGHBOURS];
+    int nneis;
+    float desiredSpeed;
+    float npos[3];
+    float disp[3];
+    float dvel[3];
+    float nvel[3];
+    float vel[3];
+    float cornerVerts[DT_CROWDAGENT_MAX_CORNERS * 3];
+    unsigned char cornerFlags[DT_CROWDAGENT_MAX_CORNERS];
+    dtPolyRef cornerPolys[DT_CROWDAGENT_MAX_CORNERS];
+    int ncorners;
+    dtPolyRef targetRef;
+    float targetPos[3];
+    float targetReplanTime;
+    float corridorPos[3];
+    float corridorTarget[3];
+    int pathCount;
+    int lodTier;
+    dtCrowdAgentAnimation animation;
+};
+
+static unsigned int navMeshIndexChecksum(const unsigned char *data, int size)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t navMeshIndexAlign(size_t offset)
+{
+    return (offset + NAVMESHINDEX_PAYLOAD_ALIGNMENT - 1) & ~size_t(NAVMESHINDEX_PAYLOAD_ALIGNMENT - 1);
+}
+
+static bool navMeshIndexTileLess(const NavMeshIndexTileEntry &a, const NavMeshIndexTileEntry &b)
+{
+    if (a.tileY != b.tileY)
+        return a.tileY < b.tileY;
+    if (a.tileX != b.tileX)
+        return a.tileX < b.tileX;
+    return a.layer < b.layer;
+}
+
+NavMeshImporterResult NavMeshImporter::importNavMesh(NavMeshExport *navMeshExport, TileCacheMeshProcessJsImpl &meshProcess, dtTileCacheCompressor *compressor)
 {
     NavMeshImporterResult result;
     result.success = false;
 
     unsigned char *bits = (unsigned char *)navMeshExport->dataPointer;
+    const unsigned char *end = bits + navMeshExport->size;
+
+    if (!bits || navMeshExport->size < int(sizeof(RecastHeader)))
+    {
+        return result;
+    }
 
     // Read header.
     RecastHeader recastHeader;
@@ -89,11 +208,108 @@ NavMeshImporterResult NavMeshImporter::importNavMesh(NavMeshExport *navMeshExpor
             memcpy(data, bits, readLen);
             bits += readLen;
 
-            UnsignedCharArray *navMeshData = new UnsignedCharArray;
-            navMeshData->data = data;
-            navMeshData->size = tileHeader.dataSize;
+            dtStatus status = navMesh->m_navMesh->addTile(data, tileHeader.dataSize, DT_TILE_FREE_DATA, tileHeader.tileRef, nullptr);
+            if (dtStatusFailed(status))
+            {
+                dtFree(data);
+            }
+        }
+
+        result.navMesh = navMesh;
+    }
+    else if (recastHeader.magic == NAVMESHSET_COMPRESSED_MAGIC)
+    {
+        if (recastHeader.version != NAVMESHSET_COMPRESSED_VERSION)
+        {
+            return result;
+        }
+
+        NavMeshCompressedSetHeader header;
+        readLen = sizeof(NavMeshCompressedSetHeader);
+        if (size_t(end - bits) < readLen)
+        {
+            return result;
+        }
+        memcpy(&header, bits, readLen);
+        bits += readLen;
+
+        // Exports compressed with a custom codec can only be read with it
+        RecastFastLZCompressor fastLZCompressor;
+        dtTileCacheCompressor *tileCompressor = nullptr;
+        if (header.compression == NAVMESHSET_COMPRESSION_FASTLZ)
+        {
+            tileCompressor = &fastLZCompressor;
+        }
+        else if (header.compression == NAVMESHSET_COMPRESSION_CUSTOM)
+        {
+            tileCompressor = compressor;
+        }
+
+        if (!tileCompressor)
+        {
+            return result;
+        }
+
+        NavMesh *navMesh = new NavMesh;
+        if (!navMesh->initTiled(&header.params))
+        {
+            navMesh->destroy();
+            delete navMesh;
+            return result;
+        }
+
+        // Read tiles, decompressing straight into the tile buffer.
+        for (int i = 0; i < recastHeader.numTiles; ++i)
+        {
+            // A truncated or corrupt export fails the import, rather than reading past the buffer
+            NavMeshCompressedTileHeader tileHeader;
+            readLen = sizeof(tileHeader);
+            if (size_t(end - bits) < readLen)
+            {
+                navMesh->destroy();
+                delete navMesh;
+                return result;
+            }
+            memcpy(&tileHeader, bits, readLen);
+            bits += readLen;
+
+            if (!tileHeader.tileRef || !tileHeader.dataSize || !tileHeader.compressedSize)
+            {
+                break;
+            }
+
+            if (tileHeader.dataSize < 0 || tileHeader.compressedSize < 0 || tileHeader.compressedSize > end - bits)
+            {
+                navMesh->destroy();
+                delete navMesh;
+                return result;
+            }
 
-            navMesh->addTile(navMeshData, DT_TILE_FREE_DATA, tileHeader.tileRef, nullptr);
+            unsigned char *data = (unsigned char *)dtAlloc(tileHeader.dataSize, DT_ALLOC_PERM);
+            if (!data)
+            {
+                navMesh->destroy();
+                delete navMesh;
+                return result;
+            }
+
+            int dataSize = 0;
+            dtStatus status = tileCompressor->decompress(bits, tileHeader.compressedSize, data, tileHeader.dataSize, &dataSize);
+            bits += tileHeader.compressedSize;
+
+            if (dtStatusFailed(status) || dataSize != tileHeader.dataSize)
+            {
+                dtFree(data);
+                navMesh->destroy();
+                delete navMesh;
+                return result;
+            }
+
+            status = navMesh->m_navMesh->addTile(data, tileHeader.dataSize, DT_TILE_FREE_DATA, tileHeader.tileRef, nullptr);
+            if (dtStatusFailed(status))
+            {
+                dtFree(data);
+            }
         }
 
         result.navMesh = navMesh;
@@ -150,19 +366,16 @@ NavMeshImporterResult NavMeshImporter::importNavMesh(NavMeshExport *navMeshExpor
             memcpy(data, bits, readLen);
             bits += readLen;
 
-            UnsignedCharArray *tileCacheData = new UnsignedCharArray;
-            tileCacheData->data = data;
-            tileCacheData->size = tileHeader.dataSize;
-
-            TileCacheAddTileResult addTileResult = tileCache->addTile(tileCacheData, DT_COMPRESSEDTILE_FREE_DATA);
-            if (dtStatusFailed(addTileResult.status))
+            dtCompressedTileRef tileRef = 0;
+            dtStatus status = tileCache->m_tileCache->addTile(data, tileHeader.dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
+            if (dtStatusFailed(status))
             {
                 dtFree(data);
             }
 
-            if (addTileResult.tileRef)
+            if (tileRef)
             {
-                tileCache->buildNavMeshTile(&addTileResult.tileRef, navMesh);
+                tileCache->buildNavMeshTile(&tileRef, navMesh);
             }
         }
 
@@ -176,19 +389,161 @@ NavMeshImporterResult NavMeshImporter::importNavMesh(NavMeshExport *navMeshExpor
     return result;
 }
 
-NavMeshExport NavMeshExporter::exportNavMesh(NavMesh *navMesh, TileCache *tileCache) const
+NavMeshImporterResult NavMeshImporter::importNavMeshInPlace(NavMeshExport *navMeshExport)
 {
-    if (!navMesh->m_navMesh)
+    NavMeshImporterResult result;
+    result.success = false;
+    result.navMesh = nullptr;
+    result.tileCache = nullptr;
+    result.allocator = nullptr;
+    result.compressor = nullptr;
+
+    unsigned char *bits = (unsigned char *)navMeshExport->dataPointer;
+    unsigned char *end = bits + navMeshExport->size;
+
+    if (!bits || navMeshExport->size < int(sizeof(RecastHeader) + sizeof(NavMeshSetHeader)))
     {
-        return {0, 0};
+        return result;
     }
 
-    unsigned char *bits = nullptr;
-    size_t bitsSize = 0;
+    // Read header.
+    RecastHeader recastHeader;
+    memcpy(&recastHeader, bits, sizeof(RecastHeader));
+    bits += sizeof(RecastHeader);
 
-    const dtNavMesh *m_navMesh = navMesh->m_navMesh;
-    const dtTileCache *m_tileCache = tileCache->m_tileCache;
+    // Only navmesh sets store tiles in their runtime layout, tile cache sets must be decompressed.
+    if (recastHeader.magic != NAVMESHSET_MAGIC || recastHeader.version != NAVMESHSET_VERSION)
+    {
+        return result;
+    }
+
+    NavMeshSetHeader header;
+    memcpy(&header, bits, sizeof(NavMeshSetHeader));
+    bits += sizeof(NavMeshSetHeader);
+
+    NavMesh *navMesh = new NavMesh;
+    if (!navMesh->initTiled(&header.params))
+    {
+        navMesh->destroy();
+        delete navMesh;
+        return result;
+    }
 
+    // Validate the tile directory before adding anything, tiles reference the buffer directly.
+    unsigned char *tileBits = bits;
+    for (int i = 0; i < recastHeader.numTiles; ++i)
+    {
+        if (tileBits + sizeof(NavMeshTileHeader) > end)
+        {
+            break;
+        }
+
+        NavMeshTileHeader tileHeader;
+        memcpy(&tileHeader, tileBits, sizeof(NavMeshTileHeader));
+        tileBits += sizeof(NavMeshTileHeader);
+
+        if (!tileHeader.tileRef || !tileHeader.dataSize)
+        {
+            break;
+        }
+
+        if (tileHeader.dataSize < 0 || tileHeader.dataSize > end - tileBits || ((uintptr_t)tileBits & 3) != 0)
+        {
+            navMesh->destroy();
+            delete navMesh;
+            return result;
+        }
+
+        tileBits += tileHeader.dataSize;
+    }
+
+    // Add tiles pointing into the buffer.
+    for (int i = 0; i < recastHeader.numTiles; ++i)
+    {
+        if (bits + sizeof(NavMeshTileHeader) > end)
+        {
+            break;
+        }
+
+        NavMeshTileHeader tileHeader;
+        memcpy(&tileHeader, bits, sizeof(NavMeshTileHeader));
+        bits += sizeof(NavMeshTileHeader);
+
+        if (!tileHeader.tileRef || !tileHeader.dataSize)
+        {
+            break;
+        }
+
+        // A failed tile fails the in place import rather than being dropped, the buffer is not adopted yet
+        dtStatus status = navMesh->m_navMesh->addTile(bits, tileHeader.dataSize, 0, tileHeader.tileRef, nullptr);
+        if (dtStatusFailed(status))
+        {
+            navMesh->destroy();
+            delete navMesh;
+            return result;
+        }
+
+        bits += tileHeader.dataSize;
+    }
+
+    // The navmesh now owns the buffer.
+    navMesh->adoptData(navMeshExport->dataPointer);
+
+    result.navMesh = navMesh;
+    result.success = true;
+    return result;
+}
+
+struct NavMeshExportSizeWriter
+{
+    size_t size = 0;
+
+    void write(const void *data, size_t len)
+    {
+        size += len;
+    }
+};
+
+struct NavMeshExportBufferWriter
+{
+    unsigned char *bits;
+    size_t offset = 0;
+
+    NavMeshExportBufferWriter(unsigned char *inBits) : bits(inBits) {}
+
+    void write(const void *data, size_t len)
+    {
+        memcpy(&bits[offset], data, len);
+        offset += len;
+    }
+};
+
+struct NavMeshExportSinkWriter
+{
+    NavMeshExportSinkJsImpl &sink;
+    size_t chunkSize;
+    size_t size = 0;
+
+    NavMeshExportSinkWriter(NavMeshExportSinkJsImpl &inSink, size_t inChunkSize) : sink(inSink), chunkSize(inChunkSize) {}
+
+    void write(const void *data, size_t len)
+    {
+        // Hand out views into the source data, no intermediate copy is made.
+        const unsigned char *bytes = (const unsigned char *)data;
+        while (len > 0)
+        {
+            const size_t n = len < chunkSize ? len : chunkSize;
+            sink.write((void *)bytes, int(n));
+            bytes += n;
+            len -= n;
+            size += n;
+        }
+    }
+};
+
+template <typename Writer>
+static void writeNavMeshExport(const dtNavMesh *m_navMesh, const dtTileCache *m_tileCache, Writer &writer)
+{
     if (m_tileCache)
     {
         // tilecache set
@@ -208,13 +563,8 @@ NavMeshExport NavMeshExporter::exportNavMesh(NavMesh *navMesh, TileCache *tileCa
         memcpy(&header.cacheParams, m_tileCache->getParams(), sizeof(dtTileCacheParams));
         memcpy(&header.meshParams, m_navMesh->getParams(), sizeof(dtNavMeshParams));
 
-        bits = (unsigned char *)realloc(bits, bitsSize + sizeof(RecastHeader));
-        memcpy(&bits[bitsSize], &recastHeader, sizeof(RecastHeader));
-        bitsSize += sizeof(RecastHeader);
-
-        bits = (unsigned char *)realloc(bits, bitsSize + sizeof(TileCacheSetHeader));
-        memcpy(&bits[bitsSize], &header, sizeof(TileCacheSetHeader));
-        bitsSize += sizeof(TileCacheSetHeader);
+        writer.write(&recastHeader, sizeof(RecastHeader));
+        writer.write(&header, sizeof(TileCacheSetHeader));
 
         // Store tiles.
         for (int i = 0; i < m_tileCache->getTileCount(); ++i)
@@ -227,13 +577,8 @@ NavMeshExport NavMeshExporter::exportNavMesh(NavMesh *navMesh, TileCache *tileCa
             tileHeader.tileRef = m_tileCache->getTileRef(tile);
             tileHeader.dataSize = tile->dataSize;
 
-            bits = (unsigned char *)realloc(bits, bitsSize + sizeof(tileHeader));
-            memcpy(&bits[bitsSize], &tileHeader, sizeof(tileHeader));
-            bitsSize += sizeof(tileHeader);
-
-            bits = (unsigned char *)realloc(bits, bitsSize + tile->dataSize);
-            memcpy(&bits[bitsSize], tile->data, tile->dataSize);
-            bitsSize += tile->dataSize;
+            writer.write(&tileHeader, sizeof(tileHeader));
+            writer.write(tile->data, tile->dataSize);
         }
     }
     else
@@ -253,13 +598,9 @@ NavMeshExport NavMeshExporter::exportNavMesh(NavMesh *navMesh, TileCache *tileCa
             recastHeader.numTiles++;
         }
         memcpy(&header.params, m_navMesh->getParams(), sizeof(dtNavMeshParams));
-        bits = (unsigned char *)realloc(bits, bitsSize + sizeof(RecastHeader));
-        memcpy(&bits[bitsSize], &recastHeader, sizeof(RecastHeader));
-        bitsSize += sizeof(RecastHeader);
 
-        bits = (unsigned char *)realloc(bits, bitsSize + sizeof(NavMeshSetHeader));
-        memcpy(&bits[bitsSize], &header, sizeof(NavMeshSetHeader));
-        bitsSize += sizeof(NavMeshSetHeader);
+        writer.write(&recastHeader, sizeof(RecastHeader));
+        writer.write(&header, sizeof(NavMeshSetHeader));
 
         // Store tiles.
         for (int i = 0; i < m_navMesh->getMaxTiles(); ++i)
@@ -272,14 +613,213 @@ NavMeshExport NavMeshExporter::exportNavMesh(NavMesh *navMesh, TileCache *tileCa
             tileHeader.tileRef = m_navMesh->getTileRef(tile);
             tileHeader.dataSize = tile->dataSize;
 
-            bits = (unsigned char *)realloc(bits, bitsSize + sizeof(tileHeader));
-            memcpy(&bits[bitsSize], &tileHeader, sizeof(tileHeader));
-            bitsSize += sizeof(tileHeader);
+            writer.write(&tileHeader, sizeof(tileHeader));
+            writer.write(tile->data, tile->dataSize);
+        }
+    }
+}
+
+NavMeshExport NavMeshExporter::exportNavMesh(NavMesh *navMesh, TileCache *tileCache) const
+{
+    if (!navMesh->m_navMesh)
+    {
+        return {0, 0};
+    }
+
+    const dtNavMesh *m_navMesh = navMesh->m_navMesh;
+    const dtTileCache *m_tileCache = tileCache ? tileCache->m_tileCache : nullptr;
+
+    // Walk the tiles once to get the exact size, then allocate once and fill.
+    NavMeshExportSizeWriter sizeWriter;
+    writeNavMeshExport(m_navMesh, m_tileCache, sizeWriter);
+
+    unsigned char *bits = (unsigned char *)malloc(sizeWriter.size);
+    if (!bits)
+    {
+        return {0, 0};
+    }
+
+    NavMeshExportBufferWriter bufferWriter(bits);
+    writeNavMeshExport(m_navMesh, m_tileCache, bufferWriter);
+
+    NavMeshExport navMeshExport;
+    navMeshExport.dataPointer = bits;
+    navMeshExport.size = int(sizeWriter.size);
+
+    return navMeshExport;
+}
+
+int NavMeshExporter::exportNavMeshToSink(NavMesh *navMesh, TileCache *tileCache, NavMeshExportSinkJsImpl &sink, int chunkSize) const
+{
+    if (!navMesh->m_navMesh || chunkSize <= 0)
+    {
+        return 0;
+    }
+
+    const dtNavMesh *m_navMesh = navMesh->m_navMesh;
+    const dtTileCache *m_tileCache = tileCache ? tileCache->m_tileCache : nullptr;
+
+    NavMeshExportSinkWriter sinkWriter(sink, size_t(chunkSize));
+    writeNavMeshExport(m_navMesh, m_tileCache, sinkWriter);
 
-            bits = (unsigned char *)realloc(bits, bitsSize + tile->dataSize);
-            memcpy(&bits[bitsSize], tile->data, tile->dataSize);
-            bitsSize += tile->dataSize;
+    return int(sinkWriter.size);
+}
+
+NavMeshExport NavMeshExporter::exportNavMeshCompressed(NavMesh *navMesh, dtTileCacheCompressor *compressor) const
+{
+    if (!navMesh->m_navMesh)
+    {
+        return {0, 0};
+    }
+
+    RecastFastLZCompressor fastLZCompressor;
+    const int compression = compressor ? NAVMESHSET_COMPRESSION_CUSTOM : NAVMESHSET_COMPRESSION_FASTLZ;
+    if (!compressor)
+    {
+        compressor = &fastLZCompressor;
+    }
+
+    const dtNavMesh *m_navMesh = navMesh->m_navMesh;
+
+    RecastHeader recastHeader;
+    NavMeshCompressedSetHeader header;
+    recastHeader.magic = NAVMESHSET_COMPRESSED_MAGIC;
+    recastHeader.version = NAVMESHSET_COMPRESSED_VERSION;
+    recastHeader.numTiles = 0;
+    memcpy(&header.params, m_navMesh->getParams(), sizeof(dtNavMeshParams));
+    header.compression = compression;
+
+    // Allocate once for the worst case, then shrink to the compressed size.
+    size_t maxSize = sizeof(RecastHeader) + sizeof(NavMeshCompressedSetHeader);
+    for (int i = 0; i < m_navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile *tile = m_navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize)
+            continue;
+        recastHeader.numTiles++;
+        maxSize += sizeof(NavMeshCompressedTileHeader) + compressor->maxCompressedSize(tile->dataSize);
+    }
+
+    unsigned char *bits = (unsigned char *)malloc(maxSize);
+    if (!bits)
+    {
+        return {0, 0};
+    }
+
+    size_t bitsSize = 0;
+    memcpy(&bits[bitsSize], &recastHeader, sizeof(RecastHeader));
+    bitsSize += sizeof(RecastHeader);
+    memcpy(&bits[bitsSize], &header, sizeof(NavMeshCompressedSetHeader));
+    bitsSize += sizeof(NavMeshCompressedSetHeader);
+
+    for (int i = 0; i < m_navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile *tile = m_navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize)
+            continue;
+
+        NavMeshCompressedTileHeader tileHeader;
+        tileHeader.tileRef = m_navMesh->getTileRef(tile);
+        tileHeader.dataSize = tile->dataSize;
+        tileHeader.compressedSize = 0;
+
+        const size_t tileHeaderOffset = bitsSize;
+        bitsSize += sizeof(NavMeshCompressedTileHeader);
+
+        const int maxCompressedSize = compressor->maxCompressedSize(tile->dataSize);
+        dtStatus status = compressor->compress(tile->data, tile->dataSize, &bits[bitsSize], maxCompressedSize, &tileHeader.compressedSize);
+        if (dtStatusFailed(status) || tileHeader.compressedSize <= 0 || tileHeader.compressedSize > maxCompressedSize)
+        {
+            free(bits);
+            return {0, 0};
         }
+        bitsSize += tileHeader.compressedSize;
+
+        memcpy(&bits[tileHeaderOffset], &tileHeader, sizeof(NavMeshCompressedTileHeader));
+    }
+
+    unsigned char *shrunk = (unsigned char *)realloc(bits, bitsSize);
+    if (shrunk)
+    {
+        bits = shrunk;
+    }
+
+    NavMeshExport navMeshExport;
+    navMeshExport.dataPointer = bits;
+    navMeshExport.size = int(bitsSize);
+
+    return navMeshExport;
+}
+
+NavMeshExport NavMeshExporter::exportNavMeshIndexed(NavMesh *navMesh) const
+{
+    if (!navMesh->m_navMesh)
+    {
+        return {0, 0};
+    }
+
+    const dtNavMesh *m_navMesh = navMesh->m_navMesh;
+
+    // Build the tile directory, sorted by tile coordinates for binary search on load.
+    std::vector<NavMeshIndexTileEntry> directory;
+    std::vector<const dtMeshTile *> tiles;
+    for (int i = 0; i < m_navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile *tile = m_navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize)
+            continue;
+
+        NavMeshIndexTileEntry entry;
+        entry.tileX = tile->header->x;
+        entry.tileY = tile->header->y;
+        entry.layer = tile->header->layer;
+        entry.tileRef = m_navMesh->getTileRef(tile);
+        entry.offset = 0;
+        entry.dataSize = tile->dataSize;
+        entry.checksum = navMeshIndexChecksum(tile->data, tile->dataSize);
+        directory.push_back(entry);
+    }
+
+    std::sort(directory.begin(), directory.end(), navMeshIndexTileLess);
+
+    size_t bitsSize = sizeof(RecastHeader) + sizeof(NavMeshIndexHeader) + directory.size() * sizeof(NavMeshIndexTileEntry);
+    for (NavMeshIndexTileEntry &entry : directory)
+    {
+        bitsSize = navMeshIndexAlign(bitsSize);
+        entry.offset = (unsigned int)bitsSize;
+        bitsSize += entry.dataSize;
+    }
+
+    unsigned char *bits = (unsigned char *)malloc(bitsSize);
+    if (!bits)
+    {
+        return {0, 0};
+    }
+    memset(bits, 0, bitsSize);
+
+    RecastHeader recastHeader;
+    recastHeader.magic = NAVMESHINDEX_MAGIC;
+    recastHeader.version = NAVMESHINDEX_VERSION;
+    recastHeader.numTiles = int(directory.size());
+
+    NavMeshIndexHeader header;
+    memcpy(&header.params, m_navMesh->getParams(), sizeof(dtNavMeshParams));
+    header.payloadAlignment = NAVMESHINDEX_PAYLOAD_ALIGNMENT;
+
+    size_t offset = 0;
+    memcpy(&bits[offset], &recastHeader, sizeof(RecastHeader));
+    offset += sizeof(RecastHeader);
+    memcpy(&bits[offset], &header, sizeof(NavMeshIndexHeader));
+    offset += sizeof(NavMeshIndexHeader);
+    if (!directory.empty())
+    {
+        memcpy(&bits[offset], directory.data(), directory.size() * sizeof(NavMeshIndexTileEntry));
+    }
+
+    for (const NavMeshIndexTileEntry &entry : directory)
+    {
+        const dtMeshTile *tile = m_navMesh->getTileByRef(entry.tileRef);
+        memcpy(&bits[entry.offset], tile->data, entry.dataSize);
     }
 
     NavMeshExport navMeshExport;
@@ -293,3 +833,491 @@ void NavMeshExporter::freeNavMeshExport(NavMeshExport *navMeshExport)
 {
     free(navMeshExport->dataPointer);
 }
+
+int NavMeshIndex::getDirectorySize(NavMeshExport *navMeshExport) const
+{
+    const unsigned char *bits = (const unsigned char *)navMeshExport->dataPointer;
+    if (!bits || navMeshExport->size < int(sizeof(RecastHeader) + sizeof(NavMeshIndexHeader)))
+    {
+        return 0;
+    }
+
+    RecastHeader recastHeader;
+    memcpy(&recastHeader, bits, sizeof(RecastHeader));
+    if (recastHeader.magic != NAVMESHINDEX_MAGIC || recastHeader.version != NAVMESHINDEX_VERSION || recastHeader.numTiles < 0)
+    {
+        return 0;
+    }
+
+    // size_t is 32 bits on wasm32, so a corrupt tile count could wrap to a small directory size
+    const size_t headerSize = sizeof(RecastHeader) + sizeof(NavMeshIndexHeader);
+    if (size_t(recastHeader.numTiles) > (size_t(INT_MAX) - headerSize) / sizeof(NavMeshIndexTileEntry))
+    {
+        return 0;
+    }
+
+    return int(headerSize + size_t(recastHeader.numTiles) * sizeof(NavMeshIndexTileEntry));
+}
+
+bool NavMeshIndex::init(NavMeshExport *navMeshExport)
+{
+    const int directorySize = getDirectorySize(navMeshExport);
+    if (!directorySize || navMeshExport->size < directorySize)
+    {
+        return false;
+    }
+
+    const unsigned char *bits = (const unsigned char *)navMeshExport->dataPointer;
+
+    RecastHeader recastHeader;
+    memcpy(&recastHeader, bits, sizeof(RecastHeader));
+    bits += sizeof(RecastHeader);
+
+    NavMeshIndexHeader header;
+    memcpy(&header, bits, sizeof(NavMeshIndexHeader));
+    bits += sizeof(NavMeshIndexHeader);
+
+    // Payloads may be omitted, so offsets are checked when tiles are loaded from the export
+    const NavMeshIndexTileEntry *tiles = (const NavMeshIndexTileEntry *)bits;
+    for (int i = 0; i < recastHeader.numTiles; ++i)
+    {
+        if (tiles[i].dataSize < 0)
+        {
+            return false;
+        }
+    }
+
+    m_data = (const unsigned char *)navMeshExport->dataPointer;
+    m_size = navMeshExport->size;
+    m_params = header.params;
+    m_tiles = tiles;
+    m_tileCount = recastHeader.numTiles;
+
+    return true;
+}
+
+NavMeshIndexTileEntry NavMeshIndex::getTile(int i) const
+{
+    if (i < 0 || i >= m_tileCount)
+    {
+        NavMeshIndexTileEntry empty;
+        memset(&empty, 0, sizeof(NavMeshIndexTileEntry));
+        return empty;
+    }
+
+    return m_tiles[i];
+}
+
+int NavMeshIndex::findTile(int tileX, int tileY, int layer) const
+{
+    NavMeshIndexTileEntry key;
+    key.tileX = tileX;
+    key.tileY = tileY;
+    key.layer = layer;
+
+    const NavMeshIndexTileEntry *end = m_tiles + m_tileCount;
+    const NavMeshIndexTileEntry *it = std::lower_bound(m_tiles, end, key, navMeshIndexTileLess);
+    if (it == end || it->tileX != tileX || it->tileY != tileY || it->layer != layer)
+    {
+        return -1;
+    }
+
+    return int(it - m_tiles);
+}
+
+int NavMeshIndex::findFirstTileAt(int tileX, int tileY) const
+{
+    NavMeshIndexTileEntry key;
+    key.tileX = tileX;
+    key.tileY = tileY;
+    key.layer = INT_MIN;
+
+    const NavMeshIndexTileEntry *end = m_tiles + m_tileCount;
+    const NavMeshIndexTileEntry *it = std::lower_bound(m_tiles, end, key, navMeshIndexTileLess);
+    if (it == end || it->tileX != tileX || it->tileY != tileY)
+    {
+        return -1;
+    }
+
+    return int(it - m_tiles);
+}
+
+bool NavMeshIndex::initNavMesh(NavMesh *navMesh) const
+{
+    return navMesh->initTiled(&m_params);
+}
+
+dtStatus NavMeshIndex::loadTile(NavMesh *navMesh, int i) const
+{
+    if (i < 0 || i >= m_tileCount)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const NavMeshIndexTileEntry &entry = m_tiles[i];
+    if (entry.dataSize < 0 || entry.offset > (unsigned int)m_size || (unsigned int)entry.dataSize > (unsigned int)m_size - entry.offset)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    UnsignedCharArray view;
+    view.view((unsigned char *)m_data + entry.offset);
+    view.size = entry.dataSize;
+
+    return loadTileData(navMesh, i, &view);
+}
+
+dtStatus NavMeshIndex::loadTileData(NavMesh *navMesh, int i, UnsignedCharArray *data) const
+{
+    if (i < 0 || i >= m_tileCount)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const NavMeshIndexTileEntry &entry = m_tiles[i];
+    if (data->size != entry.dataSize || navMeshIndexChecksum(data->data, data->size) != entry.checksum)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    unsigned char *tileData = (unsigned char *)dtAlloc(entry.dataSize, DT_ALLOC_PERM);
+    if (!tileData)
+    {
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+    memcpy(tileData, data->data, entry.dataSize);
+
+    dtStatus status = navMesh->m_navMesh->addTile(tileData, entry.dataSize, DT_TILE_FREE_DATA, entry.tileRef, nullptr);
+    if (dtStatusFailed(status))
+    {
+        dtFree(tileData);
+    }
+    else
+    {
+        navMesh->markTileChanged(entry.tileRef);
+    }
+
+    return status;
+}
+
+void NavMeshIndex::destroy()
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_tiles = nullptr;
+    m_tileCount = 0;
+}
+
+template <typename Writer>
+static void writeCrowdSnapshot(dtCrowd *crowd, const CrowdUpdater *updater, Writer &writer)
+{
+    const int maxAgents = crowd->getAgentCount();
+
+    RecastHeader recastHeader;
+    recastHeader.magic = CROWDSNAPSHOT_MAGIC;
+    recastHeader.version = CROWDSNAPSHOT_VERSION;
+    recastHeader.numTiles = 0;
+    for (int i = 0; i < maxAgents; ++i)
+    {
+        if (crowd->getAgent(i)->active)
+            recastHeader.numTiles++;
+    }
+
+    CrowdSnapshotHeader header;
+    header.maxAgents = maxAgents;
+    header.flags = updater ? CROWDSNAPSHOT_HAS_UPDATER : 0;
+    header.tick = updater ? updater->getTick() : 0;
+    header.agentSize = int(sizeof(CrowdSnapshotAgent));
+    header.boundarySize = int(sizeof(dtLocalBoundary));
+
+    writer.write(&recastHeader, sizeof(RecastHeader));
+    writer.write(&header, sizeof(CrowdSnapshotHeader));
+
+    for (int i = 0; i < DT_CROWD_MAX_QUERY_FILTER_TYPE; ++i)
+    {
+        const dtQueryFilter *filter = crowd->getFilter(i);
+
+        CrowdSnapshotFilter filterHeader;
+        for (int area = 0; area < DT_MAX_AREAS; ++area)
+        {
+            filterHeader.areaCost[area] = filter->getAreaCost(area);
+        }
+        filterHeader.includeFlags = filter->getIncludeFlags();
+        filterHeader.excludeFlags = filter->getExcludeFlags();
+
+        writer.write(&filterHeader, sizeof(CrowdSnapshotFilter));
+    }
+
+    for (int i = 0; i < DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS; ++i)
+    {
+        writer.write(crowd->getObstacleAvoidanceParams(i), sizeof(dtObstacleAvoidanceParams));
+    }
+
+    for (int i = 0; i < maxAgents; ++i)
+    {
+        const dtCrowdAgent *ag = crowd->getAgent(i);
+        if (!ag->active)
+            continue;
+
+        // Zeroed so padding bytes are deterministic
+        CrowdSnapshotAgent agent;
+        memset(&agent, 0, sizeof(CrowdSnapshotAgent));
+
+        agent.idx = i;
+        agent.state = ag->state;
+        agent.partial = ag->partial;
+        agent.targetState = ag->targetState;
+        agent.targetReplan = ag->targetReplan;
+        agent.params = ag->params;
+        agent.params.userData = nullptr;
+        agent.topologyOptTime = ag->topologyOptTime;
+        memcpy(agent.neis, ag->neis, sizeof(agent.neis));
+        agent.nneis = ag->nneis;
+        agent.desiredSpeed = ag->desiredSpeed;
+        dtVcopy(agent.npos, ag->npos);
+        dtVcopy(agent.disp, ag->disp);
+        dtVcopy(agent.dvel, ag->dvel);
+        dtVcopy(agent.nvel, ag->nvel);
+        dtVcopy(agent.vel, ag->vel);
+        memcpy(agent.cornerVerts, ag->cornerVerts, sizeof(agent.cornerVerts));
+        memcpy(agent.cornerFlags, ag->cornerFlags, sizeof(agent.cornerFlags));
+        memcpy(agent.cornerPolys, ag->cornerPolys, sizeof(agent.cornerPolys));
+        agent.ncorners = ag->ncorners;
+        agent.targetRef = ag->targetRef;
+        dtVcopy(agent.targetPos, ag->targetPos);
+        agent.targetReplanTime = ag->targetReplanTime;
+        dtVcopy(agent.corridorPos, ag->corridor.getPos());
+        dtVcopy(agent.corridorTarget, ag->corridor.getTarget());
+        agent.pathCount = ag->corridor.getPathCount();
+
+        if (updater)
+        {
+            agent.lodTier = updater->getAgentLodTier(i);
+            agent.animation = *updater->getAgentAnimation(i);
+        }
+
+        writer.write(&agent, sizeof(CrowdSnapshotAgent));
+        writer.write(ag->corridor.getPath(), sizeof(dtPolyRef) * agent.pathCount);
+        writer.write(&ag->boundary, sizeof(dtLocalBoundary));
+    }
+}
+
+NavMeshExport NavMeshExporter::exportCrowd(dtCrowd *crowd, CrowdUpdater *updater) const
+{
+    if (!crowd)
+    {
+        return {0, 0};
+    }
+
+    NavMeshExportSizeWriter sizeWriter;
+    writeCrowdSnapshot(crowd, updater, sizeWriter);
+
+    unsigned char *bits = (unsigned char *)malloc(sizeWriter.size);
+    if (!bits)
+    {
+        return {0, 0};
+    }
+
+    NavMeshExportBufferWriter bufferWriter(bits);
+    writeCrowdSnapshot(crowd, updater, bufferWriter);
+
+    NavMeshExport crowdExport;
+    crowdExport.dataPointer = bits;
+    crowdExport.size = int(sizeWriter.size);
+
+    return crowdExport;
+}
+
+bool NavMeshImporter::importCrowd(NavMeshExport *crowdExport, dtCrowd *crowd, CrowdUpdater *updater)
+{
+    const unsigned char *bits = (const unsigned char *)crowdExport->dataPointer;
+    const size_t size = size_t(crowdExport->size);
+    if (!bits || !crowd)
+    {
+        return false;
+    }
+
+    size_t offset = sizeof(RecastHeader) + sizeof(CrowdSnapshotHeader);
+    if (size < offset)
+    {
+        return false;
+    }
+
+    RecastHeader recastHeader;
+    CrowdSnapshotHeader header;
+    memcpy(&recastHeader, bits, sizeof(RecastHeader));
+    memcpy(&header, bits + sizeof(RecastHeader), sizeof(CrowdSnapshotHeader));
+
+    if (recastHeader.magic != CROWDSNAPSHOT_MAGIC || recastHeader.version != CROWDSNAPSHOT_VERSION)
+    {
+        return false;
+    }
+
+    const int maxAgents = crowd->getAgentCount();
+    if (header.maxAgents != maxAgents || recastHeader.numTiles < 0 || recastHeader.numTiles > maxAgents ||
+        header.agentSize != int(sizeof(CrowdSnapshotAgent)) || header.boundarySize != int(sizeof(dtLocalBoundary)))
+    {
+        return false;
+    }
+
+    const size_t filtersOffset = offset;
+    offset += sizeof(CrowdSnapshotFilter) * DT_CROWD_MAX_QUERY_FILTER_TYPE;
+
+    const size_t obstacleAvoidanceOffset = offset;
+    offset += sizeof(dtObstacleAvoidanceParams) * DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS;
+
+    // Validate every agent before changing the crowd. Agents are recorded by slot, 0 marks slots without an agent,
+    // as agent data always follows the headers.
+    std::vector<size_t> agentOffsets(maxAgents, 0);
+    int lastIdx = -1;
+    for (int i = 0; i < recastHeader.numTiles; ++i)
+    {
+        if (size < offset + sizeof(CrowdSnapshotAgent))
+            return false;
+
+        CrowdSnapshotAgent agent;
+        memcpy(&agent, bits + offset, sizeof(CrowdSnapshotAgent));
+
+        if (agent.idx < 0 || agent.idx >= maxAgents || agentOffsets[agent.idx] != 0 || agent.pathCount < 1 ||
+            agent.pathCount > CROWDSNAPSHOT_MAX_PATH || agent.lodTier < 0 || agent.lodTier >= CROWD_MAX_LOD_TIERS ||
+            agent.params.queryFilterType >= DT_CROWD_MAX_QUERY_FILTER_TYPE ||
+            agent.params.obstacleAvoidanceType >= DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS)
+            return false;
+
+        agentOffsets[agent.idx] = offset;
+        if (agent.idx > lastIdx)
+            lastIdx = agent.idx;
+
+        offset += sizeof(CrowdSnapshotAgent) + sizeof(dtPolyRef) * agent.pathCount + sizeof(dtLocalBoundary);
+        if (size < offset)
+            return false;
+    }
+
+    for (int i = 0; i < DT_CROWD_MAX_QUERY_FILTER_TYPE; ++i)
+    {
+        CrowdSnapshotFilter filterHeader;
+        memcpy(&filterHeader, bits + filtersOffset + sizeof(CrowdSnapshotFilter) * i, sizeof(CrowdSnapshotFilter));
+
+        dtQueryFilter *filter = crowd->getEditableFilter(i);
+        for (int area = 0; area < DT_MAX_AREAS; ++area)
+        {
+            filter->setAreaCost(area, filterHeader.areaCost[area]);
+        }
+        filter->setIncludeFlags(filterHeader.includeFlags);
+        filter->setExcludeFlags(filterHeader.excludeFlags);
+    }
+
+    for (int i = 0; i < DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS; ++i)
+    {
+        dtObstacleAvoidanceParams params;
+        memcpy(&params, bits + obstacleAvoidanceOffset + sizeof(dtObstacleAvoidanceParams) * i, sizeof(dtObstacleAvoidanceParams));
+        crowd->setObstacleAvoidanceParams(i, &params);
+    }
+
+    // Agents that are not in the snapshot are removed
+    std::vector<void *> userData(maxAgents);
+    for (int i = 0; i < maxAgents; ++i)
+    {
+        dtCrowdAgent *ag = crowd->getEditableAgent(i);
+        userData[i] = ag->params.userData;
+
+        if (ag->active)
+            crowd->removeAgent(i);
+    }
+
+    const bool hasUpdater = (header.flags & CROWDSNAPSHOT_HAS_UPDATER) != 0;
+
+    // Agents are added through dtCrowd::addAgent, which also clears the crowd's own off-mesh animation of the slot.
+    // addAgent takes the first free slot, so slots are filled in order, with placeholders between snapshot agents.
+    dtCrowdAgentParams placeholderParams;
+    memset(&placeholderParams, 0, sizeof(dtCrowdAgentParams));
+    const float placeholderPos[3] = {0, 0, 0};
+
+    std::vector<int> placeholders;
+    for (int idx = 0; idx <= lastIdx; ++idx)
+    {
+        if (agentOffsets[idx] == 0)
+        {
+            crowd->addAgent(placeholderPos, &placeholderParams);
+            placeholders.push_back(idx);
+            continue;
+        }
+
+        offset = agentOffsets[idx];
+
+        CrowdSnapshotAgent agent;
+        memcpy(&agent, bits + offset, sizeof(CrowdSnapshotAgent));
+        offset += sizeof(CrowdSnapshotAgent);
+
+        const dtPolyRef *path = (const dtPolyRef *)(bits + offset);
+        offset += sizeof(dtPolyRef) * agent.pathCount;
+
+        agent.params.userData = userData[agent.idx];
+        crowd->addAgent(agent.npos, &agent.params);
+
+        dtCrowdAgent *ag = crowd->getEditableAgent(agent.idx);
+
+        ag->corridor.reset(path[0], agent.corridorPos);
+        ag->corridor.setCorridor(agent.corridorTarget, path, agent.pathCount);
+
+        // dtLocalBoundary holds fixed size arrays, and is restored byte for byte
+        memcpy(static_cast<void *>(&ag->boundary), bits + offset, sizeof(dtLocalBoundary));
+        offset += sizeof(dtLocalBoundary);
+
+        ag->state = agent.state;
+        ag->partial = agent.partial != 0;
+        ag->topologyOptTime = agent.topologyOptTime;
+        memcpy(ag->neis, agent.neis, sizeof(agent.neis));
+        ag->nneis = agent.nneis;
+        ag->desiredSpeed = agent.desiredSpeed;
+        dtVcopy(ag->npos, agent.npos);
+        dtVcopy(ag->disp, agent.disp);
+        dtVcopy(ag->dvel, agent.dvel);
+        dtVcopy(ag->nvel, agent.nvel);
+        dtVcopy(ag->vel, agent.vel);
+        memcpy(ag->cornerVerts, agent.cornerVerts, sizeof(agent.cornerVerts));
+        memcpy(ag->cornerFlags, agent.cornerFlags, sizeof(agent.cornerFlags));
+        memcpy(ag->cornerPolys, agent.cornerPolys, sizeof(agent.cornerPolys));
+        ag->ncorners = agent.ncorners;
+
+        ag->targetState = agent.targetState;
+        ag->targetRef = agent.targetRef;
+        dtVcopy(ag->targetPos, agent.targetPos);
+        ag->targetReplan = agent.targetReplan != 0;
+        ag->targetReplanTime = agent.targetReplanTime;
+        ag->targetPathqRef = DT_PATHQ_INVALID;
+
+        // Path queue requests are not part of the snapshot, so pending requests are queued again
+        if (ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_PATH)
+            ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE;
+
+        dtCrowdAgentAnimation animation = agent.animation;
+        if (!hasUpdater || !updater)
+            animation.active = false;
+
+        // Without its animation, an agent on an off-mesh connection finishes it. The corridor starts at its end.
+        if (ag->state == DT_CROWDAGENT_STATE_OFFMESH && !animation.active)
+        {
+            ag->state = DT_CROWDAGENT_STATE_WALKING;
+            dtVcopy(ag->npos, agent.corridorPos);
+        }
+
+        if (updater)
+        {
+            updater->setAgentAnimation(agent.idx, &animation);
+            updater->setAgentLodTier(agent.idx, hasUpdater ? agent.lodTier : 0);
+        }
+    }
+
+    for (int idx : placeholders)
+    {
+        crowd->removeAgent(idx);
+    }
+
+    if (updater && hasUpdater)
+    {
+        updater->setTick(header.tick);
+    }
+
+    return true;
+}
@@ -6,9 +6,11 @@
 #include "../recastnavigation/Detour/Include/DetourCommon.h"
 #include "../recastnavigation/Detour/Include/DetourNavMeshBuilder.h"
 #include "../recastnavigation/DetourTileCache/Include/DetourTileCache.h"
+#include "../recastnavigation/DetourCrowd/Include/DetourCrowd.h"
 #include "./Refs.h"
 #include "./NavMesh.h"
 #include "./TileCache.h"
+#include "./CrowdUpdater.h"
 
 struct NavMeshExport
 {
@@ -16,15 +18,98 @@ struct NavMeshExport
     int size;
 };
 
+struct NavMeshExportSinkJsImpl
+{
+    NavMeshExportSinkJsImpl()
+    {
+    }
+
+    virtual ~NavMeshExportSinkJsImpl()
+    {
+    }
+
+    // data is only valid for the duration of the call
+    virtual void write(void *data, int size) = 0;
+};
+
 class NavMeshExporter
 {
 public:
     NavMeshExporter() {}
 
     NavMeshExport exportNavMesh(NavMesh *navMesh, TileCache *tileCache) const;
+
+    // Compresses each tile with the given codec, or with the bundled FastLZ codec if compressor is null.
+    // Exports compressed with a given codec are tagged as custom, and must be imported with the same codec.
+    NavMeshExport exportNavMeshCompressed(NavMesh *navMesh, dtTileCacheCompressor *compressor = nullptr) const;
+
+    NavMeshExport exportNavMeshIndexed(NavMesh *navMesh) const;
+    int exportNavMeshToSink(NavMesh *navMesh, TileCache *tileCache, NavMeshExportSinkJsImpl &sink, int chunkSize) const;
+
+    // Snapshots the query filters, obstacle avoidance params and active agents of a crowd, including corridors,
+    // targets and local boundaries. The updater is optional, and adds its off-mesh animations and level of detail.
+    NavMeshExport exportCrowd(dtCrowd *crowd, CrowdUpdater *updater = nullptr) const;
     void freeNavMeshExport(NavMeshExport *navMeshExport);
 };
 
+struct NavMeshIndexTileEntry
+{
+    int tileX;
+    int tileY;
+    int layer;
+    dtTileRef tileRef;
+    unsigned int offset;
+    int dataSize;
+    unsigned int checksum;
+};
+
+class NavMeshIndex
+{
+public:
+    NavMeshIndex() : m_data(nullptr), m_size(0), m_tiles(nullptr), m_tileCount(0) {}
+
+    // Returns the number of bytes needed to read the header and tile directory, given at least the
+    // fixed size header at the start of an indexed export. Returns 0 if the data is not an indexed export.
+    int getDirectorySize(NavMeshExport *navMeshExport) const;
+
+    // Reads the header and tile directory. The export data is referenced, not copied, and must outlive the index.
+    // Tile payloads may be omitted from the data if tiles are loaded with loadTileData.
+    bool init(NavMeshExport *navMeshExport);
+
+    const dtNavMeshParams *getParams() const
+    {
+        return &m_params;
+    }
+
+    int getTileCount() const
+    {
+        return m_tileCount;
+    }
+
+    // Returns a zeroed entry if i is out of range
+    NavMeshIndexTileEntry getTile(int i) const;
+
+    int findTile(int tileX, int tileY, int layer) const;
+
+    // Returns the index of the first directory entry at the tile coordinates, or -1. Entries for other layers follow it.
+    int findFirstTileAt(int tileX, int tileY) const;
+
+    bool initNavMesh(NavMesh *navMesh) const;
+
+    dtStatus loadTile(NavMesh *navMesh, int i) const;
+
+    dtStatus loadTileData(NavMesh *navMesh, int i, UnsignedCharArray *data) const;
+
+    void destroy();
+
+private:
+    const unsigned char *m_data;
+    int m_size;
+    dtNavMeshParams m_params;
+    const NavMeshIndexTileEntry *m_tiles;
+    int m_tileCount;
+};
+
 struct NavMeshImporterResult
 {
     bool success;
@@ -39,5 +124,15 @@ class NavMeshImporter
 public:
     NavMeshImporter() {}
 
-    NavMeshImporterResult importNavMesh(NavMeshExport *navMeshExport, TileCacheMeshProcessJsImpl &meshProcess);
+    // The compressor decompresses exports compressed with a custom codec, FastLZ exports use the bundled codec
+    NavMeshImporterResult importNavMesh(NavMeshExport *navMeshExport, TileCacheMeshProcessJsImpl &meshProcess, dtTileCacheCompressor *compressor = nullptr);
+
+    // Imports a navmesh set without copying tile data. Tiles point into the export buffer, which must
+    // be allocated with malloc. On success the returned NavMesh takes ownership of the buffer.
+    NavMeshImporterResult importNavMeshInPlace(NavMeshExport *navMeshExport);
+
+    // Restores a crowd snapshot into a crowd with the same max agents, on the same navmesh. Agents keep their indices
+    // and corridors, so no paths are recomputed. Agents waiting for a path are queued again. Returns false and leaves
+    // the crowd unchanged if the snapshot is invalid, or was written by a build with a different agent layout.
+    bool importCrowd(NavMeshExport *crowdExport, dtCrowd *crowd, CrowdUpdater *updater = nullptr);
 };
@@ -0,0 +1,287 @@
+#include "./NavMeshTileStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+static double streamerNowMs()
+{
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool NavMeshTileStreamer::init(NavMesh *navMesh, NavMeshIndex *index)
+{
+    if (!navMesh || !navMesh->m_navMesh || !index)
+    {
+        return false;
+    }
+
+    m_navMesh = navMesh;
+    m_index = index;
+    m_resident.assign(index->getTileCount(), 0);
+    m_failed.assign(index->getTileCount(), 0);
+    m_wanted.assign(index->getTileCount(), 0);
+    m_residentIndices.clear();
+    m_residentBytes = 0;
+    m_failedTiles = 0;
+
+    return true;
+}
+
+void NavMeshTileStreamer::setLoader(NavMeshTileLoaderJsImpl &loader)
+{
+    m_loader = &loader;
+}
+
+void NavMeshTileStreamer::clearLoader()
+{
+    m_loader = nullptr;
+}
+
+void NavMeshTileStreamer::addFocus(const float *position, float radius)
+{
+    Focus focus;
+    focus.x = position[0];
+    focus.z = position[2];
+    focus.radius = radius;
+    m_focus.push_back(focus);
+}
+
+void NavMeshTileStreamer::clearFocus()
+{
+    m_focus.clear();
+}
+
+void NavMeshTileStreamer::setEvictionMargin(float margin)
+{
+    m_evictionMargin = margin;
+}
+
+float NavMeshTileStreamer::tileDistance(const NavMeshIndexTileEntry &entry) const
+{
+    // Distance from the tile rect to the nearest focus circle on the xz plane, <= 0 when inside a focus radius
+    const dtNavMeshParams *params = m_index->getParams();
+    const float minx = params->orig[0] + entry.tileX * params->tileWidth;
+    const float minz = params->orig[2] + entry.tileY * params->tileHeight;
+    const float maxx = minx + params->tileWidth;
+    const float maxz = minz + params->tileHeight;
+
+    float best = INFINITY;
+    for (const Focus &focus : m_focus)
+    {
+        const float dx = focus.x < minx ? minx - focus.x : (focus.x > maxx ? focus.x - maxx : 0.0f);
+        const float dz = focus.z < minz ? minz - focus.z : (focus.z > maxz ? focus.z - maxz : 0.0f);
+        const float d = sqrtf(dx * dx + dz * dz) - focus.radius;
+        if (d < best)
+        {
+            best = d;
+        }
+    }
+
+    return best;
+}
+
+NavMeshTileStreamerUpdateResult NavMeshTileStreamer::update(float maxTimeMs, int maxBytes)
+{
+    NavMeshTileStreamerUpdateResult result;
+    result.loaded = 0;
+    result.evicted = 0;
+    result.bytesLoaded = 0;
+    result.pending = 0;
+    result.failed = 0;
+
+    if (!m_navMesh || !m_index)
+    {
+        result.residentTiles = getResidentTileCount();
+        result.residentBytes = m_residentBytes;
+        return result;
+    }
+
+    const double start = streamerNowMs();
+    const dtNavMeshParams *params = m_index->getParams();
+    const int tileCount = m_index->getTileCount();
+
+    // Evict distant tiles first to make room.
+    for (size_t r = 0; r < m_residentIndices.size();)
+    {
+        const int i = m_residentIndices[r];
+        const NavMeshIndexTileEntry entry = m_index->getTile(i);
+        if (tileDistance(entry) <= m_evictionMargin)
+        {
+            ++r;
+            continue;
+        }
+
+        if (maxTimeMs > 0 && result.evicted > 0 && streamerNowMs() - start >= maxTimeMs)
+            break;
+
+        m_navMesh->m_navMesh->removeTile(entry.tileRef, nullptr, nullptr);
+        m_navMesh->markTileChanged(entry.tileRef);
+        m_resident[i] = 0;
+        m_residentBytes -= entry.dataSize;
+        result.evicted++;
+
+        m_residentIndices[r] = m_residentIndices.back();
+        m_residentIndices.pop_back();
+    }
+
+    // Gather missing tiles overlapping a focus radius.
+    m_candidates.clear();
+    for (const Focus &focus : m_focus)
+    {
+        const int minTx = (int)floorf((focus.x - focus.radius - params->orig[0]) / params->tileWidth);
+        const int maxTx = (int)floorf((focus.x + focus.radius - params->orig[0]) / params->tileWidth);
+        const int minTy = (int)floorf((focus.z - focus.radius - params->orig[2]) / params->tileHeight);
+        const int maxTy = (int)floorf((focus.z + focus.radius - params->orig[2]) / params->tileHeight);
+
+        for (int ty = minTy; ty <= maxTy; ++ty)
+        {
+            for (int tx = minTx; tx <= maxTx; ++tx)
+            {
+                const int first = m_index->findFirstTileAt(tx, ty);
+                if (first == -1)
+                    continue;
+
+                for (int i = first; i < tileCount; ++i)
+                {
+                    const NavMeshIndexTileEntry entry = m_index->getTile(i);
+                    if (entry.tileX != tx || entry.tileY != ty)
+                        break;
+
+                    if (m_resident[i] || m_failed[i] || m_wanted[i])
+                        continue;
+
+                    const float distance = tileDistance(entry);
+                    if (distance > 0)
+                        continue;
+
+                    m_wanted[i] = 1;
+
+                    Candidate candidate;
+                    candidate.tileIndex = i;
+                    candidate.distance = distance;
+                    m_candidates.push_back(candidate);
+                }
+            }
+        }
+    }
+
+    std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate &a, const Candidate &b)
+              { return a.distance < b.distance; });
+
+    // Load nearest first within the budget.
+    for (size_t c = 0; c < m_candidates.size(); ++c)
+    {
+        const bool attempted = result.loaded > 0;
+        if (attempted && maxBytes > 0 && result.bytesLoaded >= maxBytes)
+        {
+            result.pending += int(m_candidates.size() - c);
+            break;
+        }
+        if (attempted && maxTimeMs > 0 && streamerNowMs() - start >= maxTimeMs)
+        {
+            result.pending += int(m_candidates.size() - c);
+            break;
+        }
+
+        const int i = m_candidates[c].tileIndex;
+        const NavMeshIndexTileEntry entry = m_index->getTile(i);
+
+        dtStatus status;
+        if (m_loader)
+        {
+            if (!m_loader->load(i, int(entry.offset), entry.dataSize, &m_loadBuffer))
+            {
+                result.pending++;
+                continue;
+            }
+            status = m_index->loadTileData(m_navMesh, i, &m_loadBuffer);
+        }
+        else
+        {
+            status = m_index->loadTile(m_navMesh, i);
+        }
+
+        // Failed tiles would fail again, so they are not retried until reset
+        if (dtStatusFailed(status))
+        {
+            m_failed[i] = 1;
+            m_failedTiles++;
+            result.failed++;
+            continue;
+        }
+
+        m_resident[i] = 1;
+        m_residentIndices.push_back(i);
+        m_residentBytes += entry.dataSize;
+        result.loaded++;
+        result.bytesLoaded += entry.dataSize;
+    }
+
+    for (const Candidate &candidate : m_candidates)
+    {
+        m_wanted[candidate.tileIndex] = 0;
+    }
+
+    result.residentTiles = getResidentTileCount();
+    result.residentBytes = m_residentBytes;
+    return result;
+}
+
+bool NavMeshTileStreamer::isTileResident(int tileIndex) const
+{
+    return tileIndex >= 0 && tileIndex < int(m_resident.size()) && m_resident[tileIndex];
+}
+
+bool NavMeshTileStreamer::isTileFailed(int tileIndex) const
+{
+    return tileIndex >= 0 && tileIndex < int(m_failed.size()) && m_failed[tileIndex];
+}
+
+void NavMeshTileStreamer::resetFailedTiles(int tileIndex)
+{
+    if (tileIndex == -1)
+    {
+        std::fill(m_failed.begin(), m_failed.end(), 0);
+        m_failedTiles = 0;
+    }
+    else if (isTileFailed(tileIndex))
+    {
+        m_failed[tileIndex] = 0;
+        m_failedTiles--;
+    }
+}
+
+void NavMeshTileStreamer::unloadAll()
+{
+    if (!m_navMesh || !m_index)
+        return;
+
+    for (int i : m_residentIndices)
+    {
+        const NavMeshIndexTileEntry entry = m_index->getTile(i);
+        m_navMesh->m_navMesh->removeTile(entry.tileRef, nullptr, nullptr);
+        m_navMesh->markTileChanged(entry.tileRef);
+        m_resident[i] = 0;
+    }
+
+    m_residentIndices.clear();
+    m_residentBytes = 0;
+}
+
+void NavMeshTileStreamer::destroy()
+{
+    m_navMesh = nullptr;
+    m_index = nullptr;
+    m_loader = nullptr;
+    m_focus.clear();
+    m_resident.clear();
+    m_failed.clear();
+    m_candidates.clear();
+    m_wanted.clear();
+    m_loadBuffer.free();
+    m_residentIndices.clear();
+    m_residentBytes = 0;
+    m_failedTiles = 0;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include "../recastnavigation/Detour/Include/DetourStatus.h"
+#include "../recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "./Arrays.h"
+#include "./NavMesh.h"
+#include "./NavMeshSerdes.h"
+
+struct NavMeshTileLoaderJsImpl
+{
+    NavMeshTileLoaderJsImpl()
+    {
+    }
+
+    virtual ~NavMeshTileLoaderJsImpl()
+    {
+    }
+
+    // Copies the payload of the directory entry into data and returns true, or returns false if it is not available yet
+    virtual bool load(int tileIndex, int offset, int dataSize, UnsignedCharArray *data) = 0;
+};
+
+struct NavMeshTileStreamerUpdateResult
+{
+    int loaded;
+    int evicted;
+    int bytesLoaded;
+    int pending;
+
+    // Tiles that failed to load in the update, e.g. on a checksum mismatch. They are not retried until reset.
+    int failed;
+    int residentTiles;
+    int residentBytes;
+};
+
+class NavMeshTileStreamer
+{
+public:
+    NavMeshTileStreamer() : m_navMesh(nullptr), m_index(nullptr), m_loader(nullptr), m_evictionMargin(0), m_residentBytes(0), m_failedTiles(0) {}
+
+    // Tiles are read from the index's export data, or from the loader if one is set
+    bool init(NavMesh *navMesh, NavMeshIndex *index);
+
+    void setLoader(NavMeshTileLoaderJsImpl &loader);
+
+    void clearLoader();
+
+    void addFocus(const float *position, float radius);
+
+    void clearFocus();
+
+    // Resident tiles are only evicted once they are this far outside of every focus radius
+    void setEvictionMargin(float margin);
+
+    // Evicts distant tiles then loads missing tiles nearest first, stopping when either budget is used.
+    // A budget of 0 or less is unlimited. At least one tile is loaded per call if any are missing.
+    NavMeshTileStreamerUpdateResult update(float maxTimeMs, int maxBytes);
+
+    bool isTileResident(int tileIndex) const;
+
+    int getResidentTileCount() const
+    {
+        return int(m_residentIndices.size());
+    }
+
+    int getResidentBytes() const
+    {
+        return m_residentBytes;
+    }
+
+    bool isTileFailed(int tileIndex) const;
+
+    int getFailedTileCount() const
+    {
+        return m_failedTiles;
+    }
+
+    // Lets failed tiles be loaded again, or a single tile if tileIndex is not -1
+    void resetFailedTiles(int tileIndex);
+
+    // Removes all tiles added by the streamer from the navmesh
+    void unloadAll();
+
+    void destroy();
+
+private:
+    struct Focus
+    {
+        float x;
+        float z;
+        float radius;
+    };
+
+    struct Candidate
+    {
+        int tileIndex;
+        float distance;
+    };
+
+    float tileDistance(const NavMeshIndexTileEntry &entry) const;
+
+    NavMesh *m_navMesh;
+    NavMeshIndex *m_index;
+    NavMeshTileLoaderJsImpl *m_loader;
+    float m_evictionMargin;
+
+    std::vector<Focus> m_focus;
+    std::vector<unsigned char> m_resident;
+    std::vector<unsigned char> m_failed;
+    std::vector<Candidate> m_candidates;
+    std::vector<unsigned char> m_wanted;
+    UnsignedCharArray m_loadBuffer;
+
+    // Eviction only visits resident tiles, not the whole directory
+    std::vector<int> m_residentIndices;
+
+    int m_residentBytes;
+    int m_failedTiles;
+};
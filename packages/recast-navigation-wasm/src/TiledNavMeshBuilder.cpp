@@ -0,0 +1,772 @@
+#include "./TiledNavMeshBuilder.h"
+
+#include "../recastnavigation/Detour/Include/DetourCommon.h"
+#include "../recastnavigation/Recast/Include/RecastAlloc.h"
+#include "../recastnavigation/RecastDemo/Contrib/fastlz/fastlz.h"
+#include <algorithm>
+#include <math.h>
+#include <utility>
+
+// The chunky tri mesh is rebuilt once this many triangles are in the overflow list or stale in chunks
+static const int MIN_CHUNK_REBUILD_TRIANGLES = 2048;
+
+// Fields of a compact heightfield ready for erosion, followed by its cells, spans and areas when cached
+struct CompactHeightfieldHeader
+{
+    int width;
+    int height;
+    int spanCount;
+    int walkableHeight;
+    int walkableClimb;
+    int borderSize;
+    float bmin[3];
+    float bmax[3];
+    float cs;
+    float ch;
+};
+
+static void compressCompactHeightfield(const rcCompactHeightfield &chf, std::vector<unsigned char> &buffer, std::vector<unsigned char> &compressed, int *size)
+{
+    CompactHeightfieldHeader header;
+    header.width = chf.width;
+    header.height = chf.height;
+    header.spanCount = chf.spanCount;
+    header.walkableHeight = chf.walkableHeight;
+    header.walkableClimb = chf.walkableClimb;
+    header.borderSize = chf.borderSize;
+    rcVcopy(header.bmin, chf.bmin);
+    rcVcopy(header.bmax, chf.bmax);
+    header.cs = chf.cs;
+    header.ch = chf.ch;
+
+    const size_t cellsSize = sizeof(rcCompactCell) * chf.width * chf.height;
+    const size_t spansSize = sizeof(rcCompactSpan) * chf.spanCount;
+    const size_t areasSize = chf.spanCount;
+
+    buffer.resize(sizeof(header) + cellsSize + spansSize + areasSize);
+
+    unsigned char *out = buffer.data();
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    memcpy(out, chf.cells, cellsSize);
+    out += cellsSize;
+    memcpy(out, chf.spans, spansSize);
+    out += spansSize;
+    memcpy(out, chf.areas, areasSize);
+
+    // FastLZ needs 5% more than the input, and at least 66 bytes
+    const int bufferSize = int(buffer.size());
+    compressed.resize(bufferSize + bufferSize / 16 + 66);
+
+    const int compressedSize = fastlz_compress(buffer.data(), bufferSize, compressed.data());
+
+    compressed.resize(compressedSize);
+    compressed.shrink_to_fit();
+    *size = bufferSize;
+}
+
+static rcCompactHeightfield *decompressCompactHeightfield(const std::vector<unsigned char> &compressed, int size, std::vector<unsigned char> &buffer)
+{
+    buffer.resize(size);
+    if (fastlz_decompress(compressed.data(), int(compressed.size()), buffer.data(), size) != size)
+    {
+        return nullptr;
+    }
+
+    CompactHeightfieldHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+
+    const size_t cellsSize = sizeof(rcCompactCell) * header.width * header.height;
+    const size_t spansSize = sizeof(rcCompactSpan) * header.spanCount;
+    const size_t areasSize = header.spanCount;
+
+    rcCompactHeightfield *chf = rcAllocCompactHeightfield();
+    if (!chf)
+    {
+        return nullptr;
+    }
+
+    chf->width = header.width;
+    chf->height = header.height;
+    chf->spanCount = header.spanCount;
+    chf->walkableHeight = header.walkableHeight;
+    chf->walkableClimb = header.walkableClimb;
+    chf->borderSize = header.borderSize;
+    chf->maxDistance = 0;
+    chf->maxRegions = 0;
+    rcVcopy(chf->bmin, header.bmin);
+    rcVcopy(chf->bmax, header.bmax);
+    chf->cs = header.cs;
+    chf->ch = header.ch;
+
+    chf->cells = (rcCompactCell *)rcAlloc(dtMax(cellsSize, size_t(1)), RC_ALLOC_PERM);
+    chf->spans = (rcCompactSpan *)rcAlloc(dtMax(spansSize, size_t(1)), RC_ALLOC_PERM);
+    chf->areas = (unsigned char *)rcAlloc(dtMax(areasSize, size_t(1)), RC_ALLOC_PERM);
+
+    if (!chf->cells || !chf->spans || !chf->areas)
+    {
+        rcFreeCompactHeightfield(chf);
+        return nullptr;
+    }
+
+    const unsigned char *in = buffer.data() + sizeof(header);
+    memcpy(chf->cells, in, cellsSize);
+    in += cellsSize;
+    memcpy(chf->spans, in, spansSize);
+    in += spansSize;
+    memcpy(chf->areas, in, areasSize);
+
+    return chf;
+}
+
+bool TiledNavMeshBuilder::init(const FloatArray *positions, const IntArray *indices, int trisPerChunk, const rcConfig *config, const dtNavMeshCreateParams *createParams, NavMesh *navMesh, int threadCount)
+{
+    destroy();
+
+    if (trisPerChunk < 1 || !navMesh)
+    {
+        return false;
+    }
+
+    const int nverts = positions->size / 3;
+    const int ntris = indices->size / 3;
+
+    for (int i = 0; i < ntris * 3; ++i)
+    {
+        if (indices->data[i] < 0 || indices->data[i] >= nverts)
+            return false;
+    }
+
+    if (!TiledNavMeshGenerator::init(threadCount))
+    {
+        return false;
+    }
+
+    m_navMesh = navMesh;
+    m_config = *config;
+    m_createParams = *createParams;
+    m_trisPerChunk = trisPerChunk;
+
+    calcTileCount(m_config, &m_tileWidth, &m_tileHeight);
+    m_dirtyTiles.assign(m_tileWidth * m_tileHeight, TILE_CLEAN);
+    m_cache.resize(m_tileWidth * m_tileHeight);
+
+    m_verts.resize(size_t(ntris) * 9);
+    for (int i = 0; i < ntris * 3; ++i)
+    {
+        rcVcopy(&m_verts[size_t(i) * 3], &positions->data[indices->data[i] * 3]);
+    }
+
+    m_triangleStates.assign(ntris, TRIANGLE_CHUNKED);
+
+    if (!rebuildChunkyTriMesh())
+    {
+        destroy();
+        return false;
+    }
+
+    return true;
+}
+
+int TiledNavMeshBuilder::buildAllTiles()
+{
+    for (int i = 0; i < m_tileWidth * m_tileHeight; ++i)
+    {
+        if (m_dirtyTiles[i] == TILE_CLEAN)
+            m_dirtyTileIndices.push_back(i);
+
+        m_dirtyTiles[i] = TILE_GEOMETRY_DIRTY;
+    }
+
+    return rebuildDirtyTiles();
+}
+
+int TiledNavMeshBuilder::addTriangles(const FloatArray *positions, const IntArray *indices)
+{
+    const int nverts = positions->size / 3;
+    const int ntris = indices->size / 3;
+
+    for (int i = 0; i < ntris * 3; ++i)
+    {
+        if (indices->data[i] < 0 || indices->data[i] >= nverts)
+            return -1;
+    }
+
+    const int first = getTriangleCount();
+
+    m_verts.resize(size_t(first + ntris) * 9);
+    for (int i = 0; i < ntris * 3; ++i)
+    {
+        rcVcopy(&m_verts[(size_t(first) * 3 + i) * 3], &positions->data[indices->data[i] * 3]);
+    }
+
+    m_triangleStates.resize(first + ntris, TRIANGLE_OVERFLOW);
+    for (int i = 0; i < ntris; ++i)
+    {
+        m_overflow.push_back(first + i);
+    }
+
+    markTrianglesDirty(first, ntris);
+
+    return first;
+}
+
+bool TiledNavMeshBuilder::removeTriangles(int first, int count)
+{
+    if (first < 0 || count < 0 || first + count > getTriangleCount())
+    {
+        return false;
+    }
+
+    for (int i = first; i < first + count; ++i)
+    {
+        if (m_triangleStates[i] == TRIANGLE_REMOVED)
+            continue;
+
+        markTrianglesDirty(i, 1);
+
+        if (m_triangleStates[i] == TRIANGLE_CHUNKED)
+            m_staleChunkedTriangleCount++;
+
+        m_triangleStates[i] = TRIANGLE_REMOVED;
+    }
+
+    return true;
+}
+
+bool TiledNavMeshBuilder::updateTriangles(int first, const FloatArray *positions)
+{
+    const int count = positions->size / 9;
+
+    if (first < 0 || first + count > getTriangleCount())
+    {
+        return false;
+    }
+
+    for (int i = first; i < first + count; ++i)
+    {
+        if (m_triangleStates[i] == TRIANGLE_REMOVED)
+            return false;
+    }
+
+    // Tiles under the old and the new positions change
+    markTrianglesDirty(first, count);
+
+    memcpy(&m_verts[size_t(first) * 9], positions->data, sizeof(float) * count * 9);
+
+    markTrianglesDirty(first, count);
+
+    // Moved triangles may leave the bounds of their chunk, so they are looked up in the overflow list until the next
+    // chunky tri mesh rebuild
+    for (int i = first; i < first + count; ++i)
+    {
+        if (m_triangleStates[i] == TRIANGLE_CHUNKED)
+        {
+            m_triangleStates[i] = TRIANGLE_OVERFLOW;
+            m_overflow.push_back(i);
+            m_staleChunkedTriangleCount++;
+        }
+    }
+
+    return true;
+}
+
+void TiledNavMeshBuilder::markDirtyBounds(const float *bmin, const float *bmax)
+{
+    markTilesDirty(bmin, bmax, TILE_GEOMETRY_DIRTY);
+}
+
+void TiledNavMeshBuilder::markTilesDirty(const float *bmin, const float *bmax, int level)
+{
+    if (m_tileWidth == 0 || m_tileHeight == 0)
+        return;
+
+    // Tiles whose bounds expanded by the border size overlap the bounds
+    const float tcs = m_config.tileSize * m_config.cs;
+    const float border = m_config.borderSize * m_config.cs;
+
+    const int minTx = dtMax(int(ceilf((bmin[0] - m_config.bmin[0] - border) / tcs - 1)), 0);
+    const int minTy = dtMax(int(ceilf((bmin[2] - m_config.bmin[2] - border) / tcs - 1)), 0);
+    const int maxTx = dtMin(int(floorf((bmax[0] - m_config.bmin[0] + border) / tcs)), m_tileWidth - 1);
+    const int maxTy = dtMin(int(floorf((bmax[2] - m_config.bmin[2] + border) / tcs)), m_tileHeight - 1);
+
+    for (int ty = minTy; ty <= maxTy; ++ty)
+    {
+        for (int tx = minTx; tx <= maxTx; ++tx)
+        {
+            const int tileIndex = ty * m_tileWidth + tx;
+            if (m_dirtyTiles[tileIndex] >= level)
+                continue;
+
+            if (m_dirtyTiles[tileIndex] == TILE_CLEAN)
+                m_dirtyTileIndices.push_back(tileIndex);
+
+            m_dirtyTiles[tileIndex] = (unsigned char)level;
+        }
+    }
+}
+
+void TiledNavMeshBuilder::markTrianglesDirty(int first, int count)
+{
+    for (int i = first; i < first + count; ++i)
+    {
+        const float *v = &m_verts[size_t(i) * 9];
+
+        float bmin[3];
+        float bmax[3];
+        rcVcopy(bmin, v);
+        rcVcopy(bmax, v);
+        rcVmin(bmin, v + 3);
+        rcVmax(bmax, v + 3);
+        rcVmin(bmin, v + 6);
+        rcVmax(bmax, v + 6);
+
+        markTilesDirty(bmin, bmax, TILE_GEOMETRY_DIRTY);
+    }
+}
+
+int TiledNavMeshBuilder::rebuildDirtyTiles()
+{
+    if (!m_navMesh || m_dirtyTileIndices.empty())
+    {
+        return 0;
+    }
+
+    const int staleTriangleCount = int(m_overflow.size()) + m_staleChunkedTriangleCount;
+    if (staleTriangleCount > dtMax(MIN_CHUNK_REBUILD_TRIANGLES, m_chunkedTriangleCount / 4))
+    {
+        rebuildChunkyTriMesh();
+    }
+
+    // Tiles are swapped in in tile order, as by generate
+    std::sort(m_dirtyTileIndices.begin(), m_dirtyTileIndices.end());
+
+    // Heightfields of tiles with changed geometry are stale, free their bytes for the tiles about to be built
+    for (int tileIndex : m_dirtyTileIndices)
+    {
+        if (m_dirtyTiles[tileIndex] == TILE_GEOMETRY_DIRTY)
+            releaseCachedCompactHeightfield(m_cache[tileIndex]);
+    }
+
+    const int addedTileCount = buildTiles(m_dirtyTileIndices.data(), int(m_dirtyTileIndices.size()), m_tileWidth, m_verts.data(), getTriangleCount() * 3, m_config, m_createParams, m_navMesh);
+
+    const unsigned int firstBuildUse = m_cacheUseCount + 1;
+    for (int tileIndex : m_dirtyTileIndices)
+    {
+        m_dirtyTiles[tileIndex] = TILE_CLEAN;
+
+        if (!m_cache[tileIndex].data.empty())
+            m_cache[tileIndex].lastUse = ++m_cacheUseCount;
+    }
+
+    cachePendingCompactHeightfields(firstBuildUse);
+    m_dirtyTileIndices.clear();
+
+    return addedTileCount;
+}
+
+bool TiledNavMeshBuilder::rebuildChunkyTriMesh()
+{
+    delete m_chunks;
+    m_chunks = nullptr;
+    m_chunkedTriangleCount = 0;
+
+    std::vector<int> tris;
+    tris.reserve(m_triangleStates.size() * 3);
+
+    for (int i = 0; i < getTriangleCount(); ++i)
+    {
+        if (m_triangleStates[i] == TRIANGLE_REMOVED)
+            continue;
+
+        tris.push_back(i * 3);
+        tris.push_back(i * 3 + 1);
+        tris.push_back(i * 3 + 2);
+    }
+
+    // Every triangle that is not removed is chunked from here on, or looked up in the overflow list if this fails
+    m_staleChunkedTriangleCount = 0;
+
+    const int ntris = int(tris.size()) / 3;
+    if (ntris == 0)
+    {
+        m_overflow.clear();
+        return true;
+    }
+
+    rcChunkyTriMesh *chunks = new rcChunkyTriMesh;
+    if (!rcCreateChunkyTriMesh(m_verts.data(), tris.data(), ntris, m_trisPerChunk, chunks))
+    {
+        delete chunks;
+
+        m_overflow.clear();
+        for (int i = 0; i < getTriangleCount(); ++i)
+        {
+            if (m_triangleStates[i] == TRIANGLE_REMOVED)
+                continue;
+
+            m_triangleStates[i] = TRIANGLE_OVERFLOW;
+            m_overflow.push_back(i);
+        }
+
+        return false;
+    }
+
+    m_chunks = chunks;
+    m_chunkedTriangleCount = ntris;
+
+    for (int i : m_overflow)
+    {
+        if (m_triangleStates[i] == TRIANGLE_OVERFLOW)
+            m_triangleStates[i] = TRIANGLE_CHUNKED;
+    }
+    m_overflow.clear();
+
+    return true;
+}
+
+void TiledNavMeshBuilder::gatherTileTriangles(ThreadContext &scratch, float *tbmin, float *tbmax) const
+{
+    scratch.tris.clear();
+
+    if (m_chunks && m_chunks->nnodes > 0)
+    {
+        scratch.chunkIds.resize(m_chunks->nnodes);
+        const int nchunks = rcGetChunksOverlappingRect(m_chunks, tbmin, tbmax, scratch.chunkIds.data(), int(scratch.chunkIds.size()));
+
+        for (int i = 0; i < nchunks; ++i)
+        {
+            const rcChunkyTriMeshNode &node = m_chunks->nodes[scratch.chunkIds[i]];
+
+            for (int j = 0; j < node.n; ++j)
+            {
+                const int *tri = &m_chunks->tris[(node.i + j) * 3];
+                if (m_triangleStates[tri[0] / 3] != TRIANGLE_CHUNKED)
+                    continue;
+
+                scratch.tris.insert(scratch.tris.end(), tri, tri + 3);
+            }
+        }
+    }
+
+    for (int i : m_overflow)
+    {
+        if (m_triangleStates[i] != TRIANGLE_OVERFLOW)
+            continue;
+
+        const float *v = &m_verts[size_t(i) * 9];
+        const float minX = dtMin(v[0], dtMin(v[3], v[6]));
+        const float maxX = dtMax(v[0], dtMax(v[3], v[6]));
+        const float minZ = dtMin(v[2], dtMin(v[5], v[8]));
+        const float maxZ = dtMax(v[2], dtMax(v[5], v[8]));
+
+        if (maxX < tbmin[0] || minX > tbmax[0] || maxZ < tbmin[1] || minZ > tbmax[1])
+            continue;
+
+        scratch.tris.push_back(i * 3);
+        scratch.tris.push_back(i * 3 + 1);
+        scratch.tris.push_back(i * 3 + 2);
+    }
+}
+
+int TiledNavMeshBuilder::buildCompactHeightfield(rcContext *ctx, ThreadContext &scratch, const float *verts, int nverts, const rcConfig &tileConfig, int tileIndex, rcCompactHeightfield **compactHeightfield)
+{
+    CachedCompactHeightfield &cached = m_cache[tileIndex];
+
+    // Tiles with unchanged geometry restart from their cached heightfield
+    if (m_dirtyTiles[tileIndex] == TILE_AREAS_DIRTY && !cached.data.empty())
+    {
+        *compactHeightfield = decompressCompactHeightfield(cached.data, cached.size, scratch.buffer);
+        if (*compactHeightfield)
+        {
+            return NAVMESH_GENERATOR_SUCCESS;
+        }
+    }
+
+    releaseCachedCompactHeightfield(cached);
+
+    const int error = TiledNavMeshGenerator::buildCompactHeightfield(ctx, scratch, verts, nverts, tileConfig, tileIndex, compactHeightfield);
+
+    if (error == NAVMESH_GENERATOR_SUCCESS && *compactHeightfield && m_cacheMaxBytes > 0)
+    {
+        // Tiles built once the cache is full evict older tiles after the build, so the cache stays under its size
+        compressCompactHeightfield(**compactHeightfield, scratch.buffer, cached.data, &cached.size);
+        cached.pending = !reserveCacheBytes(cached.data.size());
+    }
+
+    return error;
+}
+
+void TiledNavMeshBuilder::markAreas(rcContext *ctx, const rcConfig &tileConfig, rcCompactHeightfield &compactHeightfield) const
+{
+    for (const AreaVolume &volume : m_areaVolumes)
+    {
+        if (volume.type == AREA_VOLUME_REMOVED)
+            continue;
+
+        if (volume.bmax[0] < tileConfig.bmin[0] || volume.bmin[0] > tileConfig.bmax[0] || volume.bmax[2] < tileConfig.bmin[2] || volume.bmin[2] > tileConfig.bmax[2])
+            continue;
+
+        switch (volume.type)
+        {
+        case AREA_VOLUME_BOX:
+            rcMarkBoxArea(ctx, volume.bmin, volume.bmax, volume.areaId, compactHeightfield);
+            break;
+        case AREA_VOLUME_CONVEX:
+            rcMarkConvexPolyArea(ctx, volume.verts.data(), int(volume.verts.size()) / 3, volume.bmin[1], volume.bmax[1], volume.areaId, compactHeightfield);
+            break;
+        case AREA_VOLUME_CYLINDER:
+            rcMarkCylinderArea(ctx, volume.position, volume.radius, volume.height, volume.areaId, compactHeightfield);
+            break;
+        }
+    }
+}
+
+int TiledNavMeshBuilder::addAreaVolume(const AreaVolume &volume)
+{
+    m_areaVolumes.push_back(volume);
+    markTilesDirty(volume.bmin, volume.bmax, TILE_AREAS_DIRTY);
+
+    return int(m_areaVolumes.size()) - 1;
+}
+
+int TiledNavMeshBuilder::addBoxArea(const float *bmin, const float *bmax, int areaId)
+{
+    if (areaId < 0 || areaId > RC_WALKABLE_AREA)
+    {
+        return -1;
+    }
+
+    AreaVolume volume;
+    volume.type = AREA_VOLUME_BOX;
+    volume.areaId = (unsigned char)areaId;
+    rcVcopy(volume.bmin, bmin);
+    rcVcopy(volume.bmax, bmax);
+
+    return addAreaVolume(volume);
+}
+
+int TiledNavMeshBuilder::addConvexArea(const FloatArray *verts, float minY, float maxY, int areaId)
+{
+    const int nverts = verts->size / 3;
+    if (areaId < 0 || areaId > RC_WALKABLE_AREA || nverts < 3)
+    {
+        return -1;
+    }
+
+    AreaVolume volume;
+    volume.type = AREA_VOLUME_CONVEX;
+    volume.areaId = (unsigned char)areaId;
+    volume.verts.assign(verts->data, verts->data + nverts * 3);
+
+    rcVcopy(volume.bmin, verts->data);
+    rcVcopy(volume.bmax, verts->data);
+    for (int i = 1; i < nverts; ++i)
+    {
+        rcVmin(volume.bmin, &verts->data[i * 3]);
+        rcVmax(volume.bmax, &verts->data[i * 3]);
+    }
+    volume.bmin[1] = minY;
+    volume.bmax[1] = maxY;
+
+    return addAreaVolume(volume);
+}
+
+int TiledNavMeshBuilder::addCylinderArea(const float *position, float radius, float height, int areaId)
+{
+    if (areaId < 0 || areaId > RC_WALKABLE_AREA)
+    {
+        return -1;
+    }
+
+    AreaVolume volume;
+    volume.type = AREA_VOLUME_CYLINDER;
+    volume.areaId = (unsigned char)areaId;
+    rcVcopy(volume.position, position);
+    volume.radius = radius;
+    volume.height = height;
+
+    volume.bmin[0] = position[0] - radius;
+    volume.bmin[1] = position[1];
+    volume.bmin[2] = position[2] - radius;
+    volume.bmax[0] = position[0] + radius;
+    volume.bmax[1] = position[1] + height;
+    volume.bmax[2] = position[2] + radius;
+
+    return addAreaVolume(volume);
+}
+
+bool TiledNavMeshBuilder::removeArea(int volumeId)
+{
+    if (volumeId < 0 || volumeId >= int(m_areaVolumes.size()) || m_areaVolumes[volumeId].type == AREA_VOLUME_REMOVED)
+    {
+        return false;
+    }
+
+    AreaVolume &volume = m_areaVolumes[volumeId];
+    markTilesDirty(volume.bmin, volume.bmax, TILE_AREAS_DIRTY);
+
+    volume.type = AREA_VOLUME_REMOVED;
+    std::vector<float>().swap(volume.verts);
+
+    return true;
+}
+
+void TiledNavMeshBuilder::setCompactHeightfieldCacheSize(int maxBytes)
+{
+    m_cacheMaxBytes = dtMax(maxBytes, 0);
+
+    evictCompactHeightfields(m_cacheMaxBytes);
+}
+
+int TiledNavMeshBuilder::getCachedTileCount() const
+{
+    int count = 0;
+    for (const CachedCompactHeightfield &cached : m_cache)
+    {
+        if (!cached.data.empty())
+            count++;
+    }
+
+    return count;
+}
+
+bool TiledNavMeshBuilder::isTileCached(int tileX, int tileY) const
+{
+    if (tileX < 0 || tileX >= m_tileWidth || tileY < 0 || tileY >= m_tileHeight)
+    {
+        return false;
+    }
+
+    return !m_cache[tileY * m_tileWidth + tileX].data.empty();
+}
+
+bool TiledNavMeshBuilder::reserveCacheBytes(size_t bytes)
+{
+    size_t cacheBytes = m_cacheBytes.load();
+    do
+    {
+        if (cacheBytes + bytes > size_t(m_cacheMaxBytes))
+            return false;
+    } while (!m_cacheBytes.compare_exchange_weak(cacheBytes, cacheBytes + bytes));
+
+    // A failed exchange reloads peakBytes
+    const size_t newBytes = cacheBytes + bytes;
+    size_t peakBytes = m_cachePeakBytes.load();
+    while (peakBytes < newBytes && !m_cachePeakBytes.compare_exchange_weak(peakBytes, newBytes))
+    {
+        continue;
+    }
+
+    return true;
+}
+
+void TiledNavMeshBuilder::releaseCachedCompactHeightfield(CachedCompactHeightfield &cached)
+{
+    if (!cached.pending)
+        m_cacheBytes -= cached.data.size();
+
+    std::vector<unsigned char>().swap(cached.data);
+    cached.size = 0;
+    cached.pending = false;
+}
+
+void TiledNavMeshBuilder::evictCompactHeightfields(size_t maxBytes)
+{
+    if (m_cacheBytes <= maxBytes)
+    {
+        return;
+    }
+
+    // Least recently built first
+    std::vector<std::pair<unsigned int, int>> cachedTiles;
+    for (int i = 0; i < int(m_cache.size()); ++i)
+    {
+        if (!m_cache[i].data.empty())
+            cachedTiles.push_back(std::make_pair(m_cache[i].lastUse, i));
+    }
+
+    std::sort(cachedTiles.begin(), cachedTiles.end());
+
+    for (const std::pair<unsigned int, int> &cachedTile : cachedTiles)
+    {
+        if (m_cacheBytes <= maxBytes)
+            break;
+
+        releaseCachedCompactHeightfield(m_cache[cachedTile.second]);
+    }
+}
+
+void TiledNavMeshBuilder::cachePendingCompactHeightfields(unsigned int firstBuildUse)
+{
+    // Least recently used first
+    std::vector<std::pair<unsigned int, int>> evictableTiles;
+    bool hasPending = false;
+    for (int i = 0; i < int(m_cache.size()); ++i)
+    {
+        const CachedCompactHeightfield &cached = m_cache[i];
+        if (cached.pending)
+            hasPending = true;
+        else if (!cached.data.empty() && cached.lastUse < firstBuildUse)
+            evictableTiles.push_back(std::make_pair(cached.lastUse, i));
+    }
+
+    if (!hasPending)
+    {
+        return;
+    }
+
+    std::sort(evictableTiles.begin(), evictableTiles.end());
+
+    size_t nextEvicted = 0;
+    for (int tileIndex : m_dirtyTileIndices)
+    {
+        CachedCompactHeightfield &cached = m_cache[tileIndex];
+        if (!cached.pending)
+            continue;
+
+        const size_t bytes = cached.data.size();
+        cached.pending = false;
+
+        if (bytes <= size_t(m_cacheMaxBytes))
+        {
+            while (m_cacheBytes + bytes > size_t(m_cacheMaxBytes) && nextEvicted < evictableTiles.size())
+                releaseCachedCompactHeightfield(m_cache[evictableTiles[nextEvicted++].second]);
+        }
+
+        // Tiles that only fit by evicting tiles of this build are not cached
+        if (!reserveCacheBytes(bytes))
+        {
+            std::vector<unsigned char>().swap(cached.data);
+            cached.size = 0;
+        }
+    }
+}
+
+void TiledNavMeshBuilder::destroy()
+{
+    TiledNavMeshGenerator::destroy();
+
+    delete m_chunks;
+    m_chunks = nullptr;
+    m_chunkedTriangleCount = 0;
+    m_staleChunkedTriangleCount = 0;
+
+    m_navMesh = nullptr;
+    m_tileWidth = 0;
+    m_tileHeight = 0;
+
+    m_verts.clear();
+    m_triangleStates.clear();
+    m_overflow.clear();
+    m_dirtyTiles.clear();
+    m_dirtyTileIndices.clear();
+
+    m_areaVolumes.clear();
+
+    m_cache.clear();
+    m_cacheMaxBytes = 0;
+    m_cacheBytes = 0;
+    m_cachePeakBytes = 0;
+    m_cacheUseCount = 0;
+}
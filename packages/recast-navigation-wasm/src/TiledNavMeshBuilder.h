@@ -0,0 +1,239 @@
+#pragma once
+
+#include "./NavMeshGenerator.h"
+#include <atomic>
+#include <string.h>
+
+// A tiled navmesh generator that keeps its input geometry resident, and rebuilds only the tiles touched by edits.
+//
+// Triangles are stored unindexed, three vertices each, so they keep their id and can be moved in place. Triangles
+// given to init are indexed by a chunky tri mesh. Triangles added or moved later are kept in a short overflow list,
+// which is folded back into a new chunky tri mesh once it grows past a fraction of the input.
+//
+// Edits mark the tiles whose expanded bounds overlap the old and new triangle bounds as dirty, and rebuildDirtyTiles
+// builds just those tiles and swaps them into the navmesh. Geometry outside the navmesh bounds given to init is
+// ignored, as the tile grid is fixed by the navmesh params.
+//
+// Area volumes are marked on each tile's compact heightfield after erosion. With a compact heightfield cache, the
+// filtered compact heightfield of each tile is kept FastLZ compressed, and tiles whose geometry did not change since
+// restart from it when area volumes change, skipping rasterization. The cache stays under its size while tiles are built,
+// tiles built once it is full evict the least recently used heightfields after the build. Lowering the size evicts
+// them too.
+class TiledNavMeshBuilder : public TiledNavMeshGenerator
+{
+public:
+    TiledNavMeshBuilder() : m_navMesh(nullptr), m_tileWidth(0), m_tileHeight(0), m_trisPerChunk(0), m_chunks(nullptr), m_chunkedTriangleCount(0), m_staleChunkedTriangleCount(0), m_cacheMaxBytes(0), m_cacheBytes(0), m_cachePeakBytes(0), m_cacheUseCount(0)
+    {
+        memset(&m_config, 0, sizeof(m_config));
+        memset(&m_createParams, 0, sizeof(m_createParams));
+    }
+
+    ~TiledNavMeshBuilder()
+    {
+        destroy();
+    }
+
+    // Copies the input triangles and builds their chunky tri mesh. config and createParams are as for
+    // TiledNavMeshGenerator::generate, and are copied. Off-mesh connection arrays are referenced, not copied.
+    // The navmesh must be initialized for tiled use, and outlive the builder. No tiles are built until buildAllTiles
+    // or rebuildDirtyTiles is called.
+    bool init(const FloatArray *positions, const IntArray *indices, int trisPerChunk, const rcConfig *config, const dtNavMeshCreateParams *createParams, NavMesh *navMesh, int threadCount);
+
+    // Builds every tile, returns the number of tiles added
+    int buildAllTiles();
+
+    // Adds indexed triangles, returns the id of the first added triangle, ids of the rest follow
+    int addTriangles(const FloatArray *positions, const IntArray *indices);
+
+    // Removes count triangles from id first. Ids are not reused.
+    bool removeTriangles(int first, int count);
+
+    // Moves the triangles from id first to new positions, 9 floats per triangle
+    bool updateTriangles(int first, const FloatArray *positions);
+
+    // Marks the tiles overlapping bounds as dirty, to rebuild a region without a triangle edit
+    void markDirtyBounds(const float *bmin, const float *bmax);
+
+    // Marks areaId on the spans inside a box, returns the volume id
+    int addBoxArea(const float *bmin, const float *bmax, int areaId);
+
+    // Marks areaId on the spans inside a convex polygon extruded from minY to maxY, returns the volume id.
+    // verts holds 3 floats per polygon vertex.
+    int addConvexArea(const FloatArray *verts, float minY, float maxY, int areaId);
+
+    // Marks areaId on the spans inside a cylinder standing on position, returns the volume id
+    int addCylinderArea(const float *position, float radius, float height, int areaId);
+
+    // Removes an area volume. Volume ids are not reused.
+    bool removeArea(int volumeId);
+
+    // Rebuilds the dirty tiles, returns the number of tiles added
+    int rebuildDirtyTiles();
+
+    // Sets the size of the compact heightfield cache in bytes, 0 disables it. Evicts heightfields over the new size.
+    void setCompactHeightfieldCacheSize(int maxBytes);
+
+    int getCompactHeightfieldCacheSize() const
+    {
+        return m_cacheMaxBytes;
+    }
+
+    // The compressed size of the cached compact heightfields
+    int getCompactHeightfieldCacheBytes() const
+    {
+        return int(m_cacheBytes);
+    }
+
+    // The most bytes the cache has held, including while tiles are built
+    int getCompactHeightfieldCachePeakBytes() const
+    {
+        return int(m_cachePeakBytes);
+    }
+
+    int getCachedTileCount() const;
+
+    bool isTileCached(int tileX, int tileY) const;
+
+    int getDirtyTileCount() const
+    {
+        return int(m_dirtyTileIndices.size());
+    }
+
+    // The number of triangle ids handed out, including removed triangles
+    int getTriangleCount() const
+    {
+        return int(m_triangleStates.size());
+    }
+
+    int getTileWidth() const
+    {
+        return m_tileWidth;
+    }
+
+    int getTileHeight() const
+    {
+        return m_tileHeight;
+    }
+
+    void destroy();
+
+protected:
+    void gatherTileTriangles(ThreadContext &scratch, float *tbmin, float *tbmax) const override;
+
+    int buildCompactHeightfield(rcContext *ctx, ThreadContext &scratch, const float *verts, int nverts, const rcConfig &tileConfig, int tileIndex, rcCompactHeightfield **compactHeightfield) override;
+
+    void markAreas(rcContext *ctx, const rcConfig &tileConfig, rcCompactHeightfield &compactHeightfield) const override;
+
+private:
+    enum TriangleState
+    {
+        TRIANGLE_CHUNKED,
+        TRIANGLE_OVERFLOW,
+        TRIANGLE_REMOVED
+    };
+
+    // How much of a dirty tile has to be rebuilt, tiles keep the highest level they were marked with
+    enum TileDirtyLevel
+    {
+        TILE_CLEAN,
+        TILE_AREAS_DIRTY,
+        TILE_GEOMETRY_DIRTY
+    };
+
+    enum AreaVolumeType
+    {
+        AREA_VOLUME_BOX,
+        AREA_VOLUME_CONVEX,
+        AREA_VOLUME_CYLINDER,
+        AREA_VOLUME_REMOVED
+    };
+
+    struct AreaVolume
+    {
+        int type;
+        unsigned char areaId;
+
+        // Bounds of the marked space, and the box of box volumes
+        float bmin[3];
+        float bmax[3];
+
+        // Position of cylinder volumes
+        float position[3];
+        float radius;
+        float height;
+
+        // Polygon of convex volumes
+        std::vector<float> verts;
+    };
+
+    struct CachedCompactHeightfield
+    {
+        CachedCompactHeightfield() : size(0), lastUse(0), pending(false)
+        {
+        }
+
+        // FastLZ compressed, empty if the tile is not cached
+        std::vector<unsigned char> data;
+
+        // Uncompressed size
+        int size;
+        unsigned int lastUse;
+
+        // Built while the cache was full. The bytes are not claimed until the build ends, see cachePendingCompactHeightfields.
+        bool pending;
+    };
+
+    void markTilesDirty(const float *bmin, const float *bmax, int level);
+
+    void markTrianglesDirty(int first, int count);
+
+    int addAreaVolume(const AreaVolume &volume);
+
+    void evictCompactHeightfields(size_t maxBytes);
+
+    // Caches heightfields of the tiles just built that did not fit, by evicting the least recently used tiles
+    // not used by the build. Called on the calling thread after the build.
+    void cachePendingCompactHeightfields(unsigned int firstBuildUse);
+
+    // Claims bytes of the cache for a tile, false if they do not fit. Called from tile builds on worker threads.
+    bool reserveCacheBytes(size_t bytes);
+
+    // Frees the cached heightfield of a tile, and its bytes
+    void releaseCachedCompactHeightfield(CachedCompactHeightfield &cached);
+
+    // Rebuilds the chunky tri mesh from every triangle that is not removed, and clears the overflow list
+    bool rebuildChunkyTriMesh();
+
+    NavMesh *m_navMesh;
+    rcConfig m_config;
+    dtNavMeshCreateParams m_createParams;
+
+    int m_tileWidth;
+    int m_tileHeight;
+    int m_trisPerChunk;
+
+    // 9 floats per triangle
+    std::vector<float> m_verts;
+    std::vector<unsigned char> m_triangleStates;
+
+    rcChunkyTriMesh *m_chunks;
+    int m_chunkedTriangleCount;
+
+    // Chunked triangles that have since been removed or moved, and are skipped when gathering chunks
+    int m_staleChunkedTriangleCount;
+
+    // Triangles added or moved since the chunky tri mesh was built
+    std::vector<int> m_overflow;
+
+    std::vector<unsigned char> m_dirtyTiles;
+    std::vector<int> m_dirtyTileIndices;
+
+    std::vector<AreaVolume> m_areaVolumes;
+
+    // Per tile, written by tile builds on worker threads
+    std::vector<CachedCompactHeightfield> m_cache;
+    int m_cacheMaxBytes;
+    std::atomic<size_t> m_cacheBytes;
+    std::atomic<size_t> m_cachePeakBytes;
+    unsigned int m_cacheUseCount;
+};
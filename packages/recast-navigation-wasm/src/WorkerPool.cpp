@@ -0,0 +1,173 @@
+#include "./WorkerPool.h"
+
+#ifndef RECAST_NAVIGATION_MAX_THREADS
+#define RECAST_NAVIGATION_MAX_THREADS 8
+#endif
+
+#ifndef RECAST_NAVIGATION_PTHREAD_POOL_SIZE
+#define RECAST_NAVIGATION_PTHREAD_POOL_SIZE RECAST_NAVIGATION_MAX_THREADS
+#endif
+
+#ifdef RECAST_NAVIGATION_THREADS
+// Workers started by every pool. Only the prewarmed pthreads can start without waiting on the event loop, which a
+// blocked parallelFor would never return to, so the total is capped to the pthread pool size.
+static std::mutex s_workerCountMutex;
+static int s_workerCount = 0;
+
+WorkerPool::WorkerPool() : m_threadCount(1), m_job(nullptr), m_count(0), m_grain(1), m_next(0), m_running(0), m_generation(0), m_stopping(false) {}
+#else
+WorkerPool::WorkerPool() : m_threadCount(1) {}
+#endif
+
+int WorkerPool::getMaxThreadCount()
+{
+#ifdef RECAST_NAVIGATION_THREADS
+    const int hardwareThreads = int(std::thread::hardware_concurrency());
+    if (hardwareThreads <= 1)
+        return 1;
+    return hardwareThreads < RECAST_NAVIGATION_MAX_THREADS ? hardwareThreads : RECAST_NAVIGATION_MAX_THREADS;
+#else
+    return 1;
+#endif
+}
+
+bool WorkerPool::init(int threadCount)
+{
+    destroy();
+
+    const int maxThreads = getMaxThreadCount();
+    if (threadCount <= 0 || threadCount > maxThreads)
+    {
+        threadCount = maxThreads;
+    }
+
+#ifdef RECAST_NAVIGATION_THREADS
+    // Workers start from the prewarmed pthread pool, so creating them does not wait on the event loop.
+    // Pools share the pthread pool, so a pool gets fewer workers once other pools have taken it.
+    {
+        std::lock_guard<std::mutex> lock(s_workerCountMutex);
+        const int availableWorkers = RECAST_NAVIGATION_PTHREAD_POOL_SIZE - s_workerCount;
+        if (threadCount - 1 > availableWorkers)
+        {
+            threadCount = availableWorkers + 1;
+        }
+        s_workerCount += threadCount - 1;
+    }
+#endif
+
+    m_threadCount = threadCount;
+
+#ifdef RECAST_NAVIGATION_THREADS
+    m_workers.reserve(threadCount - 1);
+    for (int i = 1; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&WorkerPool::workerLoop, this, i, m_generation);
+    }
+#endif
+
+    return true;
+}
+
+void WorkerPool::parallelFor(int count, int grain, const Job &job)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    if (grain < 1)
+    {
+        grain = 1;
+    }
+
+#ifdef RECAST_NAVIGATION_THREADS
+    if (!m_workers.empty() && count > grain)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_job = &job;
+            m_count = count;
+            m_grain = grain;
+            m_next = 0;
+            m_running = int(m_workers.size());
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        runChunks(0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_running == 0; });
+        m_job = nullptr;
+
+        return;
+    }
+#endif
+
+    job(0, count, 0);
+}
+
+#ifdef RECAST_NAVIGATION_THREADS
+void WorkerPool::runChunks(int threadIndex)
+{
+    for (;;)
+    {
+        const int begin = m_next.fetch_add(m_grain);
+        if (begin >= m_count)
+            return;
+
+        const int end = begin + m_grain < m_count ? begin + m_grain : m_count;
+        (*m_job)(begin, end, threadIndex);
+    }
+}
+
+void WorkerPool::workerLoop(int threadIndex, unsigned int generation)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, generation] { return m_stopping || m_generation != generation; });
+
+            if (m_stopping)
+                return;
+
+            generation = m_generation;
+        }
+
+        runChunks(threadIndex);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_running == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
+#endif
+
+void WorkerPool::destroy()
+{
+#ifdef RECAST_NAVIGATION_THREADS
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_workerCountMutex);
+        s_workerCount -= int(m_workers.size());
+    }
+
+    m_workers.clear();
+    m_stopping = false;
+#endif
+
+    m_threadCount = 1;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <functional>
+
+#ifdef RECAST_NAVIGATION_THREADS
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+// A fixed pool of worker threads for data parallel loops.
+//
+// Workers are only started in the threaded build, where RECAST_NAVIGATION_THREADS is defined.
+// Otherwise the pool has a single thread, and loops run on the calling thread.
+// Workers of every pool together are capped to RECAST_NAVIGATION_PTHREAD_POOL_SIZE, so a pool initialized while
+// others hold workers may get fewer threads than requested.
+class WorkerPool
+{
+public:
+    // Runs the items in [begin, end). threadIndex is in [0, getThreadCount()), where 0 is the calling thread.
+    typedef std::function<void(int begin, int end, int threadIndex)> Job;
+
+    WorkerPool();
+
+    ~WorkerPool()
+    {
+        destroy();
+    }
+
+    // threadCount includes the calling thread, 0 uses getMaxThreadCount(). Counts are clamped to getMaxThreadCount(),
+    // and to the workers left by other pools.
+    bool init(int threadCount);
+
+    // Splits [0, count) into chunks of at most grain items, and runs them on the workers and the calling thread.
+    // Blocks until every chunk has run. Chunks are claimed in any order, so jobs should only write state owned by
+    // their items, or by their threadIndex.
+    void parallelFor(int count, int grain, const Job &job);
+
+    int getThreadCount() const
+    {
+        return m_threadCount;
+    }
+
+    void destroy();
+
+    // The hardware concurrency, capped to RECAST_NAVIGATION_MAX_THREADS. 1 in single threaded builds.
+    static int getMaxThreadCount();
+
+private:
+    int m_threadCount;
+
+#ifdef RECAST_NAVIGATION_THREADS
+    // generation is the pool's generation when the worker was started, so it waits for the next job
+    void workerLoop(int threadIndex, unsigned int generation);
+
+    void runChunks(int threadIndex);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    const Job *m_job;
+    int m_count;
+    int m_grain;
+    std::atomic<int> m_next;
+    int m_running;
+    unsigned int m_generation;
+    bool m_stopping;
+#endif
+};
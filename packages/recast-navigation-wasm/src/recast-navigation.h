@@ -7,10 +7,17 @@
 #include "./NavMesh.h"
 #include "./NavMeshQuery.h"
 #include "./Crowd.h"
+#include "./CrowdUpdater.h"
+#include "./FlowField.h"
 #include "./NavMeshSerdes.h"
+#include "./NavMeshTileStreamer.h"
+#include "./NavMeshPathCache.h"
+#include "./NavMeshPathRequestManager.h"
 #include "./Recast.h"
 #include "./Detour.h"
 #include "./ChunkyTriMesh.h"
+#include "./NavMeshGenerator.h"
+#include "./TiledNavMeshBuilder.h"
 #include "./DebugDraw/DebugDraw.h"
 #include "./DebugDraw/RecastDebugDraw.h"
 #include "./DebugDraw/DetourDebugDraw.h"
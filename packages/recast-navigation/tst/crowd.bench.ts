@@ -0,0 +1,108 @@
+import {
+  Crowd,
+  type CrowdParams,
+  NavMesh,
+  NavMeshQuery,
+  init,
+} from 'recast-navigation';
+import { generateTiledNavMesh } from 'recast-navigation/generators';
+import { afterAll, beforeAll, bench, describe } from 'vitest';
+import { createTestLevel } from './utils';
+
+// RECAST_NAVIGATION_THREADS=1 yarn bench, to compare with the threaded build
+const AGENT_COUNTS = [1000, 5000, 10000];
+
+let navMesh: NavMesh;
+let navMeshQuery: NavMeshQuery;
+
+beforeAll(async () => {
+  if (process.env.RECAST_NAVIGATION_THREADS) {
+    const threads = await import('@recast-navigation/wasm/wasm-threads');
+    await init(threads.default);
+  } else {
+    await init();
+  }
+
+  const { positions, indices } = createTestLevel(200);
+
+  const result = generateTiledNavMesh(positions, indices, {
+    cs: 0.2,
+    ch: 0.2,
+    tileSize: 64,
+  });
+
+  if (!result.success) throw new Error('nav mesh generation failed');
+
+  navMesh = result.navMesh;
+  navMeshQuery = new NavMeshQuery(navMesh);
+});
+
+const randomPoint = () =>
+  navMeshQuery.findClosestPoint({
+    x: (Math.random() - 0.5) * 190,
+    y: 0,
+    z: (Math.random() - 0.5) * 190,
+  }).point;
+
+const createCrowd = (
+  agentCount: number,
+  engine?: Pick<CrowdParams, 'threads' | 'gridCellSize'>,
+) => {
+  const crowd = new Crowd(navMesh, {
+    maxAgents: agentCount,
+    maxAgentRadius: 0.5,
+    ...engine,
+  });
+
+  for (let i = 0; i < agentCount; i++) {
+    const agent = crowd.addAgent(randomPoint(), {
+      radius: 0.5,
+      maxSpeed: 3,
+      maxAcceleration: 10,
+    });
+
+    agent.requestMoveTarget(randomPoint());
+  }
+
+  // settle path requests, so iterations measure steady state updates
+  for (let i = 0; i < 30; i++) {
+    crowd.update(1 / 60);
+  }
+
+  return crowd;
+};
+
+for (const agentCount of AGENT_COUNTS) {
+  describe(`crowd update ${agentCount} agents`, () => {
+    let crowd: Crowd;
+    let largeCrowd: Crowd;
+    let threadedCrowd: Crowd;
+
+    beforeAll(() => {
+      crowd = createCrowd(agentCount);
+      largeCrowd = createCrowd(agentCount, { gridCellSize: 2.5 });
+      threadedCrowd = createCrowd(agentCount, {
+        threads: 0,
+        gridCellSize: 2.5,
+      });
+    });
+
+    afterAll(() => {
+      crowd.destroy();
+      largeCrowd.destroy();
+      threadedCrowd.destroy();
+    });
+
+    bench('dtCrowd update', () => {
+      crowd.update(1 / 60);
+    });
+
+    bench('large crowd engine update', () => {
+      largeCrowd.update(1 / 60);
+    });
+
+    bench('large crowd engine update, all threads', () => {
+      threadedCrowd.update(1 / 60);
+    });
+  });
+}
@@ -1,8 +1,21 @@
-import { Crowd, NavMesh, init } from 'recast-navigation';
-import { generateSoloNavMesh } from 'recast-navigation/generators';
+import {
+  Crowd,
+  CrowdUpdatePhase,
+  Detour,
+  NavMesh,
+  Raw,
+  crowdAgentStateStride,
+  crowdUpdatePhaseCount,
+  crowdUpdateProfileStride,
+  init,
+} from 'recast-navigation';
+import {
+  generateSoloNavMesh,
+  generateTiledNavMesh,
+} from 'recast-navigation/generators';
 import { BoxGeometry, BufferAttribute, Mesh } from 'three';
 import { beforeEach, describe, expect, test } from 'vitest';
-import { expectVectorToBeCloseTo } from './utils';
+import { createTestLevel, expectVectorToBeCloseTo } from './utils';
 
 describe('Crowd', () => {
   let navMesh: NavMesh;
@@ -78,4 +91,487 @@ describe('Crowd', () => {
 
     expect(agent.radius).toBeCloseTo(0.2);
   });
+
+  test('getActiveAgentStates', () => {
+    const a = crowd.addAgent({ x: -1, y: 0, z: -1 }, { radius: 0.5 });
+    const b = crowd.addAgent({ x: 1, y: 0, z: 1 }, { radius: 0.5 });
+    const removed = crowd.addAgent({ x: 0, y: 0, z: 0 }, { radius: 0.5 });
+    crowd.removeAgent(removed);
+
+    b.requestMoveTarget({ x: 2, y: 0, z: -2 });
+    crowd.update(1 / 60);
+
+    const { count, indices, states } = crowd.getActiveAgentStates();
+
+    expect(count).toBe(2);
+    expect([...indices]).toEqual([a.agentIndex, b.agentIndex]);
+    expect(states.length).toBe(count * crowdAgentStateStride);
+
+    for (let i = 0; i < count; i++) {
+      const agent = crowd.getAgent(indices[i])!;
+      const offset = i * crowdAgentStateStride;
+
+      expectVectorToBeCloseTo(
+        { x: states[offset], y: states[offset + 1], z: states[offset + 2] },
+        agent.position(),
+        4,
+      );
+      expectVectorToBeCloseTo(
+        {
+          x: states[offset + 3],
+          y: states[offset + 4],
+          z: states[offset + 5],
+        },
+        agent.velocity(),
+        4,
+      );
+      expectVectorToBeCloseTo(
+        {
+          x: states[offset + 6],
+          y: states[offset + 7],
+          z: states[offset + 8],
+        },
+        agent.desiredVelocity(),
+        4,
+      );
+      expect(states[offset + 9]).toBe(agent.state());
+      expect(states[offset + 10]).toBe(agent.raw.targetState);
+    }
+
+    const corner = b.corners()[0];
+    const offset = crowdAgentStateStride;
+    expectVectorToBeCloseTo(
+      {
+        x: states[offset + 11],
+        y: states[offset + 12],
+        z: states[offset + 13],
+      },
+      corner,
+      4,
+    );
+  });
+
+  test('batch commands', () => {
+    const a = crowd.addAgent({ x: -1, y: 0, z: -1 }, { radius: 0.5 });
+    const b = crowd.addAgent({ x: 1, y: 0, z: 1 }, { radius: 0.5 });
+
+    expect(
+      crowd.requestMoveTargets(
+        [a.agentIndex, b.agentIndex],
+        [2, 0, 2, -2, 0, -2],
+      ),
+    ).toBe(2);
+
+    for (let i = 0; i < 180; i++) {
+      crowd.update(1 / 60);
+    }
+
+    expectVectorToBeCloseTo(a.position(), { x: 2, y: 0, z: 2 }, 0.3);
+    expectVectorToBeCloseTo(b.position(), { x: -2, y: 0, z: -2 }, 0.3);
+
+    expect(crowd.resetMoveTargets([a.agentIndex, b.agentIndex])).toBe(2);
+
+    expect(crowd.requestMoveVelocities([a.agentIndex], [1, 0, 0])).toBe(1);
+    expect(a.raw.targetState).toBe(Detour.DT_CROWDAGENT_TARGET_VELOCITY);
+
+    expect(
+      crowd.teleportAgents(
+        [a.agentIndex, b.agentIndex, 99],
+        [0, 0, 0, 1, 0, 0, 0, 0, 0],
+      ),
+    ).toBe(2);
+
+    expectVectorToBeCloseTo(a.position(), { x: 0, y: 0, z: 0 }, 0.3);
+    expectVectorToBeCloseTo(b.position(), { x: 1, y: 0, z: 0 }, 0.3);
+  });
+
+  test('fixed stepping with interpolation', () => {
+    const agent = crowd.addAgent({ x: -2, y: 0, z: 0 }, { radius: 0.5 });
+    agent.requestMoveTarget({ x: 2, y: 0, z: 0 });
+
+    const dt = 1 / 60;
+
+    for (let i = 0; i < 30; i++) {
+      crowd.update(dt, dt);
+    }
+
+    const before = agent.position();
+
+    crowd.update(dt, dt * 1.5);
+
+    const after = agent.position();
+    const positions = crowd.getInterpolatedPositions()!;
+
+    expect(after.x).toBeGreaterThan(before.x);
+
+    // halfway between the last two steps
+    expect(agent.interpolatedPosition.x).toBeCloseTo(
+      (before.x + after.x) / 2,
+      4,
+    );
+    expect(positions[agent.agentIndex * 3]).toBeCloseTo(
+      agent.interpolatedPosition.x,
+      4,
+    );
+
+    agent.teleport({ x: 0, y: 0, z: 2 });
+    crowd.update(dt, 0);
+
+    expectVectorToBeCloseTo(
+      agent.interpolatedPosition,
+      agent.position(),
+      4,
+    );
+  });
+
+  test('worker pool updater matches dtCrowd update', () => {
+    const threaded = new Crowd(navMesh, {
+      maxAgents: 10,
+      maxAgentRadius: 0.5,
+      threads: 0,
+    });
+
+    expect(threaded.threadCount).toBeGreaterThanOrEqual(1);
+
+    const starts = [
+      { x: -2, y: 0, z: -2 },
+      { x: 2, y: 0, z: -2 },
+      { x: 0, y: 0, z: 2 },
+    ];
+
+    const pairs = starts.map((start) => {
+      const a = crowd.addAgent(start, { radius: 0.5 });
+      const b = threaded.addAgent(start, { radius: 0.5 });
+
+      a.requestMoveTarget({ x: -start.x, y: 0, z: -start.z });
+      b.requestMoveTarget({ x: -start.x, y: 0, z: -start.z });
+
+      return [a, b];
+    });
+
+    for (let i = 0; i < 120; i++) {
+      crowd.update(1 / 60);
+      threaded.update(1 / 60);
+    }
+
+    for (const [a, b] of pairs) {
+      expectVectorToBeCloseTo(b.position(), a.position(), 4);
+      expectVectorToBeCloseTo(b.velocity(), a.velocity(), 4);
+    }
+
+    threaded.destroy();
+  });
+
+  test('worker pool updater can be re-initialized', () => {
+    const agent = crowd.addAgent({ x: -2, y: 0, z: -2 }, { radius: 0.5 });
+    agent.requestMoveTarget({ x: 2, y: 0, z: 2 });
+
+    const updater = new Raw.Module.CrowdUpdater();
+
+    // workers started by a re-init must wait for the next update
+    for (let i = 0; i < 3; i++) {
+      expect(updater.init(navMesh.raw, crowd.raw, 0)).toBe(true);
+
+      for (let j = 0; j < 20; j++) {
+        updater.update(1 / 60);
+      }
+    }
+
+    expect(agent.position().x).toBeGreaterThan(-2);
+
+    // cell sizes are clamped to the max agent radius
+    updater.setGridCellSize(0.0001);
+    expect(updater.getGridCellSize()).toBeCloseTo(0.5);
+
+    updater.destroy();
+    Raw.destroy(updater);
+  });
+
+  test('large crowd engine finds neighbours across grid cells', () => {
+    const largeCrowd = new Crowd(navMesh, {
+      maxAgents: 10,
+      maxAgentRadius: 0.5,
+      gridCellSize: 0.5,
+    });
+
+    expect(largeCrowd.threadCount).toBe(1);
+
+    const a = largeCrowd.addAgent({ x: -0.5, y: 0, z: 0 }, { radius: 0.5 });
+    const b = largeCrowd.addAgent({ x: 0.5, y: 0, z: 0 }, { radius: 0.5 });
+    largeCrowd.addAgent({ x: 2.2, y: 0, z: 2.2 }, { radius: 0.1 });
+
+    largeCrowd.update(1 / 60);
+
+    expect(a.raw.nneis).toBe(1);
+    expect(a.raw.get_neis(0).idx).toBe(b.agentIndex);
+    expect(b.raw.nneis).toBe(1);
+    expect(b.raw.get_neis(0).idx).toBe(a.agentIndex);
+
+    largeCrowd.destroy();
+  });
+
+  test('snapshot and restore', () => {
+    const a = crowd.addAgent({ x: -2, y: 0, z: -2 }, { radius: 0.3 });
+    const b = crowd.addAgent({ x: 2, y: 0, z: -2 }, { radius: 0.3 });
+    a.requestMoveTarget({ x: 2, y: 0, z: 2 });
+    b.requestMoveTarget({ x: -2, y: 0, z: 2 });
+
+    for (let i = 0; i < 10; i++) {
+      crowd.update(1 / 60);
+    }
+
+    const snapshot = crowd.exportSnapshot();
+
+    const step = () => {
+      for (let i = 0; i < 30; i++) {
+        crowd.update(1 / 60);
+      }
+      return [a.position(), b.position()];
+    };
+
+    const expected = step();
+
+    crowd.removeAgent(b);
+    expect(crowd.importSnapshot(snapshot)).toBe(true);
+    expect(crowd.getAgents().length).toBe(2);
+    expect(crowd.exportSnapshot()).toEqual(snapshot);
+
+    const restoredB = crowd.getAgent(b.agentIndex)!;
+    const actual = step();
+    expectVectorToBeCloseTo(actual[0], expected[0], 4);
+    expectVectorToBeCloseTo(restoredB.position(), expected[1], 4);
+
+    // restores into another crowd with the same max agents
+    const other = new Crowd(navMesh, { maxAgents: 10, maxAgentRadius: 0.5 });
+    expect(other.importSnapshot(snapshot)).toBe(true);
+    expect(other.getActiveAgentCount()).toBe(2);
+    expect(other.exportSnapshot()).toEqual(snapshot);
+
+    const smaller = new Crowd(navMesh, { maxAgents: 5, maxAgentRadius: 0.5 });
+    expect(smaller.importSnapshot(snapshot)).toBe(false);
+    expect(smaller.importSnapshot(snapshot.slice(0, 100))).toBe(false);
+
+    other.destroy();
+    smaller.destroy();
+  });
+
+  test('profiles large crowd engine update phases', () => {
+    expect(() => crowd.setProfilingEnabled(true)).toThrow();
+
+    const largeCrowd = new Crowd(navMesh, {
+      maxAgents: 10,
+      maxAgentRadius: 0.5,
+      gridCellSize: 1.5,
+    });
+
+    const a = largeCrowd.addAgent({ x: -1, y: 0, z: 0 }, { radius: 0.5 });
+    largeCrowd.addAgent({ x: 0, y: 0, z: 0 }, { radius: 0.5 });
+    a.requestMoveTarget({ x: 2, y: 0, z: 2 });
+
+    // off by default
+    largeCrowd.update(1 / 60);
+    expect(
+      largeCrowd.getUpdatePhaseProfile(CrowdUpdatePhase.TOTAL).count,
+    ).toBe(0);
+
+    largeCrowd.setProfilingEnabled(true);
+    expect(largeCrowd.profilingEnabled).toBe(true);
+
+    for (let i = 0; i < 10; i++) {
+      largeCrowd.update(1 / 60);
+    }
+
+    const profile = largeCrowd.getUpdateProfile();
+    expect(profile.length).toBe(
+      crowdUpdatePhaseCount * crowdUpdateProfileStride,
+    );
+
+    const count = (phase: number) =>
+      profile[phase * crowdUpdateProfileStride + 1];
+
+    expect(count(CrowdUpdatePhase.TOTAL)).toBe(10);
+    expect(count(CrowdUpdatePhase.INTEGRATE)).toBe(20);
+    expect(count(CrowdUpdatePhase.COLLISION)).toBe(40);
+    expect(count(CrowdUpdatePhase.NEIGHBOURS)).toBeGreaterThan(0);
+    expect(count(CrowdUpdatePhase.AVOIDANCE)).toBeGreaterThan(0);
+
+    let phaseTime = 0;
+    for (let phase = 0; phase < CrowdUpdatePhase.TOTAL; phase++) {
+      const time = profile[phase * crowdUpdateProfileStride];
+      expect(time).toBeGreaterThanOrEqual(0);
+      phaseTime += time;
+    }
+    expect(phaseTime).toBeLessThanOrEqual(
+      profile[CrowdUpdatePhase.TOTAL * crowdUpdateProfileStride] + 1e-3,
+    );
+
+    largeCrowd.resetUpdateProfile();
+    expect(largeCrowd.getUpdatePhaseProfile(CrowdUpdatePhase.TOTAL)).toEqual({
+      time: 0,
+      count: 0,
+    });
+
+    largeCrowd.destroy();
+  });
+
+  test('configurable path queue budget', () => {
+    expect(() => crowd.getPathQueueStats()).toThrow();
+
+    const { positions, indices } = createTestLevel(40);
+    const result = generateTiledNavMesh(positions, indices, {
+      cs: 0.25,
+      ch: 0.2,
+      tileSize: 16,
+    });
+
+    if (!result.success) throw new Error('nav mesh generation failed');
+
+    const largeCrowd = new Crowd(result.navMesh, {
+      maxAgents: 10,
+      maxAgentRadius: 0.5,
+      pathQueue: { capacity: 2, maxIterations: 10 },
+    });
+
+    expect(largeCrowd.getPathQueueParams()).toEqual({
+      capacity: 2,
+      maxIterations: 10,
+      maxSearchNodes: 4096,
+      maxPathResult: 256,
+      replanDelay: 1,
+      topologyOptimizationDelay: 0.5,
+    });
+
+    for (let i = 0; i < 6; i++) {
+      const agent = largeCrowd.addAgent(
+        { x: -18 + i * 2, y: 0, z: -18 },
+        { radius: 0.4 },
+      );
+      agent.requestMoveTarget({ x: 18 - i * 2, y: 0, z: 18 });
+    }
+
+    // long paths go through the queue, two at a time
+    largeCrowd.update(1 / 60);
+
+    let stats = largeCrowd.getPathQueueStats();
+    expect(stats.startedRequests).toBe(2);
+    expect(stats.activeRequests).toBe(2);
+    expect(stats.queueDepth).toBe(6);
+    expect(stats.iterations).toBeLessThanOrEqual(10);
+
+    let completed = 0;
+    let maxWaitTime = 0;
+    for (let i = 0; i < 1000 && completed < 6; i++) {
+      largeCrowd.update(1 / 60);
+
+      stats = largeCrowd.getPathQueueStats();
+      expect(stats.activeRequests).toBeLessThanOrEqual(2);
+      expect(stats.iterations).toBeLessThanOrEqual(10);
+
+      completed += stats.completedRequests;
+      maxWaitTime = Math.max(maxWaitTime, stats.maxWaitTime);
+    }
+
+    expect(completed).toBeGreaterThanOrEqual(6);
+    expect(maxWaitTime).toBeGreaterThan(0);
+
+    expect(largeCrowd.setPathQueueParams({ capacity: 0 })).toBe(false);
+    expect(largeCrowd.setPathQueueParams({ maxPathResult: 1000 })).toBe(true);
+    expect(largeCrowd.getPathQueueParams().maxPathResult).toBe(256);
+    expect(largeCrowd.getPathQueueParams().capacity).toBe(2);
+
+    largeCrowd.destroy();
+    result.navMesh.destroy();
+  });
+
+  test('level of detail tiers from focus points', () => {
+    expect(() => crowd.setAgentLodTier(0, 1)).toThrow();
+
+    const largeCrowd = new Crowd(navMesh, {
+      maxAgents: 10,
+      maxAgentRadius: 0.5,
+      gridCellSize: 1.5,
+    });
+
+    const near = largeCrowd.addAgent({ x: -2, y: 0, z: -2 }, { radius: 0.2 });
+    const middle = largeCrowd.addAgent({ x: 0, y: 0, z: -2 }, { radius: 0.2 });
+    const far = largeCrowd.addAgent({ x: 2, y: 0, z: -2 }, { radius: 0.2 });
+
+    const reduced = largeCrowd.setLodTiersFromFocusPoints(
+      [{ x: -2, y: 0, z: -2 }],
+      [1, 3],
+    );
+
+    expect(reduced).toBe(2);
+    expect(largeCrowd.getAgentLodTier(near.agentIndex)).toBe(0);
+    expect(largeCrowd.getAgentLodTier(middle.agentIndex)).toBe(1);
+    expect(largeCrowd.getAgentLodTier(far.agentIndex)).toBe(2);
+
+    // far agents rarely get a full update, and steer straight along their corridor in between
+    expect(largeCrowd.setLodTier(2, { updateInterval: 1000 })).toBe(true);
+    expect(largeCrowd.getLodTier(2).updateInterval).toBe(1000);
+    expect(largeCrowd.getLodTier(2).collision).toBe(false);
+
+    for (const agent of [near, middle, far]) {
+      agent.requestMoveTarget({ x: agent.position().x, y: 0, z: 2 });
+    }
+
+    for (let i = 0; i < 30; i++) {
+      largeCrowd.update(1 / 60);
+    }
+
+    expect(near.velocity().z).toBeGreaterThan(0);
+    expect(middle.velocity().z).toBeGreaterThan(0);
+    expect(far.velocity().z).toBeGreaterThan(0);
+
+    largeCrowd.removeAgent(far);
+    expect(largeCrowd.getAgentLodTier(far.agentIndex)).toBe(2);
+    largeCrowd.update(1 / 60);
+    expect(largeCrowd.getAgentLodTier(far.agentIndex)).toBe(0);
+
+    // agents added into a slot freed since the last update start in tier 0
+    largeCrowd.setAgentLodTier(middle.agentIndex, 2);
+    largeCrowd.removeAgent(middle);
+    const added = largeCrowd.addAgent({ x: 0, y: 0, z: -2 }, { radius: 0.2 });
+    expect(added.agentIndex).toBe(middle.agentIndex);
+    expect(largeCrowd.getAgentLodTier(added.agentIndex)).toBe(0);
+
+    // without focus points every agent gets full detail
+    expect(largeCrowd.setLodTiersFromFocusPoints([], [1, 3])).toBe(0);
+    expect(largeCrowd.getAgentLodTier(near.agentIndex)).toBe(0);
+    expect(largeCrowd.getAgentLodTier(added.agentIndex)).toBe(0);
+
+    largeCrowd.destroy();
+  });
+
+  test('agents between full updates stop at their target', () => {
+    const largeCrowd = new Crowd(navMesh, {
+      maxAgents: 10,
+      maxAgentRadius: 0.5,
+      gridCellSize: 1.5,
+    });
+
+    const agent = largeCrowd.addAgent({ x: -1, y: 0, z: -1 }, { radius: 0.2 });
+
+    expect(largeCrowd.setLodTier(1, { updateInterval: 1000 })).toBe(true);
+    expect(largeCrowd.setAgentLodTier(agent.agentIndex, 1)).toBe(true);
+
+    agent.requestMoveTarget({ x: 1, y: 0, z: 1 });
+
+    let maxX = -Infinity;
+    let maxZ = -Infinity;
+
+    for (let i = 0; i < 240; i++) {
+      largeCrowd.update(1 / 60);
+
+      maxX = Math.max(maxX, agent.position().x);
+      maxZ = Math.max(maxZ, agent.position().z);
+    }
+
+    expect(agent.position().x).toBeCloseTo(1, 1);
+    expect(agent.position().z).toBeCloseTo(1, 1);
+    expect(maxX).toBeLessThan(1.05);
+    expect(maxZ).toBeLessThan(1.05);
+
+    largeCrowd.destroy();
+  });
 });
@@ -0,0 +1,130 @@
+import {
+  Crowd,
+  Detour,
+  FlowField,
+  NavMesh,
+  NavMeshQuery,
+  init,
+} from 'recast-navigation';
+import { generateTiledNavMesh } from 'recast-navigation/generators';
+import { afterEach, beforeEach, describe, expect, test } from 'vitest';
+import { createTestLevel, expectVectorToBeCloseTo } from './utils';
+
+describe('FlowField', () => {
+  let navMesh: NavMesh;
+  let navMeshQuery: NavMeshQuery;
+  let flowField: FlowField;
+
+  const goal = { x: 10, y: 0, z: 10 };
+  const start = { x: -18, y: 0, z: -18 };
+
+  beforeEach(async () => {
+    await init();
+
+    const { positions, indices } = createTestLevel(40);
+
+    const result = generateTiledNavMesh(positions, indices, {
+      cs: 0.25,
+      ch: 0.2,
+      tileSize: 16,
+    });
+
+    if (!result.success) throw new Error('nav mesh generation failed');
+
+    navMesh = result.navMesh;
+    navMeshQuery = new NavMeshQuery(navMesh);
+    flowField = new FlowField(navMesh);
+  });
+
+  afterEach(() => {
+    flowField.destroy();
+    navMeshQuery.destroy();
+    navMesh.destroy();
+  });
+
+  test('follows parent links to the goal', () => {
+    const { success, goalRef, polyCount } = flowField.compute(goal);
+
+    expect(success).toBe(true);
+    expect(goalRef).not.toBe(0);
+    expect(polyCount).toBeGreaterThan(1);
+
+    expect(flowField.getCost(goalRef)).toBe(0);
+    expect(flowField.getParent(goalRef)).toBe(0);
+    expectVectorToBeCloseTo(flowField.getExitPoint(goalRef)!, goal, 0);
+
+    const startRef = navMeshQuery.findNearestPoly(start).nearestRef;
+    const path = flowField.getPath(startRef);
+
+    expect(path[0]).toBe(startRef);
+    expect(path[path.length - 1]).toBe(goalRef);
+
+    for (let i = 1; i < path.length; i++) {
+      expect(flowField.getParent(path[i - 1])).toBe(path[i]);
+      expect(flowField.getCost(path[i])).toBeLessThan(
+        flowField.getCost(path[i - 1]),
+      );
+    }
+
+    const { refs, parents, costs } = flowField.getPolys();
+    expect(refs.length).toBe(polyCount);
+    expect(parents[refs.indexOf(startRef)]).toBe(path[1]);
+    expect(costs[refs.indexOf(startRef)]).toBe(flowField.getCost(startRef));
+  });
+
+  test('bounds the field by cost', () => {
+    const { success, polyCount } = flowField.compute(goal, { maxCost: 5 });
+
+    expect(success).toBe(true);
+
+    const startRef = navMeshQuery.findNearestPoly(start).nearestRef;
+    expect(flowField.isReached(startRef)).toBe(false);
+    expect(flowField.getCost(startRef)).toBe(-1);
+    expect(flowField.getPath(startRef)).toEqual([]);
+
+    const { costs } = flowField.getPolys();
+    expect(costs.length).toBe(polyCount);
+    expect(Math.max(...costs)).toBeLessThanOrEqual(5);
+  });
+
+  test('bounds the field by poly count after a larger compute', () => {
+    const full = flowField.compute(goal);
+    expect(full.polyCount).toBeGreaterThan(16);
+
+    const { status, polyCount } = flowField.compute(goal, { maxPolys: 16 });
+
+    expect(status & Detour.DT_OUT_OF_NODES).toBeTruthy();
+    expect(polyCount).toBeLessThanOrEqual(16);
+  });
+
+  test('sets crowd agent corridors', () => {
+    const crowd = new Crowd(navMesh, { maxAgents: 10, maxAgentRadius: 0.5 });
+
+    const agents = [
+      crowd.addAgent({ x: -18, y: 0, z: -18 }, { radius: 0.4, maxSpeed: 6 }),
+      crowd.addAgent({ x: 18, y: 0, z: -10 }, { radius: 0.4, maxSpeed: 6 }),
+      crowd.addAgent({ x: -10, y: 0, z: 18 }, { radius: 0.4, maxSpeed: 6 }),
+    ];
+
+    crowd.update(1 / 60);
+
+    flowField.compute(goal);
+    expect(flowField.setCrowdAgentCorridors(crowd, agents)).toBe(3);
+
+    for (const agent of agents) {
+      expectVectorToBeCloseTo(agent.target(), goal, 0);
+    }
+
+    for (let i = 0; i < 60 * 20; i++) {
+      crowd.update(1 / 60);
+    }
+
+    for (const agent of agents) {
+      expect(
+        Math.hypot(agent.position().x - goal.x, agent.position().z - goal.z),
+      ).toBeLessThan(2);
+    }
+
+    crowd.destroy();
+  });
+});
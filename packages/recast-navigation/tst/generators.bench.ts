@@ -0,0 +1,43 @@
+import { init } from 'recast-navigation';
+import { generateTiledNavMesh } from 'recast-navigation/generators';
+import { beforeAll, bench, describe } from 'vitest';
+import { createTestLevel } from './utils';
+
+// RECAST_NAVIGATION_THREADS=1 yarn bench, to build tiles on worker threads
+const THREAD_COUNTS = [1, 2, 4, 8];
+
+const { positions, indices } = createTestLevel(200);
+
+const config = { cs: 0.2, ch: 0.2, tileSize: 32 };
+
+beforeAll(async () => {
+  if (process.env.RECAST_NAVIGATION_THREADS) {
+    const threads = await import('@recast-navigation/wasm/wasm-threads');
+    await init(threads.default);
+  } else {
+    await init();
+  }
+});
+
+const generate = (threads?: number) => {
+  const result = generateTiledNavMesh(positions, indices, {
+    ...config,
+    threads,
+  });
+
+  if (!result.success) throw new Error('nav mesh generation failed');
+
+  result.navMesh.destroy();
+};
+
+describe('generateTiledNavMesh', () => {
+  bench('per tile generator', () => {
+    generate();
+  });
+
+  for (const threads of THREAD_COUNTS) {
+    bench(`native generator, ${threads} threads`, () => {
+      generate(threads);
+    });
+  }
+});
@@ -0,0 +1,427 @@
+import {
+  type NavMesh,
+  Recast,
+  freeCompactHeightfield,
+  freeContourSet,
+  freeHeightfield,
+  freePolyMesh,
+  freePolyMeshDetail,
+  init,
+} from 'recast-navigation';
+import {
+  TiledNavMeshBuilder,
+  generateSoloNavMesh,
+  generateTiledNavMesh,
+} from 'recast-navigation/generators';
+import { BoxGeometry } from 'three';
+import { beforeAll, describe, expect, test } from 'vitest';
+import { createTestLevel } from './utils';
+
+const tilePolyCounts = (navMesh: NavMesh) => {
+  const counts: Record<string, number> = {};
+
+  for (let i = 0; i < navMesh.getMaxTiles(); i++) {
+    const header = navMesh.getTile(i).header();
+    if (!header) continue;
+
+    counts[`${header.x()},${header.y()}`] = header.polyCount();
+  }
+
+  return counts;
+};
+
+describe('generateSoloNavMesh', () => {
+  beforeAll(async () => {
+    await init();
+  });
+
+  test('generates a navmesh in one native call', () => {
+    const { positions, indices } = createTestLevel(10);
+
+    const result = generateSoloNavMesh(positions, indices, { cs: 0.2 });
+
+    expect(result.success).toBe(true);
+    if (!result.success) return;
+
+    expect(result.intermediates.heightfield).toBeUndefined();
+    expect(result.intermediates.polyMesh).toBeUndefined();
+
+    const tile = result.navMesh.getTile(0);
+    expect(tile.header()!.polyCount()).toBeGreaterThan(0);
+
+    // explicit bounds in place of the bounds of the indexed vertices
+    const bounds = generateSoloNavMesh(positions, indices, {
+      cs: 0.2,
+      bounds: [
+        [-5, -0.05, -5],
+        [5, 2, 5],
+      ],
+    });
+    expect(bounds.success).toBe(true);
+
+    result.navMesh.destroy();
+    bounds.navMesh?.destroy();
+  });
+
+  test('keeps intermediates', () => {
+    const { positions, indices } = createTestLevel(10);
+
+    const { success, navMesh, intermediates } = generateSoloNavMesh(
+      positions,
+      indices,
+      {},
+      true,
+    );
+
+    expect(success).toBe(true);
+
+    const {
+      heightfield,
+      compactHeightfield,
+      contourSet,
+      polyMesh,
+      polyMeshDetail,
+    } = intermediates;
+
+    expect(heightfield!.width()).toBeGreaterThan(0);
+    expect(compactHeightfield!.spanCount()).toBeGreaterThan(0);
+    expect(contourSet!.nconts()).toBeGreaterThan(0);
+    expect(polyMesh!.npolys()).toBeGreaterThan(0);
+    expect(polyMeshDetail!.nmeshes()).toBe(polyMesh!.npolys());
+
+    // walkable polys are given area 0 and flags 1
+    for (let i = 0; i < polyMesh!.npolys(); i++) {
+      expect(polyMesh!.areas(i)).not.toBe(Recast.RC_WALKABLE_AREA);
+    }
+
+    freeHeightfield(heightfield!);
+    freeCompactHeightfield(compactHeightfield!);
+    freeContourSet(contourSet!);
+    freePolyMesh(polyMesh!);
+    freePolyMeshDetail(polyMeshDetail!);
+    navMesh?.destroy();
+  });
+
+  test('reports the failed step', () => {
+    const result = generateSoloNavMesh([], []);
+
+    expect(result.success).toBe(false);
+    if (result.success) return;
+
+    expect(result.error).toBe('Could not create heightfield');
+  });
+});
+
+describe('generateTiledNavMesh', () => {
+  beforeAll(async () => {
+    await init();
+  });
+
+  test('native tiled generator matches the per tile generator', () => {
+    const { positions, indices } = createTestLevel(40);
+    const config = { cs: 0.2, ch: 0.2, tileSize: 32 };
+
+    const expected = generateTiledNavMesh(positions, indices, config);
+    const native = generateTiledNavMesh(positions, indices, {
+      ...config,
+      threads: 1,
+    });
+    const allThreads = generateTiledNavMesh(positions, indices, {
+      ...config,
+      threads: 0,
+    });
+
+    expect(expected.success).toBe(true);
+    expect(native.success).toBe(true);
+    expect(allThreads.success).toBe(true);
+    if (!expected.success || !native.success || !allThreads.success) return;
+
+    const expectedCounts = tilePolyCounts(expected.navMesh);
+    expect(Object.keys(expectedCounts).length).toBeGreaterThan(1);
+
+    expect(tilePolyCounts(native.navMesh)).toEqual(expectedCounts);
+    expect(tilePolyCounts(allThreads.navMesh)).toEqual(expectedCounts);
+
+    expected.navMesh.destroy();
+    native.navMesh.destroy();
+    allThreads.navMesh.destroy();
+  });
+
+  test('rasterizes tiles overlapping more than 512 chunks', () => {
+    const { positions, indices } = createTestLevel(40, 2);
+    const config = { cs: 0.2, ch: 0.2, tileSize: 128 };
+
+    const expected = generateTiledNavMesh(positions, indices, config);
+    const smallChunks = generateTiledNavMesh(positions, indices, {
+      ...config,
+      chunkyTriMeshTrisPerChunk: 1,
+    });
+
+    expect(expected.success).toBe(true);
+    expect(smallChunks.success).toBe(true);
+    if (!expected.success || !smallChunks.success) return;
+
+    expect(tilePolyCounts(smallChunks.navMesh)).toEqual(
+      tilePolyCounts(expected.navMesh),
+    );
+
+    expected.navMesh.destroy();
+    smallChunks.navMesh.destroy();
+  });
+});
+
+describe('TiledNavMeshBuilder', () => {
+  beforeAll(async () => {
+    await init();
+  });
+
+  const createBox = (x: number, z: number) => {
+    const box = new BoxGeometry(3, 2, 3);
+    box.translate(x, 1, z);
+
+    const positions = Array.from(box.getAttribute('position').array);
+    const indices = Array.from(box.getIndex()!.array);
+    const unindexed = Array.from(
+      box.toNonIndexed().getAttribute('position').array,
+    );
+
+    box.dispose();
+
+    return { positions, indices, unindexed };
+  };
+
+  test('rebuilds only the tiles touched by an edit', () => {
+    const level = createTestLevel(40);
+    const config = { cs: 0.2, ch: 0.2, tileSize: 32 };
+
+    const builder = new TiledNavMeshBuilder(
+      level.positions,
+      level.indices,
+      config,
+    );
+
+    const expected = generateTiledNavMesh(
+      level.positions,
+      level.indices,
+      config,
+    );
+    if (!expected.success) throw new Error('nav mesh generation failed');
+
+    const before = tilePolyCounts(builder.navMesh);
+    expect(before).toEqual(tilePolyCounts(expected.navMesh));
+
+    const tileCount = Object.keys(before).length;
+
+    // add a box
+    const box = createBox(2, 2);
+    const first = builder.addTriangles(box.positions, box.indices);
+    const boxTriangleCount = box.indices.length / 3;
+
+    expect(first).toBe(level.indices.length / 3);
+    expect(builder.triangleCount).toBe(first + boxTriangleCount);
+    expect(builder.dirtyTileCount).toBeGreaterThan(0);
+    expect(builder.dirtyTileCount).toBeLessThan(tileCount / 4);
+
+    builder.update();
+
+    expect(builder.dirtyTileCount).toBe(0);
+    expect(builder.failedTileCount).toBe(0);
+    expect(tilePolyCounts(builder.navMesh)).not.toEqual(before);
+
+    // move it, matching a full build with the box at its new position
+    const moved = createBox(-8, 2);
+    expect(builder.updateTriangles(first, moved.unindexed)).toBe(true);
+    builder.update();
+
+    const movedOffset = level.positions.length / 3;
+    const movedExpected = generateTiledNavMesh(
+      [...level.positions, ...moved.positions],
+      [...level.indices, ...moved.indices.map((i) => i + movedOffset)],
+      config,
+    );
+    if (!movedExpected.success) throw new Error('nav mesh generation failed');
+
+    expect(tilePolyCounts(builder.navMesh)).toEqual(
+      tilePolyCounts(movedExpected.navMesh),
+    );
+
+    // remove it
+    expect(builder.removeTriangles(first, boxTriangleCount)).toBe(true);
+    builder.update();
+
+    expect(tilePolyCounts(builder.navMesh)).toEqual(before);
+
+    // a dirty region rebuilds without changes
+    builder.markDirty([
+      [-1, 0, -1],
+      [1, 1, 1],
+    ]);
+    expect(builder.dirtyTileCount).toBeGreaterThan(0);
+    builder.update();
+    expect(tilePolyCounts(builder.navMesh)).toEqual(before);
+
+    builder.destroy();
+    builder.navMesh.destroy();
+    expected.navMesh.destroy();
+    movedExpected.navMesh.destroy();
+  });
+
+  test('caps the compact heightfield cache while building tiles', () => {
+    const level = createTestLevel(40);
+    const cacheSize = 32 * 1024;
+
+    const builder = new TiledNavMeshBuilder(level.positions, level.indices, {
+      cs: 0.2,
+      ch: 0.2,
+      tileSize: 32,
+      compactHeightfieldCacheSize: cacheSize,
+    });
+
+    const tileCount = Object.keys(tilePolyCounts(builder.navMesh)).length;
+
+    expect(builder.cachedTileCount).toBeGreaterThan(0);
+    expect(builder.cachedTileCount).toBeLessThan(tileCount);
+    expect(builder.compactHeightfieldCachePeakBytes).toBeLessThanOrEqual(
+      cacheSize,
+    );
+
+    // rebuild every tile
+    builder.markDirty([
+      [-20, -1, -20],
+      [20, 3, 20],
+    ]);
+    builder.update();
+
+    expect(builder.compactHeightfieldCachePeakBytes).toBeLessThanOrEqual(
+      cacheSize,
+    );
+    expect(builder.compactHeightfieldCacheBytes).toBeLessThanOrEqual(
+      cacheSize,
+    );
+
+    builder.navMesh.destroy();
+    builder.destroy();
+  });
+
+  test('evicts the least recently used cached tiles for edited tiles', () => {
+    const level = createTestLevel(40);
+
+    // 7 by 7 tiles of 6.4 units
+    const builder = new TiledNavMeshBuilder(level.positions, level.indices, {
+      cs: 0.2,
+      ch: 0.2,
+      tileSize: 32,
+      compactHeightfieldCacheSize: 32 * 1024,
+    });
+
+    // the first build caches tiles in tile order until the cache is full
+    expect(builder.isTileCached(0, 0)).toBe(true);
+    expect(builder.isTileCached(6, 6)).toBe(false);
+
+    builder.markDirty([
+      [14, -1, 14],
+      [20, 3, 20],
+    ]);
+    builder.update();
+
+    expect(builder.isTileCached(6, 6)).toBe(true);
+    expect(builder.isTileCached(0, 0)).toBe(false);
+    expect(builder.compactHeightfieldCachePeakBytes).toBeLessThanOrEqual(
+      32 * 1024,
+    );
+
+    builder.navMesh.destroy();
+    builder.destroy();
+  });
+
+  test('restarts area edits from cached compact heightfields', () => {
+    const level = createTestLevel(40);
+    const config = { cs: 0.2, ch: 0.2, tileSize: 32 };
+
+    const countAreaPolys = (navMesh: NavMesh, area: number) => {
+      let count = 0;
+
+      for (let i = 0; i < navMesh.getMaxTiles(); i++) {
+        const tile = navMesh.getTile(i);
+        const header = tile.header();
+        if (!header) continue;
+
+        for (let j = 0; j < header.polyCount(); j++) {
+          if ((tile.polys(j).areaAndType() & 0x3f) === area) count++;
+        }
+      }
+
+      return count;
+    };
+
+    const cached = new TiledNavMeshBuilder(level.positions, level.indices, {
+      ...config,
+      compactHeightfieldCacheSize: 64 * 1024 * 1024,
+    });
+    const uncached = new TiledNavMeshBuilder(
+      level.positions,
+      level.indices,
+      config,
+    );
+
+    const before = tilePolyCounts(cached.navMesh);
+
+    expect(cached.cachedTileCount).toBeGreaterThanOrEqual(
+      Object.keys(before).length,
+    );
+    expect(cached.compactHeightfieldCacheBytes).toBeGreaterThan(0);
+    expect(uncached.cachedTileCount).toBe(0);
+
+    // mark water, with and without the cache
+    const water = cached.addBoxArea(
+      [
+        [-6, -1, -6],
+        [6, 1, 6],
+      ],
+      1,
+    );
+    uncached.addBoxArea(
+      [
+        [-6, -1, -6],
+        [6, 1, 6],
+      ],
+      1,
+    );
+
+    expect(water).toBe(0);
+    expect(cached.dirtyTileCount).toBeGreaterThan(0);
+
+    cached.update();
+    uncached.update();
+
+    expect(countAreaPolys(cached.navMesh, 1)).toBeGreaterThan(0);
+    expect(tilePolyCounts(cached.navMesh)).toEqual(
+      tilePolyCounts(uncached.navMesh),
+    );
+
+    // cut a no-go cylinder out
+    const withWater = tilePolyCounts(cached.navMesh);
+    cached.addCylinderArea([10, -1, 10], 2, 3, Recast.RC_NULL_AREA);
+    cached.update();
+    expect(tilePolyCounts(cached.navMesh)).not.toEqual(withWater);
+
+    // removing the volumes restores the navmesh
+    expect(cached.removeArea(water)).toBe(true);
+    expect(cached.removeArea(1)).toBe(true);
+    expect(cached.removeArea(1)).toBe(false);
+    cached.update();
+
+    expect(countAreaPolys(cached.navMesh, 1)).toBe(0);
+    expect(tilePolyCounts(cached.navMesh)).toEqual(before);
+
+    // shrinking the cache evicts heightfields
+    cached.compactHeightfieldCacheSize = 1;
+    expect(cached.cachedTileCount).toBe(0);
+    expect(cached.compactHeightfieldCacheBytes).toBe(0);
+
+    cached.destroy();
+    cached.navMesh.destroy();
+    uncached.destroy();
+    uncached.navMesh.destroy();
+  });
+});
@@ -0,0 +1,228 @@
+import {
+  Detour,
+  NavMesh,
+  NavMeshPathCache,
+  NavMeshQuery,
+  init,
+} from 'recast-navigation';
+import {
+  generateTileCache,
+  generateTiledNavMesh,
+} from 'recast-navigation/generators';
+import { beforeEach, describe, expect, test } from 'vitest';
+import { createTestLevel } from './utils';
+
+describe('NavMeshPathCache', () => {
+  let navMesh: NavMesh;
+  let navMeshQuery: NavMeshQuery;
+  let pathCache: NavMeshPathCache;
+
+  const start = { x: -18, y: 0, z: -18 };
+  const end = { x: -10, y: 0, z: -18 };
+
+  const findPath = (maxPathPolys?: number) => {
+    const startRef = navMeshQuery.findNearestPoly(start).nearestRef;
+    const endRef = navMeshQuery.findNearestPoly(end).nearestRef;
+
+    const { success, status, polys } = navMeshQuery.findPath(
+      startRef,
+      endRef,
+      start,
+      end,
+      { maxPathPolys },
+    );
+
+    const refs = [...polys.getHeapView()];
+    polys.destroy();
+
+    return { success, status, refs };
+  };
+
+  beforeEach(async () => {
+    await init();
+
+    const { positions, indices } = createTestLevel(40);
+
+    const result = generateTiledNavMesh(positions, indices, {
+      cs: 0.25,
+      ch: 0.2,
+      tileSize: 16,
+    });
+
+    if (!result.success) throw new Error('nav mesh generation failed');
+
+    navMesh = result.navMesh;
+    navMeshQuery = new NavMeshQuery(navMesh);
+
+    pathCache = new NavMeshPathCache(navMesh);
+    navMeshQuery.setPathCache(pathCache);
+  });
+
+  test('returns cached paths for repeated queries', () => {
+    const first = findPath();
+    const second = findPath();
+
+    expect(first.success).toBe(true);
+    expect(second.refs).toEqual(first.refs);
+
+    const { hits, misses, entries, memoryBytes } = pathCache.stats;
+
+    expect(hits).toBe(1);
+    expect(misses).toBe(1);
+    expect(entries).toBe(1);
+    expect(memoryBytes).toBeGreaterThan(0);
+  });
+
+  test('changing the filter misses paths found with its earlier settings', () => {
+    findPath();
+
+    navMeshQuery.defaultFilter.setAreaCost(0, 2);
+    findPath();
+
+    expect(pathCache.stats.hits).toBe(0);
+    expect(pathCache.stats.misses).toBe(2);
+
+    // restoring the settings finds the earlier path
+    navMeshQuery.defaultFilter.setAreaCost(0, 1);
+    findPath();
+
+    expect(pathCache.stats.hits).toBe(1);
+  });
+
+  test('setting poly flags on the corridor invalidates the path', () => {
+    const { refs } = findPath();
+
+    const { flags } = navMesh.getPolyFlags(refs[0]);
+    navMesh.setPolyFlags(refs[0], flags);
+
+    findPath();
+
+    expect(pathCache.stats.invalidations).toBe(1);
+    expect(pathCache.stats.hits).toBe(0);
+  });
+
+  test('changes to tiles off the corridor keep the path', () => {
+    findPath();
+
+    const far = navMeshQuery.findNearestPoly({ x: 18, y: 0, z: 18 });
+    navMesh.setPolyArea(far.nearestRef, 0);
+
+    findPath();
+
+    expect(pathCache.stats.invalidations).toBe(0);
+    expect(pathCache.stats.hits).toBe(1);
+  });
+
+  test('removing a tile on the corridor invalidates the path', () => {
+    findPath();
+
+    const tileLoc = navMesh.calcTileLoc(start);
+    navMesh.removeTile(
+      navMesh.getTileRefAt(tileLoc.tileX(), tileLoc.tileY(), 0),
+    );
+
+    expect(pathCache.prune()).toBe(1);
+    expect(pathCache.stats.entries).toBe(0);
+  });
+
+  test('does not cache truncated paths', () => {
+    const full = findPath();
+    expect(full.refs.length).toBeGreaterThan(2);
+
+    pathCache.clear();
+
+    const truncated = findPath(2);
+    expect(truncated.status & Detour.DT_BUFFER_TOO_SMALL).toBeTruthy();
+    expect(truncated.refs.length).toBe(2);
+    expect(pathCache.stats.entries).toBe(0);
+
+    expect(findPath().refs).toEqual(full.refs);
+  });
+
+  test('does not cache partial paths', () => {
+    const full = findPath();
+    const endRef = full.refs[full.refs.length - 1];
+
+    pathCache.clear();
+
+    // the search cannot enter the end poly while it has no flags
+    const { flags } = navMesh.getPolyFlags(endRef);
+    navMesh.setPolyFlags(endRef, 0);
+
+    const partial = findPath();
+    expect(partial.status & Detour.DT_PARTIAL_RESULT).toBeTruthy();
+    expect(pathCache.stats.entries).toBe(0);
+
+    navMesh.setPolyFlags(endRef, flags);
+
+    expect(findPath().refs).toEqual(full.refs);
+  });
+
+  test('does not cache paths from searches out of nodes', () => {
+    const smallQuery = new NavMeshQuery(navMesh, { maxNodes: 4 });
+    smallQuery.setPathCache(pathCache);
+
+    const startRef = smallQuery.findNearestPoly(start).nearestRef;
+    const endRef = smallQuery.findNearestPoly(end).nearestRef;
+
+    const { status, polys } = smallQuery.findPath(startRef, endRef, start, end);
+    polys.destroy();
+
+    expect(status & Detour.DT_OUT_OF_NODES).toBeTruthy();
+    expect(pathCache.stats.entries).toBe(0);
+
+    smallQuery.destroy();
+  });
+
+  test('stops caching when the cache is unset', () => {
+    navMeshQuery.setPathCache(undefined);
+
+    findPath();
+    findPath();
+
+    expect(pathCache.stats.entries).toBe(0);
+
+    pathCache.destroy();
+  });
+});
+
+describe('NavMeshPathCache with TileCache', () => {
+  beforeEach(async () => {
+    await init();
+  });
+
+  test('tile cache updates on the corridor invalidate the path', () => {
+    const { positions, indices } = createTestLevel(40);
+
+    const result = generateTileCache(positions, indices, {
+      cs: 0.25,
+      ch: 0.2,
+      tileSize: 32,
+    });
+
+    if (!result.success) throw new Error('tile cache generation failed');
+
+    const { navMesh, tileCache } = result;
+
+    const navMeshQuery = new NavMeshQuery(navMesh);
+    const pathCache = new NavMeshPathCache(navMesh);
+    navMeshQuery.setPathCache(pathCache);
+
+    const start = { x: -18, y: 0, z: -18 };
+    const end = { x: -10, y: 0, z: -18 };
+
+    const startRef = navMeshQuery.findNearestPoly(start).nearestRef;
+    const endRef = navMeshQuery.findNearestPoly(end).nearestRef;
+
+    navMeshQuery.findPath(startRef, endRef, start, end).polys.destroy();
+
+    tileCache.addCylinderObstacle({ x: -14, y: 0, z: -18 }, 1, 1);
+
+    let upToDate = false;
+    while (!upToDate) {
+      upToDate = tileCache.update(navMesh).upToDate;
+    }
+
+    expect(pathCache.prune()).toBe(1);
+  });
+});
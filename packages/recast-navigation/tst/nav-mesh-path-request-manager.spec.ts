@@ -0,0 +1,151 @@
+import {
+  NavMesh,
+  NavMeshPathRequestManager,
+  NavMeshQuery,
+  PathRequestState,
+  init,
+} from 'recast-navigation';
+import { generateTiledNavMesh } from 'recast-navigation/generators';
+import { beforeEach, describe, expect, test } from 'vitest';
+import { createTestLevel } from './utils';
+
+describe('NavMeshPathRequestManager', () => {
+  let navMesh: NavMesh;
+  let navMeshQuery: NavMeshQuery;
+
+  const start = { x: -18, y: 0, z: -18 };
+  const end = { x: 18, y: 0, z: 18 };
+
+  beforeEach(async () => {
+    await init();
+
+    const { positions, indices } = createTestLevel(40);
+
+    const result = generateTiledNavMesh(positions, indices, {
+      cs: 0.25,
+      ch: 0.2,
+      tileSize: 16,
+    });
+
+    if (!result.success) throw new Error('nav mesh generation failed');
+
+    navMesh = result.navMesh;
+    navMeshQuery = new NavMeshQuery(navMesh);
+  });
+
+  test('sliced find path matches findPath', () => {
+    const startRef = navMeshQuery.findNearestPoly(start).nearestRef;
+    const endRef = navMeshQuery.findNearestPoly(end).nearestRef;
+
+    const expected = navMeshQuery.findPath(startRef, endRef, start, end);
+
+    expect(
+      navMeshQuery.initSlicedFindPath(startRef, endRef, start, end).success,
+    ).toBe(true);
+
+    let updates = 0;
+    while (navMeshQuery.updateSlicedFindPath(4).inProgress) {
+      updates++;
+    }
+
+    expect(updates).toBeGreaterThan(1);
+
+    const { success, polys } = navMeshQuery.finalizeSlicedFindPath();
+
+    expect(success).toBe(true);
+    expect([...polys.getHeapView()]).toEqual([
+      ...expected.polys.getHeapView(),
+    ]);
+
+    polys.destroy();
+    expected.polys.destroy();
+  });
+
+  test('advances requests within the iteration budget', () => {
+    const manager = new NavMeshPathRequestManager(navMesh, {
+      iterationsPerSlice: 4,
+    });
+
+    const startRef = navMeshQuery.findNearestPoly(start).nearestRef;
+    const endRef = navMeshQuery.findNearestPoly(end).nearestRef;
+
+    const handle = manager.request(startRef, endRef, start, end);
+
+    expect(handle).not.toBe(0);
+    expect(manager.getState(handle)).toBe(PathRequestState.QUEUED);
+
+    const first = manager.update({ maxIterations: 8 });
+
+    expect(first.iterations).toBeLessThanOrEqual(8);
+    expect(first.completed).toBe(0);
+    expect(manager.getState(handle)).toBe(PathRequestState.IN_PROGRESS);
+
+    while (manager.pendingCount > 0) {
+      manager.update({ maxIterations: 8 });
+    }
+
+    expect(manager.getState(handle)).toBe(PathRequestState.DONE);
+
+    const expected = navMeshQuery.findPath(startRef, endRef, start, end);
+    const { success, partial, polys } = manager.getPath(handle);
+
+    expect(success).toBe(true);
+    expect(partial).toBe(false);
+    expect(polys).toEqual([...expected.polys.getHeapView()]);
+
+    expected.polys.destroy();
+
+    manager.release(handle);
+
+    expect(manager.getState(handle)).toBe(PathRequestState.INVALID);
+
+    manager.destroy();
+  });
+
+  test('starts higher priority requests first', () => {
+    const manager = new NavMeshPathRequestManager(navMesh);
+
+    const startRef = navMeshQuery.findNearestPoly(start).nearestRef;
+    const endRef = navMeshQuery.findNearestPoly(end).nearestRef;
+
+    const low = manager.request(startRef, endRef, start, end, { priority: 0 });
+    const high = manager.request(endRef, startRef, end, start, {
+      priority: 1,
+    });
+
+    manager.update({ maxIterations: 1 });
+
+    expect(manager.getState(high)).toBe(PathRequestState.IN_PROGRESS);
+    expect(manager.getState(low)).toBe(PathRequestState.QUEUED);
+
+    manager.update();
+
+    expect(manager.getState(high)).toBe(PathRequestState.DONE);
+    expect(manager.getState(low)).toBe(PathRequestState.DONE);
+    expect(manager.pendingCount).toBe(0);
+
+    manager.destroy();
+  });
+
+  test('releasing a pending request cancels it', () => {
+    const manager = new NavMeshPathRequestManager(navMesh, { maxRequests: 1 });
+
+    const startRef = navMeshQuery.findNearestPoly(start).nearestRef;
+    const endRef = navMeshQuery.findNearestPoly(end).nearestRef;
+
+    const handle = manager.request(startRef, endRef, start, end);
+
+    expect(manager.request(startRef, endRef, start, end)).toBe(0);
+
+    manager.release(handle);
+
+    expect(manager.pendingCount).toBe(0);
+
+    const next = manager.request(startRef, endRef, start, end);
+
+    expect(next).not.toBe(0);
+    expect(next).not.toBe(handle);
+
+    manager.destroy();
+  });
+});
@@ -0,0 +1,53 @@
+import { NavMeshQuery, init } from 'recast-navigation';
+import { generateTiledNavMesh } from 'recast-navigation/generators';
+import { beforeAll, bench, describe } from 'vitest';
+import { createTestLevel } from './utils';
+
+const POINT_COUNT = 50000;
+
+describe('nearest poly snapping', () => {
+  let navMeshQuery: NavMeshQuery;
+  let points: Float32Array;
+
+  beforeAll(async () => {
+    await init();
+
+    const { positions, indices } = createTestLevel(200);
+
+    const result = generateTiledNavMesh(positions, indices, {
+      cs: 0.2,
+      ch: 0.2,
+      tileSize: 64,
+    });
+
+    if (!result.success) throw new Error('nav mesh generation failed');
+
+    navMeshQuery = new NavMeshQuery(result.navMesh);
+
+    // a random walk, so neighbouring points are spatially coherent
+    points = new Float32Array(POINT_COUNT * 3);
+    let x = 0;
+    let z = 0;
+    for (let i = 0; i < POINT_COUNT; i++) {
+      x = Math.max(-99, Math.min(99, x + (Math.random() - 0.5) * 0.5));
+      z = Math.max(-99, Math.min(99, z + (Math.random() - 0.5) * 0.5));
+      points[i * 3] = x;
+      points[i * 3 + 1] = 0.5;
+      points[i * 3 + 2] = z;
+    }
+  });
+
+  bench(`findClosestPoint x ${POINT_COUNT}`, () => {
+    for (let i = 0; i < POINT_COUNT; i++) {
+      navMeshQuery.findClosestPoint({
+        x: points[i * 3],
+        y: points[i * 3 + 1],
+        z: points[i * 3 + 2],
+      });
+    }
+  });
+
+  bench(`findNearestPolyBatch ${POINT_COUNT}`, () => {
+    navMeshQuery.findNearestPolyBatch(points);
+  });
+});
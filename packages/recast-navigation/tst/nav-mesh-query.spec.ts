@@ -1,4 +1,9 @@
-import { NavMesh, NavMeshQuery, init } from 'recast-navigation';
+import {
+  NavMesh,
+  NavMeshQuery,
+  init,
+  statusSucceed,
+} from 'recast-navigation';
 import { generateSoloNavMesh } from 'recast-navigation/generators';
 import { BoxGeometry, BufferAttribute, Mesh } from 'three';
 import { beforeEach, describe, test, expect } from 'vitest';
@@ -60,4 +65,132 @@ describe('NavMeshQuery', () => {
 
     expectVectorToBeCloseTo(path[path.length - 1], end, 0.01);
   });
+
+  test('computePath reuses its output between calls', () => {
+    const first = navMeshQuery.computePath(
+      { x: -2, y: 0, z: -2 },
+      { x: 2, y: 0, z: 2 },
+    );
+
+    const second = navMeshQuery.computePath(
+      { x: 2, y: 0, z: 2 },
+      { x: -2, y: 0, z: -2 },
+    );
+
+    expect(first.success).toBe(true);
+    expect(second.success).toBe(true);
+
+    expectVectorToBeCloseTo(
+      first.path[0],
+      second.path[second.path.length - 1],
+      0.01,
+    );
+    expectVectorToBeCloseTo(
+      second.path[0],
+      first.path[first.path.length - 1],
+      0.01,
+    );
+  });
+
+  test('computePath off the navmesh', () => {
+    const { success, error, path } = navMeshQuery.computePath(
+      { x: 100, y: 0, z: 100 },
+      { x: 2, y: 0, z: 2 },
+    );
+
+    expect(success).toBe(false);
+    expect(error?.name).toBe('findPath unsuccessful');
+    expect(path).toEqual([]);
+  });
+
+  test('findPathBatch', () => {
+    const { count, offsets, statuses, polys } = navMeshQuery.findPathBatch([
+      -2, 0, -2, 2, 0, 2,
+      // off the navmesh
+      100, 0, 100, 2, 0, 2,
+      2, 0, 2, -2, 0, -2,
+    ]);
+
+    expect(count).toBe(3);
+    expect(offsets.length).toBe(4);
+
+    expect(statusSucceed(statuses[0])).toBe(true);
+    expect(statusSucceed(statuses[1])).toBe(false);
+    expect(statusSucceed(statuses[2])).toBe(true);
+
+    const single = navMeshQuery.findPath(
+      navMeshQuery.findNearestPoly({ x: -2, y: 0, z: -2 }).nearestRef,
+      navMeshQuery.findNearestPoly({ x: 2, y: 0, z: 2 }).nearestRef,
+      { x: -2, y: 0, z: -2 },
+      { x: 2, y: 0, z: 2 },
+    );
+
+    expect([...polys.subarray(offsets[0], offsets[1])]).toEqual([
+      ...single.polys.getHeapView(),
+    ]);
+    expect(offsets[2] - offsets[1]).toBe(0);
+    expect(offsets[3] - offsets[2]).toBeGreaterThan(0);
+
+    single.polys.destroy();
+  });
+
+  test('findNearestPolyBatch', () => {
+    const points = [-2, 0.5, -2, -1.9, 0.5, -2, 2, 0, 2, 100, 0, 100];
+
+    const { count, nearestRefs, nearestPoints, isOverPoly } =
+      navMeshQuery.findNearestPolyBatch(points);
+
+    expect(count).toBe(4);
+
+    for (let i = 0; i < count; i++) {
+      const single = navMeshQuery.findNearestPoly({
+        x: points[i * 3],
+        y: points[i * 3 + 1],
+        z: points[i * 3 + 2],
+      });
+
+      expect(nearestRefs[i]).toBe(single.nearestRef);
+      expect(isOverPoly[i] === 1).toBe(single.isOverPoly);
+
+      if (single.nearestRef !== 0) {
+        expectVectorToBeCloseTo(
+          {
+            x: nearestPoints[i * 3],
+            y: nearestPoints[i * 3 + 1],
+            z: nearestPoints[i * 3 + 2],
+          },
+          single.nearestPoint,
+          3,
+        );
+      }
+    }
+
+    expect(nearestRefs[3]).toBe(0);
+  });
+
+  test('findNearestPolyBatch respects a query box below climb height', () => {
+    const floor = navMeshQuery.findNearestPoly({ x: 0, y: 0, z: 0 });
+    const y = floor.nearestPoint.y;
+
+    // the second point is over the first point's poly, within climb height but outside the query box
+    const points = [0, y, 0, 0.1, y + 0.38, 0];
+    const halfExtents = { x: 1, y: 0.05, z: 1 };
+
+    const { nearestRefs, isOverPoly } = navMeshQuery.findNearestPolyBatch(
+      points,
+      { halfExtents },
+    );
+
+    expect(nearestRefs[0]).not.toBe(0);
+
+    for (let i = 0; i < 2; i++) {
+      const single = navMeshQuery.findNearestPoly(
+        { x: points[i * 3], y: points[i * 3 + 1], z: points[i * 3 + 2] },
+        { halfExtents },
+      );
+
+      expect(nearestRefs[i]).toBe(single.nearestRef);
+      expect(isOverPoly[i] === 1).toBe(single.isOverPoly);
+    }
+  });
 });
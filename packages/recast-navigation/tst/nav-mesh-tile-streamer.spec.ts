@@ -0,0 +1,113 @@
+import {
+  NavMeshIndex,
+  NavMeshTileStreamer,
+  exportNavMeshIndexed,
+  init,
+} from 'recast-navigation';
+import { generateTiledNavMesh } from 'recast-navigation/generators';
+import { beforeEach, describe, expect, test } from 'vitest';
+import { createTestLevel } from './utils';
+
+describe('NavMeshTileStreamer', () => {
+  let data: Uint8Array;
+
+  beforeEach(async () => {
+    await init();
+
+    const { positions, indices } = createTestLevel(40);
+
+    const result = generateTiledNavMesh(positions, indices, {
+      cs: 0.25,
+      ch: 0.2,
+      tileSize: 16,
+    });
+
+    if (!result.success) throw new Error('nav mesh generation failed');
+
+    data = exportNavMeshIndexed(result.navMesh);
+
+    result.navMesh.destroy();
+  });
+
+  test('loads tiles around focus points and evicts distant tiles', () => {
+    const index = new NavMeshIndex(data);
+    const navMesh = index.createNavMesh();
+
+    const streamer = new NavMeshTileStreamer(navMesh, index);
+
+    streamer.setFocus([{ position: { x: -18, y: 0, z: -18 }, radius: 2 }]);
+
+    const first = streamer.update();
+    expect(first.loaded).toBeGreaterThan(0);
+    expect(first.loaded).toBeLessThan(index.tileCount);
+    expect(first.pending).toBe(0);
+
+    const loadedTiles: number[] = [];
+    for (let i = 0; i < index.tileCount; i++) {
+      if (streamer.isTileResident(i)) {
+        loadedTiles.push(i);
+        const tile = index.getTile(i);
+        expect(navMesh.getTileRefAt(tile.tileX, tile.tileY, tile.layer)).toBe(
+          tile.tileRef,
+        );
+      }
+    }
+
+    streamer.setFocus([{ position: { x: 18, y: 0, z: 18 }, radius: 2 }]);
+
+    const second = streamer.update({ maxBytes: 1 });
+    expect(second.evicted).toBe(loadedTiles.length);
+    expect(second.loaded).toBe(1);
+
+    for (const i of loadedTiles) {
+      expect(streamer.isTileResident(i)).toBe(false);
+    }
+
+    streamer.unloadAll();
+    expect(streamer.residentTileCount).toBe(0);
+
+    streamer.destroy();
+    index.destroy();
+    navMesh.destroy();
+  });
+
+  test('does not retry tiles that failed to load until reset', () => {
+    const index = new NavMeshIndex(data);
+    const navMesh = index.createNavMesh();
+
+    const focus = { x: -18, y: 0, z: -18 };
+
+    // corrupted payloads fail their checksum
+    let loads = 0;
+    const streamer = new NavMeshTileStreamer(navMesh, index, {
+      loader: (tile) => {
+        loads++;
+        const payload = data.slice(tile.offset, tile.offset + tile.dataSize);
+        payload[0] ^= 0xff;
+        return payload;
+      },
+    });
+
+    streamer.setFocus([{ position: focus, radius: 2 }]);
+
+    const first = streamer.update();
+    expect(first.loaded).toBe(0);
+    expect(first.failed).toBeGreaterThan(0);
+    expect(first.pending).toBe(0);
+    expect(loads).toBe(first.failed);
+    expect(streamer.failedTileCount).toBe(first.failed);
+
+    const second = streamer.update();
+    expect(second.failed).toBe(0);
+    expect(loads).toBe(first.failed);
+
+    // reset tiles are loaded again
+    streamer.resetFailedTiles();
+    expect(streamer.failedTileCount).toBe(0);
+    expect(streamer.update().failed).toBe(first.failed);
+
+    streamer.destroy();
+    index.destroy();
+    navMesh.destroy();
+  });
+});
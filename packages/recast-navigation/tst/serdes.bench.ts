@@ -0,0 +1,45 @@
+import { NavMesh, exportNavMesh, importNavMesh, init } from 'recast-navigation';
+import { generateTiledNavMesh } from 'recast-navigation/generators';
+import { beforeAll, bench, describe } from 'vitest';
+import { createTestLevel } from './utils';
+
+describe('serdes', () => {
+  let navMesh: NavMesh;
+  let data: Uint8Array;
+  let compressed: Uint8Array;
+
+  beforeAll(async () => {
+    await init();
+
+    const { positions, indices } = createTestLevel(200);
+
+    const result = generateTiledNavMesh(positions, indices, {
+      cs: 0.2,
+      ch: 0.2,
+      tileSize: 64,
+    });
+
+    if (!result.success) throw new Error('nav mesh generation failed');
+
+    navMesh = result.navMesh;
+
+    data = exportNavMesh(navMesh);
+    compressed = exportNavMesh(navMesh, { compress: true });
+  });
+
+  bench('export raw', () => {
+    exportNavMesh(navMesh);
+  });
+
+  bench('export fastlz', () => {
+    exportNavMesh(navMesh, { compress: true });
+  });
+
+  bench('import raw', () => {
+    importNavMesh(data).navMesh.destroy();
+  });
+
+  bench('import fastlz', () => {
+    importNavMesh(compressed).navMesh.destroy();
+  });
+});
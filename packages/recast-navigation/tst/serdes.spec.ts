@@ -0,0 +1,190 @@
+import {
+  NavMesh,
+  NavMeshIndex,
+  NavMeshQuery,
+  Raw,
+  exportNavMesh,
+  exportNavMeshIndexed,
+  exportNavMeshStream,
+  importNavMesh,
+  init,
+} from 'recast-navigation';
+import { generateSoloNavMesh } from 'recast-navigation/generators';
+import { BoxGeometry, BufferAttribute, Mesh } from 'three';
+import { beforeEach, describe, expect, test } from 'vitest';
+
+describe('Serdes', () => {
+  let navMesh: NavMesh;
+
+  beforeEach(async () => {
+    await init();
+
+    const mesh = new Mesh(new BoxGeometry(5, 0.1, 5));
+
+    const positions = (
+      mesh.geometry.getAttribute('position') as BufferAttribute
+    ).array;
+    const indices = mesh.geometry.getIndex()!.array;
+
+    const result = generateSoloNavMesh(positions, indices);
+
+    if (!result.success) throw new Error('nav mesh generation failed');
+
+    navMesh = result.navMesh;
+  });
+
+  test('export and import', () => {
+    const data = exportNavMesh(navMesh);
+
+    const { navMesh: imported } = importNavMesh(data);
+
+    expect(imported.getMaxTiles()).toBe(navMesh.getMaxTiles());
+    expect(exportNavMesh(imported)).toEqual(data);
+  });
+
+  test('compressed export and import', () => {
+    const data = exportNavMesh(navMesh);
+    const compressed = exportNavMesh(navMesh, { compress: true });
+
+    expect(compressed.length).toBeLessThan(data.length);
+
+    const { navMesh: imported } = importNavMesh(compressed);
+
+    expect(exportNavMesh(imported)).toEqual(data);
+  });
+
+  test('compressed imports fail on truncated data', () => {
+    const compressed = exportNavMesh(navMesh, { compress: true });
+
+    for (const size of [8, 40, compressed.length - 1]) {
+      const navMeshExport = new Raw.Module.NavMeshExport();
+      navMeshExport.dataPointer = Raw.Module._malloc(size);
+      navMeshExport.size = size;
+      Raw.Module.HEAPU8.set(
+        compressed.subarray(0, size),
+        navMeshExport.dataPointer,
+      );
+
+      const result = Raw.NavMeshImporter.importNavMesh(
+        navMeshExport,
+        undefined!,
+      );
+      expect(result.success).toBe(false);
+
+      Raw.NavMeshExporter.freeNavMeshExport(navMeshExport);
+      Raw.destroy(navMeshExport);
+    }
+  });
+
+  test('compressed export with a caller codec', () => {
+    const compressor = new Raw.Module.RecastFastLZCompressor();
+
+    const navMeshExport = Raw.NavMeshExporter.exportNavMeshCompressed(
+      navMesh.raw,
+      compressor,
+    );
+
+    // custom codec exports are only imported with the codec
+    expect(
+      Raw.NavMeshImporter.importNavMesh(navMeshExport, undefined!).success,
+    ).toBe(false);
+
+    const result = Raw.NavMeshImporter.importNavMesh(
+      navMeshExport,
+      undefined!,
+      compressor,
+    );
+    expect(result.success).toBe(true);
+
+    const imported = new NavMesh(result.navMesh);
+    expect(exportNavMesh(imported)).toEqual(exportNavMesh(navMesh));
+
+    imported.destroy();
+    Raw.NavMeshExporter.freeNavMeshExport(navMeshExport);
+    Raw.destroy(compressor);
+  });
+
+  test('imported navmesh can be queried and destroyed', () => {
+    const { navMesh: imported } = importNavMesh(exportNavMesh(navMesh));
+
+    const navMeshQuery = new NavMeshQuery(imported);
+
+    const { success, point } = navMeshQuery.findClosestPoint({
+      x: 2,
+      y: 1,
+      z: 2,
+    });
+
+    expect(success).toBe(true);
+    expect(point.x).toBeCloseTo(2);
+    expect(point.z).toBeCloseTo(2);
+
+    navMeshQuery.destroy();
+    imported.destroy();
+  });
+
+  test('streaming export matches exportNavMesh', () => {
+    const data = exportNavMesh(navMesh);
+
+    const chunks: Uint8Array[] = [];
+
+    const size = exportNavMeshStream(
+      navMesh,
+      (chunk) => {
+        expect(chunk.length).toBeLessThanOrEqual(64);
+        chunks.push(chunk.slice());
+      },
+      { chunkSize: 64 },
+    );
+
+    expect(size).toBe(data.length);
+
+    const streamed = new Uint8Array(size);
+    let offset = 0;
+    for (const chunk of chunks) {
+      streamed.set(chunk, offset);
+      offset += chunk.length;
+    }
+
+    expect(streamed).toEqual(data);
+  });
+
+  test('indexed export random-access tile loading', () => {
+    const data = exportNavMeshIndexed(navMesh);
+
+    const directorySize = NavMeshIndex.getDirectorySize(data.subarray(0, 64));
+    expect(directorySize).toBeGreaterThan(0);
+    expect(directorySize).toBeLessThan(data.length);
+
+    const index = new NavMeshIndex(data);
+    expect(index.tileCount).toBe(1);
+    expect(index.findTile(1, 1)).toBe(-1);
+
+    const tileIndex = index.findTile(0, 0);
+    expect(tileIndex).toBe(0);
+
+    const tile = index.getTile(tileIndex);
+    expect(tile.offset % 16).toBe(0);
+
+    expect(index.getTile(-1).dataSize).toBe(0);
+    expect(index.getTile(index.tileCount).dataSize).toBe(0);
+
+    const loaded = index.createNavMesh();
+
+    const corrupted = data.slice(tile.offset, tile.offset + tile.dataSize);
+    corrupted[0] ^= 0xff;
+    expect(index.loadTileData(loaded, tileIndex, corrupted).success).toBe(false);
+
+    expect(index.loadTile(loaded, tileIndex).success).toBe(true);
+    expect(loaded.getTileRefAt(0, 0, 0)).toBe(tile.tileRef);
+
+    // a tile count whose directory size overflows is rejected
+    const overflowing = data.slice();
+    new DataView(overflowing.buffer).setInt32(8, 0x10000000, true);
+    expect(NavMeshIndex.getDirectorySize(overflowing)).toBe(0);
+    expect(() => new NavMeshIndex(overflowing)).toThrow();
+
+    index.destroy();
+    loaded.destroy();
+  });
+});
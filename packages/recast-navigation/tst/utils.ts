@@ -1,3 +1,4 @@
+import { BoxGeometry, BufferAttribute } from 'three';
 import { expect } from 'vitest';
 import { Vector3 } from '@recast-navigation/core/src';
 
@@ -10,3 +11,37 @@ export const expectVectorToBeCloseTo = (
   expect(expected.y).toBeCloseTo(actual.y, numDigits);
   expect(expected.z).toBeCloseTo(actual.z, numDigits);
 };
+
+/**
+ * Creates a square ground plane with a grid of box obstacles, for tiled generation and benchmarks.
+ */
+export const createTestLevel = (size: number, obstacleSpacing = 4) => {
+  const geometries = [new BoxGeometry(size, 0.1, size)];
+
+  const half = size / 2;
+  for (let x = -half + obstacleSpacing; x < half; x += obstacleSpacing) {
+    for (let z = -half + obstacleSpacing; z < half; z += obstacleSpacing) {
+      const box = new BoxGeometry(1, 2, 1);
+      box.translate(x, 1, z);
+      geometries.push(box);
+    }
+  }
+
+  const positions: number[] = [];
+  const indices: number[] = [];
+
+  for (const geometry of geometries) {
+    const offset = positions.length / 3;
+
+    const position = geometry.getAttribute('position') as BufferAttribute;
+    positions.push(...(position.array as Float32Array));
+
+    for (const index of geometry.getIndex()!.array) {
+      indices.push(offset + index);
+    }
+
+    geometry.dispose();
+  }
+
+  return { positions, indices };
+};